@@ -0,0 +1,498 @@
+// Queue throughput and inter-thread latency benchmark.
+//
+// Measures every queue implementation we ship across SPSC/MPSC/MPMC
+// topologies and several payload sizes, with every thread pinned to a core.
+// Results go to stdout (or --out) as CSV or JSON lines so they can be
+// compared across hosts when picking the queue for a given link.
+//
+//   bench_queues [--queues lockfree,spsc,mpmc] [--topologies spsc,mpsc,mpmc]
+//                [--payloads 8,64,256,order] [--pairs 0:1,0:16] [--cores 0,1,2,3]
+//                [--producers N] [--consumers N] [--messages N]
+//                [--samples N] [--capacity N] [--format csv|json] [--out FILE]
+//
+// --pairs gives producer:consumer cores for the SPSC throughput and round-trip
+// runs; when omitted we use (0,1) plus one pair that crosses sockets if the
+// host has more than one. --cores is the pool used round-robin by the
+// multi-producer/multi-consumer topologies.
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LockFreeQueue.h"
+#include "MpmcQueue.h"
+#include "Order.h"
+#include "SpscQueue.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template <size_t N>
+struct Payload {
+    static_assert(N >= sizeof(uint64_t));
+    uint64_t seq;
+    char pad[N - sizeof(uint64_t)];
+    explicit Payload(uint64_t s = 0) : seq(s) {}
+};
+
+// Uniform push/pop over the three queue flavours. Bounded queues spin on full.
+template <typename Q, typename T>
+inline void push(Q& q, const T& val) {
+    if constexpr (requires { q.try_push(val); }) {
+        while (!q.try_push(val)) std::this_thread::yield();
+    } else {
+        q.push_back(val);
+    }
+}
+
+// Queue factories
+template <typename T>
+struct LockFreeKind {
+    static constexpr const char* name = "lockfree";
+    using Queue = LockFreeQueue<T>;
+    static std::unique_ptr<Queue> make(size_t) { return std::make_unique<Queue>(); }
+    // pop() frees the old head while other consumers, and producers reading
+    // a lagging tail->next, may still use it: only safe one-to-one
+    static bool supports(const std::string& topology) { return topology == "spsc"; }
+};
+
+template <typename T>
+struct SpscKind {
+    static constexpr const char* name = "spsc";
+    using Queue = SpscQueue<T>;
+    static std::unique_ptr<Queue> make(size_t cap) { return std::make_unique<Queue>(cap); }
+    static bool supports(const std::string& topology) { return topology == "spsc"; }
+};
+
+template <typename T>
+struct MpmcKind {
+    static constexpr const char* name = "mpmc";
+    using Queue = MpmcQueue<T>;
+    static std::unique_ptr<Queue> make(size_t cap) { return std::make_unique<Queue>(cap); }
+    static bool supports(const std::string&) { return true; }
+};
+
+struct Options {
+    std::vector<std::string> queues{"lockfree", "spsc", "mpmc"};
+    std::vector<std::string> topologies{"spsc", "mpsc", "mpmc"};
+    std::vector<std::string> payloads{"8", "64", "256", "order"};
+    std::vector<std::pair<int, int>> pairs;
+    std::vector<int> cores;
+    size_t producers{2};
+    size_t consumers{2};
+    size_t messages{1'000'000};
+    size_t samples{100'000};
+    size_t capacity{1u << 16};
+    std::string format{"csv"};
+    std::string out;
+};
+
+struct Result {
+    std::string bench;
+    std::string queue;
+    std::string topology;
+    std::string payload;
+    size_t payload_bytes{0};
+    size_t producers{0};
+    size_t consumers{0};
+    std::string producer_cores;
+    std::string consumer_cores;
+    bool cross_socket{false};
+    size_t messages{0};
+    double seconds{0};
+    double mops{0};
+    double ns_per_op{0};
+    uint64_t p50_ns{0}, p90_ns{0}, p99_ns{0}, p999_ns{0}, max_ns{0};
+};
+
+std::vector<std::string> split(const std::string& s, char sep) {
+    std::vector<std::string> parts;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, sep)) {
+        if (!item.empty()) parts.push_back(item);
+    }
+    return parts;
+}
+
+int socket_of(int cpu) {
+    std::ifstream f("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/physical_package_id");
+    int id = 0;
+    if (!(f >> id)) return 0;
+    return id;
+}
+
+void pin_to(int cpu) {
+    if (cpu < 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+        std::cerr << "warning: failed to pin thread to cpu " << cpu << std::endl;
+    }
+}
+
+std::vector<std::pair<int, int>> default_pairs() {
+    int ncpu = static_cast<int>(std::thread::hardware_concurrency());
+    std::vector<std::pair<int, int>> pairs{{0, ncpu > 1 ? 1 : 0}};
+    for (int cpu = 1; cpu < ncpu; ++cpu) {
+        if (socket_of(cpu) != socket_of(0)) {
+            pairs.emplace_back(0, cpu);
+            break;
+        }
+    }
+    return pairs;
+}
+
+std::string join_cores(const std::vector<int>& cores) {
+    std::string s;
+    for (size_t i = 0; i < cores.size(); ++i) {
+        if (i) s += ' ';
+        s += std::to_string(cores[i]);
+    }
+    return s;
+}
+
+// Start barrier: workers arrive and spin until the coordinating thread has
+// seen all of them and taken the start timestamp
+class StartGate {
+   public:
+    explicit StartGate(size_t workers) : workers_(workers) {}
+
+    void arrive_and_wait() {
+        arrived_.fetch_add(1, std::memory_order_acq_rel);
+        while (!go_.load(std::memory_order_acquire)) std::this_thread::yield();
+    }
+
+    Clock::time_point release() {
+        while (arrived_.load(std::memory_order_acquire) != workers_) std::this_thread::yield();
+        auto start = Clock::now();
+        go_.store(true, std::memory_order_release);
+        return start;
+    }
+
+   private:
+    size_t workers_;
+    std::atomic<size_t> arrived_{0};
+    std::atomic<bool> go_{false};
+};
+
+template <template <typename> class Kind, typename T>
+Result run_throughput(const Options& opt, const std::string& topology, const T& sample,
+                      const std::vector<int>& pcores, const std::vector<int>& ccores) {
+    using K = Kind<T>;
+    auto queue = K::make(opt.capacity);
+    auto& q = *queue;
+
+    const size_t np = pcores.size();
+    const size_t nc = ccores.size();
+    const size_t per_producer = opt.messages / np;
+    const size_t total = per_producer * np;
+
+    std::atomic<size_t> consumed{0};
+    StartGate gate(np + nc);
+    std::vector<std::thread> threads;
+    threads.reserve(np + nc);
+
+    for (size_t i = 0; i < np; ++i) {
+        threads.emplace_back([&, core = pcores[i]] {
+            pin_to(core);
+            gate.arrive_and_wait();
+            for (size_t j = 0; j < per_producer; ++j) push(q, sample);
+        });
+    }
+    for (size_t i = 0; i < nc; ++i) {
+        threads.emplace_back([&, core = ccores[i]] {
+            pin_to(core);
+            gate.arrive_and_wait();
+            while (consumed.load(std::memory_order_relaxed) < total) {
+                if (q.pop()) {
+                    consumed.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    auto start = gate.release();
+    for (auto& t : threads) t.join();
+    auto end = Clock::now();
+
+    Result r;
+    r.bench = "throughput";
+    r.queue = K::name;
+    r.topology = topology;
+    r.payload_bytes = sizeof(T);
+    r.producers = np;
+    r.consumers = nc;
+    r.producer_cores = join_cores(pcores);
+    r.consumer_cores = join_cores(ccores);
+    for (int p : pcores) {
+        for (int c : ccores) r.cross_socket |= socket_of(p) != socket_of(c);
+    }
+    r.messages = total;
+    r.seconds = std::chrono::duration<double>(end - start).count();
+    r.mops = total / r.seconds / 1e6;
+    r.ns_per_op = r.seconds * 1e9 / total;
+    return r;
+}
+
+// Ping-pong over two queues of the same kind; one sample is one round trip
+template <template <typename> class Kind, typename T>
+Result run_round_trip(const Options& opt, const T& sample, int pcore, int ccore) {
+    using K = Kind<T>;
+    auto ping = K::make(opt.capacity);
+    auto pong = K::make(opt.capacity);
+    const size_t warmup = std::min<size_t>(opt.samples / 10, 10'000);
+    std::vector<uint64_t> rtt;
+    rtt.reserve(opt.samples);
+
+    // Pure spinning only makes sense when each side owns its core
+    const bool shared_core = pcore == ccore;
+
+    StartGate gate(1);
+    std::thread echo([&] {
+        pin_to(ccore);
+        gate.arrive_and_wait();
+        for (size_t i = 0; i < warmup + opt.samples; ++i) {
+            std::optional<T> v;
+            while (!(v = ping->pop())) {
+                if (shared_core) std::this_thread::yield();
+            }
+            push(*pong, *v);
+        }
+    });
+
+    pin_to(pcore);
+    gate.release();
+    for (size_t i = 0; i < warmup + opt.samples; ++i) {
+        auto t0 = Clock::now();
+        push(*ping, sample);
+        while (!pong->pop()) {
+            if (shared_core) std::this_thread::yield();
+        }
+        auto t1 = Clock::now();
+        if (i >= warmup) {
+            rtt.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+        }
+    }
+    echo.join();
+
+    std::sort(rtt.begin(), rtt.end());
+    auto pct = [&](double p) { return rtt[std::min(rtt.size() - 1, static_cast<size_t>(p * rtt.size()))]; };
+
+    Result r;
+    r.bench = "round_trip";
+    r.queue = K::name;
+    r.topology = "spsc";
+    r.payload_bytes = sizeof(T);
+    r.producers = 1;
+    r.consumers = 1;
+    r.producer_cores = std::to_string(pcore);
+    r.consumer_cores = std::to_string(ccore);
+    r.cross_socket = socket_of(pcore) != socket_of(ccore);
+    r.messages = rtt.size();
+    for (auto v : rtt) r.seconds += v;
+    r.seconds /= 1e9;
+    r.ns_per_op = r.seconds * 1e9 / rtt.size();
+    r.mops = rtt.size() / r.seconds / 1e6;
+    r.p50_ns = pct(0.50);
+    r.p90_ns = pct(0.90);
+    r.p99_ns = pct(0.99);
+    r.p999_ns = pct(0.999);
+    r.max_ns = rtt.back();
+    return r;
+}
+
+class Reporter {
+   public:
+    Reporter(const std::string& format, std::ostream& os) : format_(format), os_(os) {
+        if (format_ == "csv") {
+            os_ << "bench,queue,topology,payload,payload_bytes,producers,consumers,producer_cores,"
+                   "consumer_cores,cross_socket,messages,seconds,mops,ns_per_op,p50_ns,p90_ns,"
+                   "p99_ns,p999_ns,max_ns\n";
+        }
+    }
+
+    void write(const Result& r) {
+        if (format_ == "json") {
+            os_ << "{\"bench\":\"" << r.bench << "\",\"queue\":\"" << r.queue << "\",\"topology\":\""
+                << r.topology << "\",\"payload\":\"" << r.payload << "\",\"payload_bytes\":" << r.payload_bytes
+                << ",\"producers\":" << r.producers << ",\"consumers\":" << r.consumers
+                << ",\"producer_cores\":\"" << r.producer_cores << "\",\"consumer_cores\":\""
+                << r.consumer_cores << "\",\"cross_socket\":" << (r.cross_socket ? "true" : "false")
+                << ",\"messages\":" << r.messages << ",\"seconds\":" << r.seconds << ",\"mops\":" << r.mops
+                << ",\"ns_per_op\":" << r.ns_per_op << ",\"p50_ns\":" << r.p50_ns << ",\"p90_ns\":" << r.p90_ns
+                << ",\"p99_ns\":" << r.p99_ns << ",\"p999_ns\":" << r.p999_ns << ",\"max_ns\":" << r.max_ns
+                << "}\n";
+        } else {
+            os_ << r.bench << ',' << r.queue << ',' << r.topology << ',' << r.payload << ',' << r.payload_bytes
+                << ',' << r.producers << ',' << r.consumers << ',' << r.producer_cores << ','
+                << r.consumer_cores << ',' << (r.cross_socket ? 1 : 0) << ',' << r.messages << ','
+                << r.seconds << ',' << r.mops << ',' << r.ns_per_op << ',' << r.p50_ns << ',' << r.p90_ns
+                << ',' << r.p99_ns << ',' << r.p999_ns << ',' << r.max_ns << '\n';
+        }
+        os_.flush();
+    }
+
+   private:
+    std::string format_;
+    std::ostream& os_;
+};
+
+bool wanted(const std::vector<std::string>& list, const std::string& name) {
+    return std::find(list.begin(), list.end(), name) != list.end();
+}
+
+template <template <typename> class Kind, typename T>
+void run_queue(const Options& opt, const std::string& payload, const T& sample, Reporter& out) {
+    using K = Kind<T>;
+    if (!wanted(opt.queues, K::name)) return;
+
+    for (const auto& topology : opt.topologies) {
+        if (!K::supports(topology)) continue;
+        if (topology == "spsc") {
+            for (auto [p, c] : opt.pairs) {
+                auto r = run_throughput<Kind>(opt, topology, sample, {p}, {c});
+                r.payload = payload;
+                out.write(r);
+            }
+            continue;
+        }
+        // Multi-threaded topologies draw cores round-robin from the pool
+        size_t np = opt.producers;
+        size_t nc = topology == "mpsc" ? 1 : opt.consumers;
+        std::vector<int> pcores, ccores;
+        for (size_t i = 0; i < np; ++i) pcores.push_back(opt.cores[i % opt.cores.size()]);
+        for (size_t i = 0; i < nc; ++i) ccores.push_back(opt.cores[(np + i) % opt.cores.size()]);
+        auto r = run_throughput<Kind>(opt, topology, sample, pcores, ccores);
+        r.payload = payload;
+        out.write(r);
+    }
+
+    for (auto [p, c] : opt.pairs) {
+        auto r = run_round_trip<Kind>(opt, sample, p, c);
+        r.payload = payload;
+        out.write(r);
+    }
+}
+
+template <typename T>
+void run_payload(const Options& opt, const std::string& payload, const T& sample, Reporter& out) {
+    run_queue<LockFreeKind>(opt, payload, sample, out);
+    run_queue<SpscKind>(opt, payload, sample, out);
+    run_queue<MpmcKind>(opt, payload, sample, out);
+}
+
+void usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0
+              << " [--queues lockfree,spsc,mpmc] [--topologies spsc,mpsc,mpmc]"
+                 " [--payloads 8,64,256,order] [--pairs P:C,...] [--cores C,...]"
+                 " [--producers N] [--consumers N] [--messages N] [--samples N]"
+                 " [--capacity N] [--format csv|json] [--out FILE]"
+              << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            usage(argv[0]);
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 1;
+        }
+        std::string val = argv[++i];
+        if (arg == "--queues") {
+            opt.queues = split(val, ',');
+        } else if (arg == "--topologies") {
+            opt.topologies = split(val, ',');
+        } else if (arg == "--payloads") {
+            opt.payloads = split(val, ',');
+        } else if (arg == "--pairs") {
+            for (const auto& p : split(val, ',')) {
+                auto parts = split(p, ':');
+                if (parts.size() != 2) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                opt.pairs.emplace_back(std::stoi(parts[0]), std::stoi(parts[1]));
+            }
+        } else if (arg == "--cores") {
+            for (const auto& c : split(val, ',')) opt.cores.push_back(std::stoi(c));
+        } else if (arg == "--producers") {
+            opt.producers = std::stoul(val);
+        } else if (arg == "--consumers") {
+            opt.consumers = std::stoul(val);
+        } else if (arg == "--messages") {
+            opt.messages = std::stoul(val);
+        } else if (arg == "--samples") {
+            opt.samples = std::stoul(val);
+        } else if (arg == "--capacity") {
+            opt.capacity = std::stoul(val);
+        } else if (arg == "--format") {
+            opt.format = val;
+        } else if (arg == "--out") {
+            opt.out = val;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (opt.pairs.empty()) opt.pairs = default_pairs();
+    if (opt.cores.empty()) {
+        int ncpu = static_cast<int>(std::thread::hardware_concurrency());
+        for (int cpu = 0; cpu < std::max(ncpu, 1); ++cpu) opt.cores.push_back(cpu);
+    }
+    if (opt.producers == 0 || opt.consumers == 0 || opt.messages == 0 || opt.samples == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::ofstream file;
+    if (!opt.out.empty()) {
+        file.open(opt.out);
+        if (!file) {
+            std::cerr << "Failed to open " << opt.out << std::endl;
+            return 1;
+        }
+    }
+    Reporter out(opt.format, opt.out.empty() ? std::cout : file);
+
+    for (const auto& payload : opt.payloads) {
+        if (payload == "8") {
+            run_payload(opt, payload, Payload<8>{}, out);
+        } else if (payload == "64") {
+            run_payload(opt, payload, Payload<64>{}, out);
+        } else if (payload == "256") {
+            run_payload(opt, payload, Payload<256>{}, out);
+        } else if (payload == "order") {
+            run_payload(opt, payload, Order::createLimitOrder(BUY, 100.0, 100), out);
+        } else {
+            std::cerr << "Unknown payload '" << payload << "' (expected 8, 64, 256 or order)" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
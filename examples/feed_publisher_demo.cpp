@@ -14,8 +14,8 @@ int main(int argc, char** argv) {
     std::string payload = argv[1];
 
     hsnet::FeedPublisherConfig pubCfg;
-    pubCfg.multicast_group = "239.1.1.1";  // using hardcoded group
-    pubCfg.port = 8170;                    // using hardcoded port
+    pubCfg.multicast_group = "239.1.1.1";
+    pubCfg.port = 8170;
 
     // hsnet::
     auto publisher = hsnet::make_udp_reliable_publisher(pubCfg);
@@ -10,8 +10,8 @@ using namespace std::chrono_literals;
 
 int main() {
     hsnet::FeedSubscriberConfig subCfg;
-    subCfg.multicast_group = "239.1.1.1";  // hardcoded group
-    subCfg.port = 8170;                    // hardcoded port
+    subCfg.multicast_group = "239.1.1.1";
+    subCfg.port = 8170;
 
     auto subscriber = hsnet::make_udp_reliable_subscriber(subCfg);
 
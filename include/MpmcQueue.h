@@ -0,0 +1,114 @@
+#ifndef MPMCQUEUE_H
+#define MPMCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <utility>
+
+// Bounded multi-producer/multi-consumer ring buffer (Vyukov style).
+// Every cell carries a sequence number that tells producers and consumers
+// whether the cell is free for the current lap, so each operation is a single
+// CAS on the shared position plus a release store on the cell. Also serves
+// as the MPSC queue since it has no per-consumer state.
+template <typename T>
+class MpmcQueue {
+   public:
+    explicit MpmcQueue(size_t capacity) {
+        size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        mask_ = cap - 1;
+        cells_ = std::make_unique<Cell[]>(cap);
+        for (size_t i = 0; i < cap; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~MpmcQueue() {
+        while (pop()) {
+        }
+    }
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    template <typename... Args>
+    bool try_emplace(Args&&... args) {
+        Cell* cell;
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;  // Full
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        new (cell->storage) T(std::forward<Args>(args)...);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_push(const T& val) { return try_emplace(val); }
+    bool try_push(T&& val) { return try_emplace(std::move(val)); }
+
+    bool pop(T& item) {
+        auto result = pop();
+        if (!result) return false;
+        item = std::move(*result);
+        return true;
+    }
+
+    std::optional<T> pop() {
+        Cell* cell;
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return std::nullopt;  // Empty
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        T* val = std::launder(reinterpret_cast<T*>(cell->storage));
+        std::optional<T> result(std::move(*val));
+        val->~T();
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return result;
+    }
+
+    size_t size_approx() const noexcept {
+        return enqueue_pos_.load(std::memory_order_acquire) - dequeue_pos_.load(std::memory_order_acquire);
+    }
+    size_t capacity() const noexcept { return mask_ + 1; }
+
+   private:
+    static constexpr size_t kCacheLine = 64;
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(kCacheLine) std::atomic<size_t> enqueue_pos_{0};
+    alignas(kCacheLine) std::atomic<size_t> dequeue_pos_{0};
+};
+
+#endif  // MPMCQUEUE_H
@@ -1,9 +1,9 @@
 #ifndef ORDER_H
 #define ORDER_H
 
-#include <chrono>
 #include <cstdint>
 #include <iostream>
+#include <optional>
 
 static int id = 0;
 
@@ -30,8 +30,7 @@ class Order {
     std::optional<double> price;
     uint32_t order_size;
     uint32_t oid;
-    // uint64_t time_of_order;
-    std::chrono::time_point<std::chrono::steady_clock> timestamp;
+    uint64_t timestamp;  // TscClock ticks at creation
 
    public:
     Order() = delete;
@@ -47,7 +46,7 @@ class Order {
     std::optional<double> getPrice() const;
     Type getType() const;
     uint32_t getSize() const;
-    std::chrono::steady_clock::time_point getTimestamp() const;
+    uint64_t getTimestamp() const;  // TscClock ticks, see TscClock::elapsedNs
 
     void setSize(uint32_t size);
 
@@ -0,0 +1,109 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <utility>
+
+// Bounded single-producer/single-consumer ring buffer.
+// Capacity is rounded up to a power of two so indices wrap with a mask, and
+// each side keeps a cached copy of the other side's index so the shared cache
+// line is only read when the ring looks full (producer) or empty (consumer).
+template <typename T>
+class SpscQueue {
+   public:
+    explicit SpscQueue(size_t capacity) {
+        size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        mask_ = cap - 1;
+        slots_ = std::make_unique<Slot[]>(cap);
+    }
+
+    ~SpscQueue() {
+        while (front() != nullptr) pop_front();
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    template <typename... Args>
+    bool try_emplace(Args&&... args) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ > mask_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ > mask_) return false;  // Full
+        }
+        new (slots_[tail & mask_].storage) T(std::forward<Args>(args)...);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_push(const T& val) { return try_emplace(val); }
+    bool try_push(T&& val) { return try_emplace(std::move(val)); }
+
+    // Consumer side: peek at the oldest element without moving it out.
+    // Returns nullptr when the queue is empty.
+    T* front() noexcept {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) return nullptr;  // Empty
+        }
+        return slot(head);
+    }
+
+    // Consumer side: release the element returned by front()
+    void pop_front() noexcept {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        slot(head)->~T();
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    bool pop(T& item) {
+        T* val = front();
+        if (val == nullptr) return false;
+        item = std::move(*val);
+        pop_front();
+        return true;
+    }
+
+    std::optional<T> pop() {
+        T* val = front();
+        if (val == nullptr) return std::nullopt;
+        std::optional<T> result(std::move(*val));
+        pop_front();
+        return result;
+    }
+
+    size_t size_approx() const noexcept {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+    size_t capacity() const noexcept { return mask_ + 1; }
+
+   private:
+    static constexpr size_t kCacheLine = 64;
+
+    struct Slot {
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    T* slot(size_t index) noexcept {
+        return std::launder(reinterpret_cast<T*>(slots_[index & mask_].storage));
+    }
+
+    size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+
+    // Consumer owned
+    alignas(kCacheLine) std::atomic<size_t> head_{0};
+    size_t cached_tail_{0};
+
+    // Producer owned
+    alignas(kCacheLine) std::atomic<size_t> tail_{0};
+    size_t cached_head_{0};
+};
+
+#endif  // SPSCQUEUE_H
@@ -0,0 +1,78 @@
+#ifndef TSCCLOCK_H
+#define TSCCLOCK_H
+
+#include <cstdint>
+#include <ctime>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/*
+ * Process-wide clock based on the CPU timestamp counter.
+ *
+ * Hot paths only read the counter with now() (rdtsc on x86, cntvct_el0 on
+ * ARMv8, CLOCK_MONOTONIC elsewhere) and store raw ticks. Converting ticks to
+ * nanoseconds is deferred to whoever consumes the timestamp: toNs() maps into
+ * the CLOCK_MONOTONIC time base and toRealtimeNs() into CLOCK_REALTIME.
+ *
+ * The tick rate is calibrated against CLOCK_MONOTONIC on first use and refined
+ * by maybeRecalibrate(), which the polling loops call: the logger thread, the
+ * NetworkAgent and shared memory subscriptions while idle, UDP publications
+ * and subscriptions on every flush() and poll(). Processes that don't log stay
+ * calibrated too. The longer the calibration window, the more precise the
+ * rate gets.
+ */
+class TscClock {
+   public:
+    // Raw ticks. A few ns, no syscall, no fence.
+    static uint64_t now() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#elif defined(__aarch64__)
+        uint64_t v;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(v));
+        return v;
+#else
+        return monotonicNs();
+#endif
+    }
+
+    // Ticks to CLOCK_MONOTONIC / CLOCK_REALTIME nanoseconds
+    static uint64_t toNs(uint64_t ticks) noexcept;
+    static uint64_t toRealtimeNs(uint64_t ticks) noexcept;
+
+    // Length of a tick interval in nanoseconds
+    static uint64_t ticksToNs(uint64_t ticks) noexcept;
+
+    // Nanoseconds elapsed since `start_ticks`
+    static uint64_t elapsedNs(uint64_t start_ticks) noexcept { return ticksToNs(now() - start_ticks); }
+
+    // Current wall clock time through the calibrated counter
+    static uint64_t realtimeNs() noexcept { return toRealtimeNs(now()); }
+
+    // Re-derive the tick rate and the realtime offset now
+    static void recalibrate() noexcept;
+
+    // recalibrate() if the last calibration is older than the refresh interval.
+    // Cheap enough to call from any polling loop.
+    static void maybeRecalibrate() noexcept;
+
+    // Calibrated counter frequency in Hz
+    static double frequencyHz() noexcept;
+
+    // True when the counter is an invariant TSC (constant rate across P/C-states)
+    static bool invariant() noexcept;
+
+    static uint64_t monotonicNs() noexcept { return readClock(CLOCK_MONOTONIC); }
+    static uint64_t wallNs() noexcept { return readClock(CLOCK_REALTIME); }
+
+   private:
+    static uint64_t readClock(clockid_t id) noexcept {
+        timespec ts;
+        clock_gettime(id, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ull + static_cast<uint64_t>(ts.tv_nsec);
+    }
+};
+
+#endif  // TSCCLOCK_H
@@ -4,16 +4,21 @@
 
 namespace hsnet::ctrl {
 
+// Every sequence number below cumulative_ack has been received; bit i of
+// sack_bitmap marks cumulative_ack + 1 + i
 struct Ack {
     uint64_t cumulative_ack;
     uint64_t sack_bitmap;
+    uint64_t receive_window{0};  // Sequence numbers from cumulative_ack on the receiver can take
 };
 
+// Missing sequence numbers [start_seq, end_seq)
 struct NakRange {
     uint64_t start_seq;
     uint64_t end_seq;
 };
 
+// NAK payload header, followed by `count` NakRanges
 struct Nak {
     uint16_t count;
 };
@@ -5,8 +5,19 @@
 
 namespace hsnet {
 
+// Hardware CRC32C: SSE4.2 crc32 or ARMv8 crc32c instructions, 3-way interleaved
+// for large buffers. Falls back to crc32c_sw when the CPU lacks them.
 uint32_t crc32c_hw(const uint8_t* data, size_t len) noexcept;
+// Portable slicing-by-8 implementation
 uint32_t crc32c_sw(const uint8_t* data, size_t len) noexcept;
+// Fastest available implementation, selected once via CPUID / HWCAP
 uint32_t crc32c(const uint8_t* data, size_t len) noexcept;
 
-} // namespace hsnet 
\ No newline at end of file
+// Continue a checksum: crc32c_extend(crc32c(a), b) == crc32c(a || b)
+uint32_t crc32c_extend(uint32_t crc, const uint8_t* data, size_t len) noexcept;
+// Copy `len` bytes to `dst` and return crc32c_extend(crc, src, len) in the same pass
+uint32_t crc32c_copy(uint8_t* dst, const uint8_t* src, size_t len, uint32_t crc = 0) noexcept;
+
+bool crc32c_hw_available() noexcept;
+
+} // namespace hsnet 
@@ -0,0 +1,333 @@
+#pragma once
+
+#include <netinet/in.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "IoUring.h"
+#include "LatencyHistogram.h"
+#include "Protocol.h"
+#include "ReorderingBuffer.h"
+#include "RxBatch.h"
+#include "TscClock.h"
+#include "Transport.h"
+
+namespace hsnet {
+
+// Receive-side settings of a DatagramSubscription; see UdpConfig and
+// FeedSubscriberConfig for what they mean
+struct DatagramSubscriptionConfig {
+    bool crc{false};
+    uint32_t mtu{1500};
+    uint32_t recvBatchSize{32};
+    bool gro{false};
+    bool timestamps{false};         // The socket has SO_TIMESTAMPNS set
+    uint32_t reorderWindow{1024};
+    uint32_t maxReorderWindow{16384};
+    uint32_t maxMessageSize{1u << 20};
+    uint64_t nakDelayNs{0};         // 0: never NAK
+    uint64_t nakRetryNs{0};
+    bool acks{false};               // ACK the sender for flow control
+    uint64_t ackIntervalNs{0};
+    uint64_t livenessTimeoutNs{0};  // 0: a publisher once heard from stays connected
+    StreamId stream{0};             // Tracked from the start
+    uint32_t maxStreams{1};         // Streams tracked at once; frames of any others are dropped
+    bool ioUring{false};            // Receive through io_uring (no GRO); sockets if unavailable
+    bool sqPoll{false};
+    uint32_t ioUringEntries{256};   // Receive buffers in the ring
+};
+
+// Receive path shared by the UDP subscriptions. Each poll drains the socket
+// with recvmmsg() straight into free reordering buffer slots, validates the
+// frames and files them by sequence, then delivers what is in sequence from
+// the slots. Nothing is allocated or copied on the way. Batched frames are
+// unpacked into a MessageView per message.
+// With GRO a read may hold several coalesced datagrams, so those are read
+// into a staging RxBatch, split at the segment size the kernel reports, and
+// each frame is copied once into a reordering slot.
+// With ioUring a multishot recvmsg() fills the IoUringRx buffer ring, and
+// polling only reads completions from shared memory: each frame is copied
+// once from its ring buffer into a reordering slot, without a syscall.
+//
+// Every stream has its own sequence space, reordering buffer, recovery and
+// session state, found by stream_id through a small open-addressed table,
+// so a gap in one stream never holds up another. poll() delivers from all
+// streams and pollStream() from one, leaving the others buffered. A stream
+// is set up on its first frame (or pollStream()); reads go into the slots
+// of the stream that received last, and a frame for another stream is
+// copied once into its own buffer.
+//
+// With timestamps every frame carries the kernel's receive time next to the
+// publisher's send time into its MessageView, and each stream records the
+// difference, the one-way wire and stack latency, in a LatencyHistogram.
+//
+// Gaps that are still open nakDelayNs after they appear are reported to the
+// publisher (the source of the last good frame) in one NAK frame listing
+// the missing ranges, repeated every nakRetryNs until they are filled.
+// With acks, a poll that received frames or freed buffer space also sends
+// the sender a ctrl::Ack (at most one per ackIntervalNs) advertising the
+// room left in the reorder window and the socket buffer, which is the
+// sender's flow control window.
+//
+// Session frames from the publisher: a HELLO with a new session id starts
+// delivery afresh at the session's first sequence (and is answered so a
+// point-to-point sender knows it is connected), HEARTBEATs name the next
+// sequence to be sent so lost frames at the tail are NAKed like any other
+// gap, and a RESET moves a subscriber that fell behind the publisher's ring
+// past what can no longer be recovered. isConnected() is false until the
+// publisher is heard from and again once it has been silent for
+// livenessTimeoutNs.
+//
+// poll()/pollBatch() are templates on the handler, so code holding the
+// concrete type gets the handler inlined; the ISubscription overrides go
+// through one FunctionRef call instead.
+class DatagramSubscription : public ISubscription {
+   public:
+    explicit DatagramSubscription(const DatagramSubscriptionConfig& cfg);
+
+    // handler(const MessageView&) per in-sequence message
+    template <typename Handler>
+    int poll(Handler&& handler, int maxMessages) noexcept {
+        return poll_impl(handler, maxMessages, nullptr);
+    }
+
+    // handler(std::span<const MessageView>) per burst that became deliverable
+    template <typename Handler>
+    int pollBatch(Handler&& handler, int maxMessages) noexcept {
+        return poll_batch_impl(handler, maxMessages, nullptr);
+    }
+
+    // Like poll()/pollBatch(), delivering only `stream`
+    template <typename Handler>
+    int pollStream(StreamId stream, Handler&& handler, int maxMessages) noexcept {
+        Stream* s = find_or_add(stream);
+        return s != nullptr ? poll_impl(handler, maxMessages, s) : 0;
+    }
+
+    template <typename Handler>
+    int pollStreamBatch(StreamId stream, Handler&& handler, int maxMessages) noexcept {
+        Stream* s = find_or_add(stream);
+        return s != nullptr ? poll_batch_impl(handler, maxMessages, s) : 0;
+    }
+
+    int poll(FunctionRef<void(const MessageView&)> handler, int maxMessages) noexcept override {
+        return poll_impl(handler, maxMessages, nullptr);
+    }
+
+    int pollBatch(FunctionRef<void(std::span<const MessageView>)> handler, int maxMessages) noexcept override {
+        return poll_batch_impl(handler, maxMessages, nullptr);
+    }
+
+    bool hasData() const noexcept override {
+        return std::any_of(streams_.begin(), streams_.end(),
+                           [](const auto& s) { return s->reorder_buffer.has_ready(); });
+    }
+
+    bool hasData(StreamId stream) const noexcept {
+        const Stream* s = find(stream);
+        return s != nullptr && s->reorder_buffer.has_ready();
+    }
+
+    // Any publisher alive
+    bool isConnected() const noexcept override {
+        return std::any_of(streams_.begin(), streams_.end(), [this](const auto& s) { return connected(*s); });
+    }
+
+    bool isConnected(StreamId stream) const noexcept {
+        const Stream* s = find(stream);
+        return s != nullptr && connected(*s);
+    }
+
+    SubscriptionStats stats() const noexcept override {
+        SubscriptionStats stats = stats_;
+        for (const auto& s : streams_) stats.windowOverruns += s->reorder_buffer.overruns();
+        stats.ioUring = uring_ != nullptr;
+        return stats;
+    }
+
+    const LatencyHistogram* latency(StreamId stream) const noexcept override {
+        const Stream* s = timestamps_ ? find(stream) : nullptr;
+        return s != nullptr ? &s->latency : nullptr;
+    }
+
+   protected:
+    int sockfd_{-1};
+
+   private:
+    // Everything kept per stream: its own sequence space, reordering buffer,
+    // recovery and session state
+    struct Stream {
+        Stream(StreamId stream_id, const DatagramSubscriptionConfig& cfg, size_t spare_slots);
+
+        StreamId id;
+        ReorderingBuffer reorder_buffer;
+        uint64_t delivered{0};
+
+        sockaddr_in source{};     // Where NAKs and ACKs go
+        bool have_source{false};
+        bool gap_open{false};
+        uint64_t gap_seq{0};      // First missing sequence number of the open gap
+        uint64_t gap_since{0};    // TscClock ticks when it was first seen
+        uint64_t last_nak{0};     // TscClock ticks of the last NAK for it, 0 if none
+        bool ack_pending{false};  // Frames arrived since the last ACK
+        uint64_t acked_delivered{0};  // `delivered` when it was sent
+        uint64_t last_ack{0};     // TscClock ticks, 0 if none yet
+        uint64_t session_id{0};   // Publisher's session, 0 until heard of
+        uint64_t sender_next{0};  // The publisher has sent everything below this
+        uint64_t last_heard{0};   // TscClock ticks of the last frame from the publisher
+        LatencyHistogram latency; // Kernel receive time minus send time, with timestamps
+    };
+
+    template <typename Handler>
+    int poll_impl(Handler& handler, int maxMessages, Stream* only) noexcept {
+        // First, deliver in-sequence packets left over from the previous poll
+        int count = deliver(handler, maxMessages, TscClock::realtimeNs(), only);
+
+        // Then receive new packets from the network, a batch per syscall
+        while (count < maxMessages) {
+            if (receive() == 0) break;
+            // Anything past maxMessages stays buffered for the next poll
+            count += deliver(handler, maxMessages - count, TscClock::realtimeNs(), only);
+        }
+        feedback();
+        return count;
+    }
+
+    template <typename Handler>
+    int poll_batch_impl(Handler& handler, int maxMessages, Stream* only) noexcept {
+        int count = deliver_batch(handler, maxMessages, TscClock::realtimeNs(), only);
+        while (count < maxMessages) {
+            if (receive() == 0) break;
+            count += deliver_batch(handler, maxMessages - count, TscClock::realtimeNs(), only);
+        }
+        feedback();
+        return count;
+    }
+
+    template <typename Handler>
+    int deliver(Handler& handler, int maxMessages, uint64_t recv_ts, Stream* only) {
+        if (only != nullptr) return deliver_stream(*only, handler, maxMessages, recv_ts);
+        int count = 0;
+        for (size_t i = 0; i < streams_.size() && count < maxMessages; ++i) {
+            count += deliver_stream(*streams_[i], handler, maxMessages - count, recv_ts);
+        }
+        return count;
+    }
+
+    template <typename Handler>
+    int deliver_stream(Stream& s, Handler& handler, int maxMessages, uint64_t recv_ts) {
+        int count = 0;
+        while (count < maxMessages && s.reorder_buffer.deliver_next(recv_ts, handler)) {
+            count++;
+        }
+        s.delivered += count;
+        stats_.messagesDelivered += count;
+        return count;
+    }
+
+    template <typename Handler>
+    int deliver_batch(Handler& handler, int maxMessages, uint64_t recv_ts, Stream* only) {
+        if (only != nullptr) return deliver_stream_batch(*only, handler, maxMessages, recv_ts);
+        int count = 0;
+        for (size_t i = 0; i < streams_.size() && count < maxMessages; ++i) {
+            count += deliver_stream_batch(*streams_[i], handler, maxMessages - count, recv_ts);
+        }
+        return count;
+    }
+
+    template <typename Handler>
+    int deliver_stream_batch(Stream& s, Handler& handler, int maxMessages, uint64_t recv_ts) {
+        int count = 0;
+        while (count < maxMessages) {
+            const size_t limit = std::min(views_.size(), static_cast<size_t>(maxMessages - count));
+            const size_t n = s.reorder_buffer.peek_ready({views_.data(), limit}, recv_ts);
+            if (n == 0) break;
+            handler(std::span<const MessageView>(views_.data(), n));
+            s.reorder_buffer.consume();
+            count += static_cast<int>(n);
+        }
+        s.delivered += count;
+        stats_.messagesDelivered += count;
+        return count;
+    }
+
+    // One receive syscall's worth of frames into the reordering buffers;
+    // returns the number of datagrams read
+    int receive() noexcept {
+        if (uring_) return receive_uring();
+        return gro_ ? receive_coalesced() : receive_in_place();
+    }
+    int receive_in_place() noexcept;
+    int receive_coalesced() noexcept;
+    int receive_uring() noexcept;
+
+    // `slot` (from `pool`'s buffer) holds the frame, or NO_SLOT if it has
+    // to be copied into one; `received_ns` is the kernel timestamp, 0 if none
+    void accept(const uint8_t* frame, size_t n, bool truncated, Stream* pool, ReorderingBuffer::SlotId slot,
+                const sockaddr_in& source, uint64_t received_ns) noexcept;
+
+    // Stream table: nullptr if unknown, or if the table is full
+    const Stream* find(StreamId stream) const noexcept;
+    Stream* find(StreamId stream) noexcept {
+        return const_cast<Stream*>(static_cast<const DatagramSubscription*>(this)->find(stream));
+    }
+    Stream* find_or_add(StreamId stream);
+    size_t table_index(StreamId stream) const noexcept { return (stream * 0x9E3779B1u) & table_mask_; }
+
+    bool connected(const Stream& s) const noexcept {
+        return s.have_source && (liveness_timeout_ns_ == 0 || TscClock::elapsedNs(s.last_heard) < liveness_timeout_ns_);
+    }
+
+    // NAKs and ACKs owed to the senders after a poll
+    void feedback() noexcept {
+        for (const auto& s : streams_) {
+            check_gaps(*s);
+            if (acks_) maybe_ack(*s);
+        }
+        // Receive times are compared with the publisher's send times
+        TscClock::maybeRecalibrate();
+    }
+
+    // Send a NAK once a gap has outlived the NAK timer
+    void check_gaps(Stream& s) noexcept;
+    void send_nak(Stream& s) noexcept;
+    void maybe_ack(Stream& s) noexcept;
+
+    // HELLO, HEARTBEAT or RESET from the publisher
+    void on_session_frame(Stream& s, const proto::Header& header, const uint8_t* payload) noexcept;
+    void start_session(Stream& s, uint64_t session_id, uint64_t sequence) noexcept;
+
+    // To the stream's publisher
+    bool send_control(const Stream& s, const uint8_t* frame, size_t len) noexcept;
+
+    DatagramSubscriptionConfig cfg_;
+    bool crc_;
+    bool gro_;
+    bool timestamps_;
+    RxBatch batch_;
+    std::unique_ptr<IoUringRx> uring_;  // Null unless receiving through io_uring
+    std::vector<ReorderingBuffer::SlotId> batch_slots_;  // Reordering slot behind each batch entry
+    std::vector<MessageView> views_;                     // pollBatch() burst
+    SubscriptionStats stats_{};
+
+    std::vector<std::unique_ptr<Stream>> streams_;  // In order of arrival
+    std::vector<int32_t> table_;                    // Index into streams_ by stream id, -1 if empty
+    size_t table_mask_;
+    Stream* rx_stream_{nullptr};                    // Receives go into this stream's slots
+
+    uint64_t nak_delay_ns_;
+    uint64_t nak_retry_ns_;
+    bool acks_;
+    uint64_t ack_interval_ns_;
+    uint64_t socket_window_{0};  // Full-size frames the socket buffer holds; 0 until known
+    uint64_t liveness_timeout_ns_;
+    std::array<ctrl::NakRange, proto::MAX_NAK_RANGES> nak_ranges_{};
+    std::array<uint8_t, proto::NAK_FRAME_BYTES> control_frame_{};  // Any outgoing control frame
+};
+
+} // namespace hsnet
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <linux/io_uring.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "RxBatch.h"
+
+namespace hsnet {
+
+// Minimal io_uring instance on the raw syscalls (liburing isn't required).
+// SQEs are queued with get_sqe() and handed over with submit(); completions
+// are read straight from the shared CQ ring with reap(), no syscall. With
+// SQPOLL a kernel thread picks up submissions as well, so submit() only
+// enters the kernel to wake it after it has idled.
+//
+// Single thread; no internal synchronization.
+class IoUring {
+public:
+    // ok() is false if the kernel refuses (old kernel, io_uring disabled)
+    IoUring(unsigned entries, bool sq_poll);
+    ~IoUring();
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    bool ok() const noexcept { return fd_ >= 0; }
+    int fd() const noexcept { return fd_; }
+
+    // Zeroed SQE to fill in, nullptr while the submission queue is full
+    io_uring_sqe* get_sqe() noexcept;
+
+    // Make the queued SQEs visible to the kernel; returns the number handed
+    // over, or -errno
+    int submit() noexcept;
+
+    // handler(const io_uring_cqe&) per completion; returns the count
+    template <typename Handler>
+    unsigned reap(Handler&& handler) noexcept {
+        if (overflowed()) flush_overflow();
+        unsigned head = *cq_head_;
+        const unsigned tail = std::atomic_ref<unsigned>(*cq_tail_).load(std::memory_order_acquire);
+        const unsigned count = tail - head;
+        for (; head != tail; ++head) handler(cqes_[head & cq_mask_]);
+        std::atomic_ref<unsigned>(*cq_head_).store(head, std::memory_order_release);
+        return count;
+    }
+
+private:
+    bool overflowed() const noexcept {
+        return (std::atomic_ref<unsigned>(*sq_flags_).load(std::memory_order_relaxed) & IORING_SQ_CQ_OVERFLOW) != 0;
+    }
+    void flush_overflow() noexcept;
+    void unmap() noexcept;
+    int enter(unsigned to_submit, unsigned flags) noexcept;
+
+    int fd_{-1};
+    bool sq_poll_;
+    void* sq_map_{nullptr};
+    size_t sq_map_bytes_{0};
+    void* cq_map_{nullptr};
+    size_t cq_map_bytes_{0};
+    io_uring_sqe* sqes_{nullptr};
+    size_t sqes_bytes_{0};
+
+    unsigned* sq_head_{nullptr};
+    unsigned* sq_tail_{nullptr};
+    unsigned* sq_flags_{nullptr};
+    unsigned* sq_array_{nullptr};
+    unsigned sq_mask_{0};
+    unsigned sq_entries_{0};
+    unsigned sqe_tail_{0};  // Next SQE to hand out
+
+    unsigned* cq_head_{nullptr};
+    unsigned* cq_tail_{nullptr};
+    unsigned cq_mask_{0};
+    io_uring_cqe* cqes_{nullptr};
+};
+
+// Receive side on io_uring: one multishot recvmsg() keeps the socket armed
+// and the kernel writes each datagram, with its source address, into the
+// next free buffer of a group provided to it up front. receive() reads the
+// completions from shared memory and hands the buffers back in runs, one
+// PROVIDE_BUFFERS request per run, queued with any re-arm (after the
+// buffers ran out) in a single submit; with SQPOLL not even that is a
+// syscall. No GRO. With `timestamps` each buffer also has room for the
+// SO_TIMESTAMPNS control message.
+class IoUringRx {
+public:
+    // `buffers` of `datagram_bytes` each
+    IoUringRx(unsigned buffers, size_t datagram_bytes, bool sq_poll, bool timestamps = false);
+
+    // False if the kernel lacks provided buffers or multishot recvmsg()
+    bool ok() const noexcept { return ring_.ok() && !failed_; }
+
+    // handler(data, length, truncated, source, receive_time_ns) per datagram
+    // completed on `sockfd` (the time is 0 without timestamps); the data is
+    // only valid during the call. Returns the count.
+    template <typename Handler>
+    int receive(int sockfd, Handler&& handler) noexcept {
+        int count = 0;
+        ring_.reap([&](const io_uring_cqe& cqe) {
+            if (cqe.user_data != RECV) {
+                if (cqe.res < 0) failed_ = true;
+                return;
+            }
+            if ((cqe.flags & IORING_CQE_F_MORE) == 0) armed_ = false;
+            if (cqe.res < 0 && cqe.res != -ENOBUFS) failed_ = true;
+            if ((cqe.flags & IORING_CQE_F_BUFFER) == 0) return;
+            const uint16_t bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            if (cqe.res >= static_cast<int>(headroom_)) {
+                uint8_t* buf = storage_.data() + static_cast<size_t>(bid) * buffer_bytes_;
+                io_uring_recvmsg_out out;
+                std::memcpy(&out, buf, sizeof(out));
+                sockaddr_in source{};
+                std::memcpy(&source, buf + sizeof(out), std::min<size_t>(out.namelen, sizeof(source)));
+                uint64_t received_ns = 0;
+                if (msg_.msg_controllen > 0) {
+                    msghdr control{};
+                    control.msg_control = buf + sizeof(out) + msg_.msg_namelen;
+                    control.msg_controllen = out.controllen;
+                    received_ns = receive_timestamp_ns(control);
+                }
+                handler(buf + headroom_, std::min<size_t>(out.payloadlen, cqe.res - headroom_),
+                        (out.flags & MSG_TRUNC) != 0, source, received_ns);
+                count++;
+            }
+            returned_.push_back(bid);
+        });
+        replenish(sockfd);
+        return count;
+    }
+
+private:
+    static constexpr uint16_t GROUP = 0;
+    static constexpr unsigned MAX_BUFFERS = 1u << 15;  // Buffer ids are 16 bits
+    static constexpr uint64_t RECV = 1;     // user_data of the recvmsg
+    static constexpr uint64_t PROVIDE = 2;  // and of PROVIDE_BUFFERS
+
+    // Queue buffers [bid, bid + count) for the kernel; false while the SQ is full
+    bool provide(uint16_t bid, unsigned count) noexcept;
+    // Hand back the buffers read and re-arm if needed, in one submit
+    void replenish(int sockfd) noexcept;
+
+    IoUring ring_;
+    size_t headroom_;  // recvmsg header, source address and control data before the payload
+    size_t buffer_bytes_;
+    std::vector<uint8_t> storage_;
+    std::vector<uint16_t> returned_;  // Buffers read since the last replenish()
+    msghdr msg_{};  // Tells the kernel how much room to leave for the address and control data
+    bool armed_{false};
+    bool failed_{false};
+};
+
+} // namespace hsnet
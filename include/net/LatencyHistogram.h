@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace hsnet {
+
+// Log-linear histogram of nanosecond latencies, HdrHistogram style: exact
+// below 2^SUB_BITS, then 2^SUB_BITS buckets per power of two, so a value is
+// known to within 1/2^SUB_BITS (about 3%) of itself. Values above MAX_NS
+// are counted in the last bucket. Fixed size; record() is a few
+// instructions and never allocates.
+//
+// Single writer; no internal synchronization.
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BITS = 5;
+    static constexpr unsigned MAX_BITS = 40;
+    static constexpr uint64_t MAX_NS = (1ull << MAX_BITS) - 1;  // About 18 minutes
+
+    void record(uint64_t ns) noexcept {
+        ns = std::min(ns, MAX_NS);
+        buckets_[bucket(ns)]++;
+        count_++;
+        sum_ += ns;
+        min_ = std::min(min_, ns);
+        max_ = std::max(max_, ns);
+    }
+
+    uint64_t count() const noexcept { return count_; }
+    uint64_t min() const noexcept { return count_ > 0 ? min_ : 0; }
+    uint64_t max() const noexcept { return max_; }
+    uint64_t mean() const noexcept { return count_ > 0 ? sum_ / count_ : 0; }
+
+    // Value that `fraction` (0..1) of the samples don't exceed, rounded up
+    // to its bucket's upper bound; 0 while empty
+    uint64_t percentile(double fraction) const noexcept;
+
+    void reset() noexcept;
+
+private:
+    static constexpr size_t SUB_COUNT = size_t{1} << SUB_BITS;
+    static constexpr size_t BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_COUNT;
+
+    // Values below SUB_COUNT have a bucket each; above, the SUB_BITS bits
+    // after the leading one pick the bucket within the power of two
+    static size_t bucket(uint64_t ns) noexcept {
+        if (ns < SUB_COUNT) return static_cast<size_t>(ns);
+        const unsigned shift = static_cast<unsigned>(std::bit_width(ns)) - SUB_BITS - 1;
+        return (shift + 1) * SUB_COUNT + static_cast<size_t>((ns >> shift) - SUB_COUNT);
+    }
+    // Largest value that lands in bucket `index`
+    static uint64_t bucket_upper(size_t index) noexcept;
+
+    std::array<uint64_t, BUCKETS> buckets_{};
+    uint64_t count_{0};
+    uint64_t sum_{0};
+    uint64_t min_{UINT64_MAX};
+    uint64_t max_{0};
+};
+
+} // namespace hsnet
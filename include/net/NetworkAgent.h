@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Transport.h"
+
+namespace hsnet {
+
+// What the agent thread does after a duty cycle that found no work
+enum class IdleStrategy : uint8_t {
+    BUSY_SPIN,  // Pause instruction only: lowest latency, the core stays busy
+    YIELD,      // sched_yield() to anything else runnable on the core
+    BACKOFF,    // Spin, then yield, then sleep, doubling up to maxIdleSleepNs
+};
+
+struct NetworkAgentConfig {
+    int cpu{-1};                         // Core the agent thread is pinned to; -1 = not pinned
+    IdleStrategy idle{IdleStrategy::BUSY_SPIN};
+    uint32_t spinsBeforeYield{1000};     // BACKOFF
+    uint32_t yieldsBeforeSleep{100};     // BACKOFF
+    uint64_t maxIdleSleepNs{1'000'000};  // BACKOFF
+    uint32_t dutyCycleLimit{64};         // Messages moved per subscription or publication per cycle
+    uint32_t ringBytes{1u << 22};        // Handoff ring per subscription and publication, rounded up to a power of two
+    uint32_t maxMessageSize{1u << 16};   // Larger received messages are dropped (NetworkAgentStats::oversizedDropped)
+};
+
+// Agent thread counters, cumulative since construction
+struct NetworkAgentStats {
+    uint64_t dutyCycles{0};
+    uint64_t idleCycles{0};        // Cycles that found nothing to do
+    uint64_t oversizedDropped{0};  // Received messages over maxMessageSize
+    uint64_t offersRejected{0};    // Offers the publication refused with ERROR or CLOSED
+};
+
+// Runs the network side of a set of subscriptions and publications on one
+// dedicated thread, optionally pinned to a core, so reads, NAKs, ACKs,
+// heartbeats and sends never run on (or wait for) the threads that consume
+// the messages. Each duty cycle polls every subscription and copies what it
+// delivers into that subscription's handoff ring, moves the messages queued
+// in each publication's ring into offer() and flushes it, then idles per
+// the IdleStrategy if none of that found work.
+//
+// add_subscription()/add_publication() hand the endpoint to the agent and
+// return the side the application uses, backed by a single-producer/
+// single-consumer ring of variable-length records (each record is one
+// message, a whole number of cache lines). Both are meant for one
+// application thread each:
+// - The returned ISubscription's poll() delivers from the ring; views point
+//   into it and stay valid until the handler returns. It is polled at most
+//   as far as the ring has room, so a slow consumer pushes back on the
+//   network the same way a slow poll() loop does.
+// - The returned IPublication's offer() and tryClaim()/commit() write into
+//   the ring and report BACKPRESSURED while it is full; the agent offers
+//   the messages in order, retrying while the publication is backpressured
+//   or not yet connected. flush() is the agent's job and does nothing.
+// Stats and isConnected() are snapshots the agent refreshes about every
+// millisecond; latency histograms stay with the agent and aren't forwarded.
+//
+// Endpoints may be added while the agent runs.
+class NetworkAgent {
+public:
+    explicit NetworkAgent(const NetworkAgentConfig& cfg = {});
+    ~NetworkAgent();
+
+    NetworkAgent(const NetworkAgent&) = delete;
+    NetworkAgent& operator=(const NetworkAgent&) = delete;
+
+    std::unique_ptr<ISubscription> add_subscription(std::unique_ptr<ISubscription> subscription);
+    std::unique_ptr<IPublication> add_publication(std::unique_ptr<IPublication> publication);
+
+    // Start the agent thread; throws if it can't be pinned to cfg.cpu
+    void start();
+    // Stop and join it (forwarding what is queued first); start() resumes
+    void stop();
+    bool running() const noexcept { return running_.load(std::memory_order_relaxed); }
+
+    NetworkAgentStats stats() const noexcept;
+
+    struct SubscriptionBinding;
+    struct PublicationBinding;
+
+private:
+    // Pin the calling thread to cfg.cpu, if set; false if it can't be
+    bool pin() noexcept;
+    void run() noexcept;
+    // One pass over every endpoint; returns the amount of work done
+    int duty_cycle() noexcept;
+    int poll_subscription(SubscriptionBinding& binding) noexcept;
+    int drain_publication(PublicationBinding& binding) noexcept;
+    void idle(uint32_t& idle_count) noexcept;
+    // Pick up endpoints added since the last cycle
+    void adopt_added() noexcept;
+
+    NetworkAgentConfig cfg_;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+
+    // Agent thread's own lists
+    std::vector<std::shared_ptr<SubscriptionBinding>> subscriptions_;
+    std::vector<std::shared_ptr<PublicationBinding>> publications_;
+
+    // Endpoints added but not adopted yet
+    std::mutex added_mutex_;
+    std::atomic<bool> added_pending_{false};
+    std::vector<std::shared_ptr<SubscriptionBinding>> added_subscriptions_;
+    std::vector<std::shared_ptr<PublicationBinding>> added_publications_;
+
+    std::atomic<uint64_t> duty_cycles_{0};
+    std::atomic<uint64_t> idle_cycles_{0};
+    std::atomic<uint64_t> oversized_dropped_{0};
+    std::atomic<uint64_t> offers_rejected_{0};
+};
+
+} // namespace hsnet
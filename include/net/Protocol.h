@@ -1,6 +1,11 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <span>
+
+#include "ControlFrames.h"
 
 namespace hsnet::proto {
 
@@ -27,9 +32,99 @@ struct alignas(8) Header {
     uint32_t crc32c_payload;
 };
 
+// Header flags
+inline constexpr uint8_t FLAG_CRC32C = 0x01;     // crc32c_payload covers the header and payload
+inline constexpr uint8_t FLAG_CONTINUED = 0x02;  // Message continues in the next offer (!endOfMessage)
+inline constexpr uint8_t FLAG_BATCHED = 0x04;    // Payload packs several messages (see append_batched)
+
+// Callers set only the type/flags bits of magic_version_type_flags;
+// write_header fills in magic and version
+inline void set_type_flags(Header& h, FrameType type, uint8_t flags) noexcept {
+    h.magic_version_type_flags = (static_cast<uint64_t>(type) << 8) | flags;
+}
+inline FrameType frame_type(const Header& h) noexcept {
+    return static_cast<FrameType>((h.magic_version_type_flags >> 8) & 0xFF);
+}
+inline uint8_t frame_flags(const Header& h) noexcept { return static_cast<uint8_t>(h.magic_version_type_flags & 0xFF); }
+
 void write_header(uint8_t* dst, const Header& h) noexcept;
 bool parse_header(const uint8_t* src, Header& out) noexcept;
 
+// Header followed by the payload. With FLAG_CRC32C set in `h`, the CRC over
+// header and payload is computed while the payload is copied and stored in
+// crc32c_payload. Returns the frame length.
+size_t write_frame(uint8_t* dst, const Header& h, const uint8_t* payload, size_t len) noexcept;
+
+// Same as write_frame for a payload that is already in place after the
+// header (h.payload_length bytes at dst + sizeof(Header))
+size_t seal_frame(uint8_t* dst, const Header& h) noexcept;
+
+// Check crc32c_payload of a received frame (header + payload bytes as sent)
+bool verify_frame_crc(const uint8_t* frame, size_t len, const Header& parsed) noexcept;
+
+// A batched DATA frame packs whole messages back to back, each behind a
+// big-endian uint16 length, and all share the frame's sequence number
+inline constexpr size_t BATCH_PREFIX_BYTES = sizeof(uint16_t);
+
+// Append a message at `offset` of a batched payload (room is the caller's
+// concern); returns the new payload length
+inline size_t append_batched(uint8_t* payload, size_t offset, const uint8_t* msg, size_t len) noexcept {
+    payload[offset] = static_cast<uint8_t>(len >> 8);
+    payload[offset + 1] = static_cast<uint8_t>(len);
+    if (len > 0) std::memcpy(payload + offset + BATCH_PREFIX_BYTES, msg, len);
+    return offset + BATCH_PREFIX_BYTES + len;
+}
+
+// The message at `offset` of a batched payload of `len` bytes, advancing
+// `offset` past it; false at the end or if the rest is malformed
+inline bool next_batched(const uint8_t* payload, size_t len, size_t& offset, std::span<const uint8_t>& msg) noexcept {
+    if (offset + BATCH_PREFIX_BYTES > len) return false;
+    const size_t n = (static_cast<size_t>(payload[offset]) << 8) | payload[offset + 1];
+    if (offset + BATCH_PREFIX_BYTES + n > len) return false;
+    msg = {payload + offset + BATCH_PREFIX_BYTES, n};
+    offset += BATCH_PREFIX_BYTES + n;
+    return true;
+}
+
+// NAK frame payload: ctrl::Nak (big-endian, padded to 8 bytes), then `count`
+// ctrl::NakRanges as big-endian sequence numbers
+inline constexpr size_t MAX_NAK_RANGES = 32;
+inline constexpr size_t NAK_COUNT_BYTES = 8;
+inline constexpr size_t NAK_FRAME_BYTES = sizeof(Header) + NAK_COUNT_BYTES + MAX_NAK_RANGES * sizeof(ctrl::NakRange);
+
+// Encode a NAK frame for up to MAX_NAK_RANGES `ranges` into `dst` (at least
+// NAK_FRAME_BYTES). `h` supplies the stream and flags; the type and payload
+// length are filled in. Returns the frame length.
+size_t write_nak_frame(uint8_t* dst, Header h, std::span<const ctrl::NakRange> ranges) noexcept;
+
+// Decode the ranges of a NAK payload into `out`; returns how many were read,
+// 0 if the payload is malformed
+size_t read_nak(const uint8_t* payload, size_t len, std::span<ctrl::NakRange> out) noexcept;
+
+// ACK frame payload: the three ctrl::Ack fields as big-endian uint64s
+inline constexpr size_t ACK_FRAME_BYTES = sizeof(Header) + 3 * sizeof(uint64_t);
+
+// Encode an ACK frame into `dst` (at least ACK_FRAME_BYTES); like
+// write_nak_frame. Returns the frame length.
+size_t write_ack_frame(uint8_t* dst, Header h, const ctrl::Ack& ack) noexcept;
+
+// Decode an ACK payload; false if it is too short
+bool read_ack(const uint8_t* payload, size_t len, ctrl::Ack& out) noexcept;
+
+// HELLO, HEARTBEAT and RESET frames carry the publisher's session id as
+// their payload and a sequence number in the header: the first of the
+// session (HELLO; a subscriber's reply echoes the session with the next
+// sequence it expects), the next to be sent (HEARTBEAT), or where delivery
+// restarts (RESET)
+inline constexpr size_t SESSION_FRAME_BYTES = sizeof(Header) + sizeof(uint64_t);
+
+// Encode a session frame of `type` into `dst` (at least SESSION_FRAME_BYTES);
+// like write_nak_frame. Returns the frame length.
+size_t write_session_frame(uint8_t* dst, Header h, FrameType type, uint64_t session_id) noexcept;
+
+// Decode a session frame payload; false if it is too short
+bool read_session_id(const uint8_t* payload, size_t len, uint64_t& session_id) noexcept;
+
 // define htonll and ntohll if not available
 #if !defined(htonll) && !defined(ntohll)
 	inline uint64_t htonll(uint64_t value) noexcept {
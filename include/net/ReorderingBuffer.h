@@ -1,58 +1,207 @@
 #pragma once
 
+#include <bit>
 #include <cstdint>
 #include <memory>
-#include <optional>
+#include <span>
 #include <vector>
 
+#include "ControlFrames.h"
+#include "Transport.h"
+
 namespace hsnet {
 
-// Simple reordering buffer that ensures in-sequence delivery
+// Where a frame sits in its message (see proto::Header)
+struct FrameFragment {
+    uint16_t index{0};
+    uint16_t total{1};
+    bool end_of_message{true};  // False if the sender continues the message in its next offer
+};
+
+// When a frame was sent (publisher's clock) and received (kernel
+// timestamp), CLOCK_REALTIME nanoseconds; 0 if unknown
+struct FrameTimes {
+    uint64_t sent_ns{0};
+    uint64_t received_ns{0};
+};
+
+// Reordering buffer that ensures in-sequence delivery without touching the
+// heap after construction. It owns a pool of fixed-size slots: the receive
+// path reads datagrams straight into free slots (acquire()), files them by
+// sequence number (add()), and deliver_next() hands the handler a
+// MessageView pointing into the slot, which is freed once the handler returns.
+//
+// The window is a power of two, indexed by `sequence & mask`, with an
+// occupancy bitmap alongside so ready runs and gaps are found a word at a
+// time (countr_one/countr_zero, i.e. tzcnt) and the ACK/SACK state can be
+// exported directly. Frames beyond the window are dropped (and recovered
+// by NAK once it reaches them); when GROW_AFTER_OVERRUNS of them arrive
+// before delivery has moved a whole window on, the reordering is sustained
+// and the window doubles, up to `max_capacity`. That is the only time it
+// allocates, so a single stray or far-ahead frame never does.
+//
+// Fragments of a message occupy consecutive sequence numbers. Once all of
+// them are in, they are copied into a preallocated reassembly buffer and
+// delivered as one MessageView. A message that can never fit (larger than
+// the reassembly buffer or the largest window) is delivered fragment by
+// fragment instead, with endOfMessage set on the last one.
+//
+// Views carry the frame's send and receive times; a reassembled message
+// has its first fragment's send time and its last fragment's receive time.
+//
+// A batched frame (proto::FLAG_BATCHED) is delivered as the separate
+// messages packed in it. If they don't all fit in one peek_ready(), the
+// rest stay in the slot for the next one.
 class ReorderingBuffer {
 public:
-    explicit ReorderingBuffer(size_t max_size = 1024);
-    
-    // Add a packet with sequence number, returns true if it was added
-    bool add(uint64_t sequence, std::vector<uint8_t> data, uint32_t stream_id = 0);
-    
-    // Get next in-sequence packet, returns empty if none available
-    std::optional<std::pair<std::vector<uint8_t>, uint32_t>> get_next();
-    
-    // Check if we have any packets ready for delivery
-    bool has_ready() const;
+    using SlotId = uint32_t;
+    static constexpr SlotId NO_SLOT = UINT32_MAX;
+    using Fragment = FrameFragment;
+
+    // Reorders up to `max_size` (rounded up to a power of two) sequence
+    // numbers ahead of the next expected one, growing to `max_capacity` when
+    // frames keep arriving further ahead (0: never grow). The pool holds one slot
+    // of `slot_bytes` per window position plus `spare_slots`, so a full
+    // window still leaves spare_slots to receive into. Messages of up to
+    // `max_message_bytes` are reassembled.
+    explicit ReorderingBuffer(size_t max_size = 1024, size_t slot_bytes = 2048, size_t spare_slots = 0,
+                              size_t max_capacity = 0, size_t max_message_bytes = 0);
+
+    // Take a free slot to receive a frame into, NO_SLOT if none are left.
+    // Hand it back with release() unless it is passed to add().
+    SlotId acquire() noexcept;
+    void release(SlotId slot) noexcept;
+    uint8_t* slot_data(SlotId slot) noexcept {
+        return chunks_[slot / CHUNK_SLOTS].get() + static_cast<size_t>(slot % CHUNK_SLOTS) * slot_bytes_;
+    }
+    const uint8_t* slot_data(SlotId slot) const noexcept {
+        return chunks_[slot / CHUNK_SLOTS].get() + static_cast<size_t>(slot % CHUNK_SLOTS) * slot_bytes_;
+    }
+    size_t slot_bytes() const noexcept { return slot_bytes_; }
+
+    // File the frame received in `slot` (payload at [offset, offset + length))
+    // under `sequence`. Returns true if it was added; old, duplicate or too far
+    // ahead frames are dropped and their slot released. A `batched` payload
+    // holds several messages.
+    bool add(uint64_t sequence, SlotId slot, uint16_t offset, uint16_t length, uint32_t stream_id = 0,
+             Fragment fragment = {}, bool batched = false, FrameTimes times = {});
+
+    // Copy a payload that was received elsewhere into a slot and file it
+    bool add(uint64_t sequence, std::span<const uint8_t> data, uint32_t stream_id = 0, Fragment fragment = {},
+             bool batched = false, FrameTimes times = {});
+
+    // Pass the next in-sequence message to handler(const MessageView&) and
+    // free its slots when the handler returns. False if none is ready.
+    template <typename Handler>
+    bool deliver_next(uint64_t receive_time_ns, Handler&& handler) {
+        MessageView view;
+        if (peek_ready({&view, 1}, receive_time_ns) == 0) return false;
+        handler(view);
+        consume();
+        return true;
+    }
+
+    // Views of up to out.size() in-sequence messages, left in place until
+    // consume(). A reassembled message is only ever returned first, as the
+    // reassembly buffer holds one. Returns the number written.
+    // `receive_time_ns` stands in for frames added without a receive time.
+    size_t peek_ready(std::span<MessageView> out, uint64_t receive_time_ns) noexcept;
+
+    // Free the packets behind the views of the last peek_ready(), or the
+    // part of a batched frame they covered
+    void consume() noexcept;
+
+    // Check if we have a message ready for delivery
+    bool has_ready() const noexcept { return message_span() > 0; }
+
+    // Length of the run of in-sequence packets ready for delivery
+    size_t ready_count() const noexcept;
+
+    // First sequence number not received yet
+    uint64_t first_gap() const noexcept { return next_seq_ + ready_count(); }
+
+    // First received sequence number >= `from`, or the end of the window
+    uint64_t next_received(uint64_t from) const noexcept;
+
+    // Cumulative ack (every sequence number below it has been received), a
+    // bitmap of what arrived after it (bit i = cumulative_ack + 1 + i), and
+    // how far past it the window reaches
+    ctrl::Ack ack() const noexcept;
+
+    // Coalesced ranges of sequence numbers missing before the last received
+    // one, or before `known_end` if the sender is known to have sent up to
+    // there, oldest first, up to out.size(); returns the number written
+    size_t missing_ranges(std::span<ctrl::NakRange> out, uint64_t known_end = 0) const noexcept;
     
     // Get the next expected sequence number
     uint64_t next_expected() const { return next_seq_; }
     
     // Get statistics
     size_t size() const { return count_; }
-    size_t max_size() const { return max_size_; }
+    size_t max_size() const { return capacity_; }
+    size_t max_capacity() const { return max_capacity_; }
+    size_t free_slots() const { return free_.size(); }
+    uint64_t overruns() const { return overruns_; }  // Dropped: beyond the window
     
-    // Clear the buffer (useful for reset scenarios)
-    void clear();
+    // Drop everything buffered and expect `next_sequence` next (session
+    // start or reset)
+    void clear(uint64_t next_sequence = 0);
 
 private:
+    // Slot storage grows in chunks so slot pointers stay valid when it grows
+    static constexpr size_t CHUNK_SLOTS = 64;
+    // Overruns within one window's worth of delivery that make the window double
+    static constexpr uint32_t GROW_AFTER_OVERRUNS = 8;
+
     struct Packet {
-        uint64_t sequence;
-        std::vector<uint8_t> data;
-        uint32_t stream_id;
-        bool valid;
-        
-        Packet() : sequence(0), stream_id(0), valid(false) {}
-        Packet(uint64_t seq, std::vector<uint8_t> d, uint32_t sid) : sequence(seq), data(std::move(d)), stream_id(sid), valid(true) {}
+        uint64_t sequence{0};
+        SlotId slot{NO_SLOT};
+        uint16_t offset{0};
+        uint16_t length{0};
+        uint32_t stream_id{0};
+        Fragment fragment{};
+        bool batched{false};  // offset/length cover the messages not delivered yet
+        FrameTimes times{};
     };
+
+    // Packets making up the next deliverable message: 1 for a whole or
+    // streamed frame, fragments_total once a message is complete, 0 if
+    // nothing can be delivered yet
+    size_t message_span() const noexcept;
+    MessageView view_of(const Packet& packet, uint64_t receive_time_ns) const noexcept;
+    // Free the packet at next_seq_ and move past it
+    void drop_head() noexcept;
+
+    bool test_bit(size_t pos) const noexcept { return (present_[pos >> 6] >> (pos & 63)) & 1; }
+    void set_bit(size_t pos) noexcept { present_[pos >> 6] |= 1ull << (pos & 63); }
+    void clear_bit(size_t pos) noexcept { present_[pos >> 6] &= ~(1ull << (pos & 63)); }
+
+    // Presence of `seq`.. `seq + 63`, zero past the end of the window
+    uint64_t window_bits(uint64_t seq) const noexcept;
+
+    // Whether `sequence` is in the window, growing it under sustained overruns
+    bool fits(uint64_t sequence);
+    void grow(size_t capacity);
+    void add_slots(size_t count);
     
-    std::vector<Packet> buffer_;
-    size_t max_size_;
+    std::vector<Packet> buffer_;     // Indexed by sequence & mask_
+    std::vector<uint64_t> present_;  // Occupancy bitmap over buffer_
+    size_t capacity_;
+    size_t mask_;
+    size_t max_capacity_;
     uint64_t next_seq_;
-    size_t head_;
     size_t count_;
-    
-    // Helper to find packet in buffer
-    size_t find_packet(uint64_t sequence) const;
-    
-    // Helper to advance head pointer
-    void advance_head();
+    uint64_t overruns_;
+    uint32_t pressure_{0};        // Overruns since pressure_start_
+    uint64_t pressure_start_{0};  // next_seq_ at the first of them
+    size_t pending_consume_{0};         // Packets behind the last peek_ready()
+    size_t pending_unpacked_{0};        // Bytes of the batched frame after them it also covered
+    std::vector<uint8_t> reassembly_;
+
+    size_t slot_bytes_;
+    std::vector<std::unique_ptr<uint8_t[]>> chunks_;  // Slot pool, CHUNK_SLOTS slots each
+    size_t slot_count_;
+    std::vector<SlotId> free_;                        // Stack of free slots
 };
 
-} // namespace hsnet 
\ No newline at end of file
+} // namespace hsnet 
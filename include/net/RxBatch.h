@@ -0,0 +1,84 @@
+#pragma once
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace hsnet {
+
+// Preallocated receive slots filled by one recvmmsg() call, so a subscription
+// drains up to batch_size() datagrams per syscall instead of one.
+//
+// Slots either live in the batch's own storage or are pointed at buffers
+// owned by someone else (set_buffer()), e.g. reordering buffer slots, so
+// datagrams land where they are consumed.
+//
+// With `gro`, a slot may receive several datagrams coalesced by UDP_GRO (size
+// the slots for MAX_COALESCED_BYTES); segment_size() then reports where to
+// split them. With `timestamps` (SO_TIMESTAMPNS set on the socket)
+// receive_time_ns() reports when the kernel received each slot.
+//
+// Single consumer; no internal synchronization.
+class RxBatch {
+public:
+    // Largest buffer UDP_GRO hands to a socket in one read
+    static constexpr size_t MAX_COALESCED_BYTES = 0xFFFF;
+
+    // `slot_bytes` is the largest datagram accepted; longer ones are
+    // truncated. With slot_bytes == 0 no storage is allocated and every slot
+    // must be given a buffer with set_buffer() before receive().
+    RxBatch(size_t batch_size, size_t slot_bytes, bool gro = false, bool timestamps = false);
+
+    RxBatch(const RxBatch&) = delete;
+    RxBatch& operator=(const RxBatch&) = delete;
+
+    // Read whatever is queued on `sockfd` (up to `count`, at most
+    // batch_size() datagrams) without blocking. Returns the number received,
+    // 0 if none.
+    int receive(int sockfd, size_t count) noexcept;
+    int receive(int sockfd) noexcept { return receive(sockfd, batch_size()); }
+
+    size_t batch_size() const noexcept { return msgs_.size(); }
+
+    // Receive datagram `i` into [data, data + len) from now on
+    void set_buffer(size_t i, uint8_t* data, size_t len) noexcept {
+        iov_[i].iov_base = data;
+        iov_[i].iov_len = len;
+    }
+
+    // Datagram `i` of the last receive()
+    const uint8_t* data(size_t i) const noexcept { return static_cast<const uint8_t*>(iov_[i].iov_base); }
+    size_t length(size_t i) const noexcept { return msgs_[i].msg_len; }
+    bool truncated(size_t i) const noexcept { return (msgs_[i].msg_hdr.msg_flags & MSG_TRUNC) != 0; }
+    const sockaddr_in& source(size_t i) const noexcept { return sources_[i]; }
+
+    // Length of each coalesced datagram in slot `i` (the last may be
+    // shorter); length(i) when the slot holds a single datagram
+    size_t segment_size(size_t i) const noexcept;
+
+    // CLOCK_REALTIME nanoseconds the kernel stamped slot `i` with, 0 if none
+    uint64_t receive_time_ns(size_t i) const noexcept;
+
+private:
+    std::vector<uint8_t> storage_;
+    std::vector<iovec> iov_;
+    std::vector<mmsghdr> msgs_;
+    std::vector<sockaddr_in> sources_;
+
+    // Room for a UDP_GRO segment size and an SCM_TIMESTAMPNS
+    struct Control {
+        alignas(cmsghdr) char buf[CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(timespec))];
+    };
+    std::vector<Control> control_;  // Empty without gro or timestamps
+};
+
+// SCM_TIMESTAMPNS in the control data of a received message, as CLOCK_REALTIME
+// nanoseconds; 0 if it has none
+uint64_t receive_timestamp_ns(const msghdr& hdr) noexcept;
+
+} // namespace hsnet
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "Transport.h"
+
+namespace hsnet {
+
+// Same-host transport over memory-mapped log buffers. Each stream is a file
+// under `directory` (tmpfs by default) holding a ring of records, written by
+// one publication and read by up to ShmConfig::MAX_SUBSCRIBERS subscriptions,
+// in this process or any other that maps it. Nothing goes through the kernel
+// once the log is mapped: commit() is a store of the new tail, poll() a load.
+struct ShmConfig {
+    static constexpr uint32_t MAX_SUBSCRIBERS = 32;  // Per stream
+
+    std::string directory{"/dev/shm"};
+    std::string name{"hsnet"};         // Logs are <directory>/<name>-<stream>; a non-empty endpoint replaces name
+    uint32_t logBufferSize{1u << 22};  // Ring bytes per stream, rounded up to a power of two; all sides must agree
+};
+
+std::unique_ptr<ITransport> make_shm_transport(const ShmConfig& cfg);
+
+} // namespace hsnet
@@ -1,21 +1,25 @@
 #pragma once
 
 #include <cstdint>
-#include <functional>
 #include <memory>
 #include <span>
 #include <string_view>
 
+#include "FunctionRef.h"
+
 namespace hsnet {
 
 using StreamId = uint32_t;
 
+class LatencyHistogram;
+
 struct MessageView {
     const uint8_t* data;
-    uint16_t       length;
+    uint32_t       length;
     StreamId       streamId;
     uint64_t       sequenceNumber;
-    uint64_t       receiveTimeNs;
+    uint64_t       receiveTimeNs;  // CLOCK_REALTIME: the kernel's receive timestamp, else when polled
+    uint64_t       sendTimeNs;     // CLOCK_REALTIME when the publisher sent the frame, 0 if unknown
     bool           endOfMessage;
 };
 
@@ -27,11 +31,55 @@ enum class PublishResult : uint8_t {
     ERROR
 };
 
+// Receive-side counters, cumulative since the subscription was created
+struct SubscriptionStats {
+    uint64_t framesReceived{0};     // Datagrams read from the network, session frames excluded
+    uint64_t messagesDelivered{0};  // Messages handed to poll() handlers
+    uint64_t malformedFrames{0};    // Dropped: bad header or truncated
+    uint64_t crcFailures{0};        // Dropped: CRC32C mismatch
+    uint64_t windowOverruns{0};     // Dropped: beyond the reorder window (recovered by NAK)
+    uint64_t unknownStreams{0};     // Dropped: a stream beyond maxStreams
+    uint64_t receiveBatches{0};     // Receive syscalls that returned data
+    uint64_t naksSent{0};           // Retransmission requests for persistent gaps
+    uint64_t acksSent{0};           // Flow control acknowledgements to the sender
+    uint64_t heartbeatsReceived{0}; // Publisher liveness frames
+    uint64_t resets{0};             // Session starts and resets that cleared the reorder buffer
+    bool ioUring{false};            // Receiving through io_uring now, not sockets
+};
+
+// Send-side counters, cumulative since the publication was created
+struct PublicationStats {
+    uint64_t framesSent{0};              // Datagrams sent, retransmissions excluded
+    uint64_t messagesPacked{0};          // Messages coalesced into shared frames
+    uint64_t naksReceived{0};            // Retransmission requests from subscribers
+    uint64_t retransmits{0};             // Frames resent from the retransmit ring
+    uint64_t retransmitsSuppressed{0};   // Requested again shortly after being resent
+    uint64_t retransmitsUnavailable{0};  // Requested after leaving the ring
+    uint64_t acksReceived{0};            // Flow control acknowledgements from the receiver
+    uint64_t timeouts{0};                // Unacknowledged frames resent after an RTO
+    uint64_t rttNs{0};                   // Smoothed round-trip time, 0 before the first sample
+    uint64_t heartbeatsSent{0};          // Idle liveness frames
+    uint64_t resetsSent{0};              // Requested frames that had left the ring
+    bool ioUring{false};                 // Sending through io_uring now, not sockets
+};
+
 class ISubscription {
 public:
     virtual ~ISubscription() = default;
-    virtual int poll(std::function<void(const MessageView&)> handler, int maxMessages) noexcept = 0;
+    // The handler is called once per in-sequence message
+    virtual int poll(FunctionRef<void(const MessageView&)> handler, int maxMessages) noexcept = 0;
+    // The handler is called once per burst with the messages that became
+    // deliverable together; the views are valid until it returns
+    virtual int pollBatch(FunctionRef<void(std::span<const MessageView>)> handler, int maxMessages) noexcept {
+        return poll([&](const MessageView& v) { handler(std::span<const MessageView>(&v, 1)); }, maxMessages);
+    }
     virtual bool hasData() const noexcept = 0;
+    // True while the publisher is known to be alive
+    virtual bool isConnected() const noexcept { return true; }
+    virtual SubscriptionStats stats() const noexcept { return {}; }
+    // One-way latency of the stream's frames (kernel receive time minus
+    // publisher send time), nullptr unless receive timestamps are enabled
+    virtual const LatencyHistogram* latency(StreamId /*stream*/) const noexcept { return nullptr; }
 };
 
 class IPublication {
@@ -40,7 +88,35 @@ public:
     virtual PublishResult offer(std::span<const uint8_t> payload,
                                 StreamId streamId,
                                 bool endOfMessage = true) noexcept = 0;
+    // Payload bytes that can be offered now without BACKPRESSURED
     virtual uint64_t availableWindow() const noexcept = 0;
+
+    // Zero-copy publication. tryClaim() reserves room for a payload of up to
+    // `length` bytes directly in the publication's send buffer and returns it
+    // (empty if the message can't be claimed right now). Encode the message
+    // in place, then commit() the bytes actually used, or abort().
+    virtual std::span<uint8_t> tryClaim(size_t length) noexcept {
+        (void)length;
+        return {};
+    }
+    virtual PublishResult commit(size_t length, StreamId streamId, bool endOfMessage = true) noexcept {
+        (void)length;
+        (void)streamId;
+        (void)endOfMessage;
+        return PublishResult::ERROR;
+    }
+    virtual void abort() noexcept {}
+
+    // Send frames still queued for batching; returns how many went out.
+    // Publications that answer retransmission requests also serve them
+    // here, so call it periodically while idle. Publications that send every
+    // message immediately have nothing to do.
+    virtual int flush() noexcept { return 0; }
+
+    // False while offers would return NOTCONNECTED
+    virtual bool isConnected() const noexcept { return true; }
+
+    virtual PublicationStats stats() const noexcept { return {}; }
 };
 
 class ITransport {
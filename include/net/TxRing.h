@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Protocol.h"
+
+namespace hsnet {
+
+// Preallocated ring of fixed-size frame slots for outgoing datagrams.
+// Every slot reserves room for the protocol header in front of the payload,
+// so a message is encoded once, in place, and handed to the kernel from the
+// slot. Sent frames stay in their slot until the ring wraps around.
+//
+// Single producer; no internal synchronization.
+class TxRing {
+public:
+    // `slots` is rounded up to a power of two (at least two), each of
+    // `frame_capacity` bytes, header included
+    TxRing(size_t slots, size_t frame_capacity);
+
+    size_t slot_count() const noexcept { return mask_ + 1; }
+    size_t frame_capacity() const noexcept { return frame_capacity_; }
+    size_t max_payload() const noexcept { return frame_capacity_ - sizeof(proto::Header); }
+
+    // Frame slot for ring position `index` (positions grow forever; masked here)
+    uint8_t* frame(uint64_t index) noexcept { return storage_.data() + (index & mask_) * slot_stride_; }
+    const uint8_t* frame(uint64_t index) const noexcept {
+        return storage_.data() + (index & mask_) * slot_stride_;
+    }
+    uint8_t* payload(uint64_t index) noexcept { return frame(index) + sizeof(proto::Header); }
+
+    // Encoded length of the frame at `index`, set when it is committed
+    uint16_t frame_length(uint64_t index) const noexcept { return lengths_[index & mask_]; }
+    void set_frame_length(uint64_t index, uint16_t length) noexcept { lengths_[index & mask_] = length; }
+
+private:
+    size_t frame_capacity_;
+    size_t slot_stride_;  // frame_capacity_ rounded up to a cache line
+    size_t mask_;
+    std::vector<uint8_t> storage_;
+    std::vector<uint16_t> lengths_;
+};
+
+} // namespace hsnet
@@ -1,45 +1,124 @@
 #pragma once
 
 #include <memory>
+#include <span>
 #include <string>
+#include <vector>
 
+#include "DatagramSubscription.h"
 #include "Transport.h"
 
 namespace hsnet {
 
+// How the UDP transport talks to the kernel
+enum class IoBackend : uint8_t {
+    SOCKETS,   // sendmmsg()/recvmmsg()
+    IO_URING,  // Submission/completion rings; falls back to SOCKETS where io_uring is unavailable
+};
+
 struct UdpConfig {
-    std::string local_endpoint;   // "ip:port"
-    std::string remote_endpoint;  // "ip:port"
+    std::string local_endpoint;   // "ip:port"; with multicast the ip picks the interface
+    std::string remote_endpoint;  // "ip:port", or "multicast" for multicast_group:multicast_port
+    std::string multicast_group{"239.1.1.1"};
+    uint16_t multicast_port{8170};
     bool enable_crc32_c{false};
+    bool enable_gso{false};  // Send batched frames with UDP_SEGMENT when the kernel supports it
+    bool enable_gro{false};  // Accept UDP_GRO coalesced datagrams
+    bool enable_timestamps{false};  // Kernel receive timestamps (SO_TIMESTAMPNS) and per-stream latency histograms
     uint32_t stream_id{1};
     uint32_t mtu{1500};
     uint32_t recvRingSize{1u << 16};
-    uint32_t txRingSize{1u << 16};
-    uint32_t retransmitRingSize{1u << 15};
+    uint32_t txRingSize{1024};          // Frames queued for sending or in flight
+    uint32_t retransmitRingSize{7168};  // Sent frames kept for NAKs, on top of txRingSize
+    uint32_t recvBatchSize{32};       // Datagrams read per recvmmsg()
+    uint32_t reorderWindow{1024};     // Sequence numbers buffered ahead of delivery
+    uint32_t maxReorderWindow{16384}; // Growth cap for reorderWindow
+    uint32_t maxMessageSize{1u << 20};  // Largest message offered (its fragments must fit the TX ring) and reassembled
+    uint32_t sendBatchSize{1};        // Frames queued before a sendmmsg(); 1 = unbatched
+    uint64_t sendBatchLatencyNs{0};   // Max time a queued frame waits for its batch; 0 = until full or flush()
+    bool enable_coalescing{false};    // Pack small messages into shared frames
+    uint64_t coalesceDelayNs{10'000}; // Max time a packed message waits for more to join it
+    uint64_t nakDelayNs{100'000};     // Age of a gap before it is NAKed; 0 = never NAK
+    uint64_t nakRetryNs{1'000'000};   // Interval between NAKs while the gap stays open
+    uint64_t nakSuppressNs{250'000};  // Ignore NAKs for a frame resent this recently
+    uint64_t ackIntervalNs{10'000};   // Min time between flow control ACKs to the peer
+    uint64_t heartbeatIntervalNs{1'000'000};  // Idle time before a heartbeat; 0 = none
+    uint64_t livenessTimeoutNs{10'000'000};   // Peer silence before it counts as gone; 0 = never
+    uint32_t maxStreams{16};          // Streams received at once, each with its own reorder window
+    IoBackend ioBackend{IoBackend::SOCKETS};
+    bool ioUringSqPoll{false};        // A kernel thread polls the rings: no syscalls, but a core kept busy
+    uint32_t ioUringEntries{256};     // Submission queue depth, and receive buffers
+    uint32_t socketRecvBufferBytes{0};  // SO_RCVBUF; 0 = system default
+    uint32_t socketSendBufferBytes{0};  // SO_SNDBUF; 0 = system default
+    uint32_t busyPollUs{0};           // SO_BUSY_POLL: spin in the driver this long on an empty read; 0 = off
 };
 
 struct FeedPublisherConfig {
     std::string local_interface; // "ip" or empty for default
-    std::string multicast_group; // "ip"
+    std::string multicast_group{"239.1.1.1"}; // "ip"
     uint16_t port{8170};
     bool enable_crc32_c{false};
+    bool enable_gso{false};  // Send batched frames with UDP_SEGMENT when the kernel supports it
     uint32_t stream_id{1};
     uint32_t mtu{1500};
-    uint32_t txRingSize{1u << 16};
+    uint32_t txRingSize{1024};          // Frames queued for sending or in flight
+    uint32_t retransmitRingSize{7168};  // Sent frames kept for NAKs, on top of txRingSize
+    uint32_t maxMessageSize{1u << 20};  // Largest message offered; its fragments must fit the TX ring
+    uint32_t sendBatchSize{1};        // Frames queued before a sendmmsg(); 1 = unbatched
+    uint64_t sendBatchLatencyNs{0};   // Max time a queued frame waits for its batch; 0 = until full or flush()
+    bool enable_coalescing{false};    // Pack small messages into shared frames
+    uint64_t coalesceDelayNs{10'000}; // Max time a packed message waits for more to join it
+    uint64_t nakSuppressNs{250'000};  // Ignore NAKs for a frame resent this recently
+    uint64_t heartbeatIntervalNs{1'000'000};  // Idle time before a heartbeat; 0 = none
+    uint32_t socketRecvBufferBytes{0};  // SO_RCVBUF; 0 = system default
+    uint32_t socketSendBufferBytes{0};  // SO_SNDBUF; 0 = system default
+    uint32_t busyPollUs{0};           // SO_BUSY_POLL: spin in the driver this long on an empty read; 0 = off
 };
 
 struct FeedSubscriberConfig {
     std::string local_interface; // "ip" or empty for default
-    std::string multicast_group; // "ip"
+    std::string multicast_group{"239.1.1.1"}; // "ip"
+    std::vector<std::string> multicast_groups;  // Channels to join instead, all on `port`
     uint16_t port{8170};
     bool enable_crc32_c{false};
+    bool enable_gro{false};  // Accept UDP_GRO coalesced datagrams
+    bool enable_timestamps{false};  // Kernel receive timestamps (SO_TIMESTAMPNS) and per-stream latency histograms
     uint32_t stream_id{1};
     uint32_t mtu{1500};
     uint32_t recvRingSize{1u << 16};
+    uint32_t recvBatchSize{32};       // Datagrams read per recvmmsg()
+    uint32_t reorderWindow{1024};     // Sequence numbers buffered ahead of delivery
+    uint32_t maxReorderWindow{16384}; // Growth cap for reorderWindow
+    uint32_t maxMessageSize{1u << 20};  // Largest fragmented message reassembled
+    uint64_t nakDelayNs{100'000};     // Age of a gap before it is NAKed; 0 = never NAK
+    uint64_t nakRetryNs{1'000'000};   // Interval between NAKs while the gap stays open
+    uint64_t livenessTimeoutNs{10'000'000};  // Publisher silence before it counts as gone; 0 = never
+    uint32_t maxStreams{16};          // Streams received at once, each with its own reorder window
+    uint32_t socketRecvBufferBytes{0};  // SO_RCVBUF; 0 = system default
+    uint32_t socketSendBufferBytes{0};  // SO_SNDBUF; 0 = system default
+    uint32_t busyPollUs{0};           // SO_BUSY_POLL: spin in the driver this long on an empty read; 0 = off
+};
+
+// A feed partitioned across `count` multicast channels on one port: channel
+// i is the group `base_group` + i, and an instrument's data goes out on
+// channel instrument % count. Publishers run one publication per channel
+// (each with its own stream_id); subscribers join only the channels of the
+// instruments they want, and the kernel drops the rest.
+struct FeedChannels {
+    std::string base_group{"239.1.1.1"};
+    uint32_t count{1};
+
+    uint32_t channel_of(uint32_t instrument) const noexcept { return count > 1 ? instrument % count : 0; }
+    // Throws if base_group isn't a multicast address or the channel runs past the multicast range
+    std::string group(uint32_t channel) const;
+    // The distinct groups carrying `instruments`, for FeedSubscriberConfig::multicast_groups
+    std::vector<std::string> groups_for(std::span<const uint32_t> instruments) const;
 };
 
 std::unique_ptr<ITransport> make_udp_reliable_transport(const UdpConfig& cfg);
 
 std::unique_ptr<IPublication> make_udp_reliable_publisher(const FeedPublisherConfig& pub_cfg);
-std::unique_ptr<ISubscription> make_udp_reliable_subscriber(const FeedSubscriberConfig& sub_cfg);
+// Returns the concrete subscription so poll() can dispatch to the handler
+// statically; it converts to std::unique_ptr<ISubscription> as before.
+std::unique_ptr<DatagramSubscription> make_udp_reliable_subscriber(const FeedSubscriberConfig& sub_cfg);
 } // namespace hsnet
\ No newline at end of file
@@ -34,6 +34,7 @@ void signal_handler(int signum) {
         // Logger::getInstance().info("Found " + std::to_string(matches) + " matches.");
         std::cout << "Ctrl+C detected! Exiting gracefully..." << std::endl;
         std::cout << "Found " << matches << " matches." << std::endl;
+        Logger::getInstance().flush();
         exit(signum);  // Terminate the program with the signal code
     }
 }
@@ -2,6 +2,7 @@
 #include <iomanip>
 
 #include "Order.h"
+#include "TscClock.h"
 
 const uint32_t Order::getId() const {
     return oid;
@@ -38,7 +39,7 @@ Side Order::getSide() const { return this->side; }
 std::optional<double> Order::getPrice() const { return this->price; }
 Type Order::getType() const { return this->order_type; }
 uint32_t Order::getSize() const { return this->order_size; }
-std::chrono::steady_clock::time_point Order::getTimestamp() const {
+uint64_t Order::getTimestamp() const {
     return this->timestamp;
 }
 
@@ -60,7 +61,7 @@ side(side),
 order_type(orderType),
 price(price),
 order_size(order_size),
-timestamp(std::chrono::steady_clock::now())
+timestamp(TscClock::now())
 {
     if (side != BUY && side != SELL) {
         std::cerr << "Bad side value: " << static_cast<int>(side) << std::endl;
@@ -1,7 +1,6 @@
 #include "OrderBook.h"
 
 #include <algorithm>
-#include <format>
 #include <cassert>
 #include "Logger.h"
 
@@ -12,14 +11,11 @@ int getMatches() {
 }
 
 void OrderBook::executeTrade(Order& bid, Order& ask, uint32_t fill_qty) {
-    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
-        std::chrono::steady_clock::now() - bid.getTimestamp()).count();
-    Logger& logger = Logger::getInstance();
-    // Log the trade execution
+    const uint64_t latency = TscClock::elapsedNs(bid.getTimestamp()) / 1000;
+    // Log the trade execution (formatted off the matching thread)
     if (ask.getPrice().has_value()) {
-        std::string trade_info = std::format("Trade executed: {} units at price {:.2f} {:} (Latency: {}µs)",
-                                     fill_qty, ask.getPrice().value(), 4, latency);
-        logger.info(trade_info);
+        HFT_LOG_INFO("Trade executed: {} units at price {:.2f} {:} (Latency: {}µs)",
+                fill_qty, ask.getPrice().value(), 4, latency);
     }
 
     bid.setSize(bid.getSize() - fill_qty);
@@ -39,7 +35,8 @@ void OrderBook::match_market_order(Order& order) {
             // Loop through orders at given price orders using this iterator
             auto& asksAtPrice = askIter->second;
             auto& ask = asksAtPrice.front();
-            // printf("Matching order! [LIMIT ORDER] %d x %d [MARKET]\n", ask.getSize(), order.getSize());
+            HFT_LOG_DEBUG("Matching order {} against ask {}: {} x {}", order.getId(), ask.getId(), ask.getSize(),
+                          order.getSize());
             uint32_t fill_qty = std::min(ask.getSize(), order.getSize());
 
             uint32_t rem_asks = ask.getSize() - fill_qty;
@@ -64,7 +61,8 @@ void OrderBook::match_market_order(Order& order) {
             // Loop through orders at given price orders using this iterator
             auto& bidsAtPrice = bidIter->second;
             auto& bid = bidsAtPrice.front();
-            // printf("Matching order! [LIMIT ORDER] %d x %d [MARKET]\n", bid.getSize(), order.getSize());
+            HFT_LOG_DEBUG("Matching order {} against bid {}: {} x {}", order.getId(), bid.getId(), bid.getSize(),
+                          order.getSize());
             uint32_t fill_qty = std::min(bid.getSize(), order.getSize());
 
             uint32_t rem_bids = bid.getSize() - fill_qty;
@@ -0,0 +1,157 @@
+#include "TscClock.h"
+
+#include <atomic>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace {
+constexpr uint64_t kInitialWindowNs = 2'000'000;  // Spin this long for the first estimate
+constexpr uint64_t kRefreshNs = 1'000'000'000;    // maybeRecalibrate() interval
+constexpr int kSampleAttempts = 8;
+
+struct Sample {
+    uint64_t ticks;
+    uint64_t mono_ns;
+};
+
+// Read the counter on both sides of CLOCK_MONOTONIC and keep the tightest
+// bracket, so a preemption during one attempt doesn't skew the sample
+Sample takeSample() noexcept {
+    Sample best{};
+    uint64_t best_width = UINT64_MAX;
+    for (int i = 0; i < kSampleAttempts; ++i) {
+        const uint64_t t0 = TscClock::now();
+        const uint64_t ns = TscClock::monotonicNs();
+        const uint64_t t1 = TscClock::now();
+        if (t1 - t0 < best_width) {
+            best_width = t1 - t0;
+            best = {t0 + (t1 - t0) / 2, ns};
+        }
+    }
+    return best;
+}
+
+// Conversion parameters, published with a seqlock so readers on any thread
+// never block and never see a torn set:
+//   mono_ns = base_ns + (ticks - base_ticks) * mult / 2^32
+class Calibration {
+   public:
+    struct Params {
+        uint64_t base_ticks;
+        uint64_t base_ns;
+        uint64_t mult;           // ns per tick, 32.32 fixed point
+        int64_t real_offset_ns;  // CLOCK_REALTIME - CLOCK_MONOTONIC
+    };
+
+    Calibration() {
+        anchor_ = takeSample();
+        while (TscClock::monotonicNs() - anchor_.mono_ns < kInitialWindowNs) {
+        }
+        update();
+    }
+
+    Params read() const noexcept {
+        Params p;
+        uint64_t seq;
+        do {
+            seq = seq_.load(std::memory_order_acquire);
+            p.base_ticks = base_ticks_.load(std::memory_order_relaxed);
+            p.base_ns = base_ns_.load(std::memory_order_relaxed);
+            p.mult = mult_.load(std::memory_order_relaxed);
+            p.real_offset_ns = real_offset_ns_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((seq & 1) != 0 || seq != seq_.load(std::memory_order_relaxed));
+        return p;
+    }
+
+    // Rate over the whole window since the anchor, rebased at the newest sample
+    void update() noexcept {
+        if (updating_.test_and_set(std::memory_order_acquire)) return;  // Someone else is on it
+        const int64_t real_offset = static_cast<int64_t>(TscClock::wallNs() - TscClock::monotonicNs());
+        const Sample s = takeSample();
+        const uint64_t dticks = s.ticks - anchor_.ticks;
+        const uint64_t dns = s.mono_ns - anchor_.mono_ns;
+        const uint64_t mult = dticks == 0 ? (1ull << 32)
+                                          : static_cast<uint64_t>((static_cast<unsigned __int128>(dns) << 32) / dticks);
+
+        const uint64_t seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        base_ticks_.store(s.ticks, std::memory_order_relaxed);
+        base_ns_.store(s.mono_ns, std::memory_order_relaxed);
+        mult_.store(mult, std::memory_order_relaxed);
+        real_offset_ns_.store(real_offset, std::memory_order_relaxed);
+        seq_.store(seq + 2, std::memory_order_release);
+
+        const uint64_t refresh_ticks = static_cast<uint64_t>((static_cast<unsigned __int128>(kRefreshNs) << 32) / mult);
+        next_refresh_ticks_.store(s.ticks + refresh_ticks, std::memory_order_relaxed);
+        updating_.clear(std::memory_order_release);
+    }
+
+    bool due(uint64_t ticks) const noexcept { return ticks >= next_refresh_ticks_.load(std::memory_order_relaxed); }
+
+   private:
+    Sample anchor_{};
+    std::atomic<uint64_t> seq_{0};
+    std::atomic<uint64_t> base_ticks_{0};
+    std::atomic<uint64_t> base_ns_{0};
+    std::atomic<uint64_t> mult_{1ull << 32};
+    std::atomic<int64_t> real_offset_ns_{0};
+    std::atomic<uint64_t> next_refresh_ticks_{0};
+    std::atomic_flag updating_ = ATOMIC_FLAG_INIT;
+};
+
+Calibration& calibration() {
+    static Calibration instance;
+    return instance;
+}
+
+uint64_t scale(uint64_t ticks, uint64_t mult) noexcept {
+    return static_cast<uint64_t>((static_cast<unsigned __int128>(ticks) * mult) >> 32);
+}
+}  // namespace
+
+uint64_t TscClock::toNs(uint64_t ticks) noexcept {
+    const Calibration::Params p = calibration().read();
+    // Ticks taken before the latest rebase are negative offsets
+    const auto delta = static_cast<int64_t>(ticks - p.base_ticks);
+    return p.base_ns + static_cast<uint64_t>((static_cast<__int128>(delta) * p.mult) >> 32);
+}
+
+uint64_t TscClock::toRealtimeNs(uint64_t ticks) noexcept {
+    const Calibration::Params p = calibration().read();
+    const auto delta = static_cast<int64_t>(ticks - p.base_ticks);
+    return p.base_ns + static_cast<uint64_t>(p.real_offset_ns) +
+           static_cast<uint64_t>((static_cast<__int128>(delta) * p.mult) >> 32);
+}
+
+uint64_t TscClock::ticksToNs(uint64_t ticks) noexcept {
+    return scale(ticks, calibration().read().mult);
+}
+
+void TscClock::recalibrate() noexcept {
+    calibration().update();
+}
+
+void TscClock::maybeRecalibrate() noexcept {
+    Calibration& c = calibration();
+    if (c.due(now())) c.update();
+}
+
+double TscClock::frequencyHz() noexcept {
+    return 1e9 * static_cast<double>(1ull << 32) / static_cast<double>(calibration().read().mult);
+}
+
+bool TscClock::invariant() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned eax, ebx, ecx, edx;
+    if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) == 0) return false;
+    return (edx & (1u << 8)) != 0;
+#elif defined(__aarch64__)
+    return true;  // The generic timer runs at a fixed frequency
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,279 @@
+#include "net/DatagramSubscription.h"
+
+#include <sys/socket.h>
+
+#include <bit>
+
+#include "net/Protocol.h"
+
+namespace hsnet {
+
+static_assert(proto::NAK_FRAME_BYTES >= proto::ACK_FRAME_BYTES &&
+              proto::NAK_FRAME_BYTES >= proto::SESSION_FRAME_BYTES);
+
+DatagramSubscription::Stream::Stream(StreamId stream_id, const DatagramSubscriptionConfig& cfg, size_t spare_slots)
+    : id(stream_id),
+      reorder_buffer(cfg.reorderWindow, cfg.mtu, spare_slots, cfg.maxReorderWindow, cfg.maxMessageSize) {}
+
+DatagramSubscription::DatagramSubscription(const DatagramSubscriptionConfig& cfg)
+    : cfg_(cfg),
+      crc_(cfg.crc),
+      gro_(cfg.gro),
+      timestamps_(cfg.timestamps),
+      batch_(cfg.recvBatchSize, cfg.gro ? RxBatch::MAX_COALESCED_BYTES : 0, cfg.gro, cfg.timestamps),
+      batch_slots_(cfg.gro ? 0 : batch_.batch_size()),
+      views_(std::max<size_t>(batch_.batch_size(), 64)),
+      table_(std::bit_ceil(2 * static_cast<size_t>(std::max<uint32_t>(cfg.maxStreams, 1))), -1),
+      table_mask_(table_.size() - 1),
+      nak_delay_ns_(cfg.nakDelayNs),
+      nak_retry_ns_(cfg.nakRetryNs),
+      acks_(cfg.acks),
+      ack_interval_ns_(cfg.ackIntervalNs),
+      liveness_timeout_ns_(cfg.livenessTimeoutNs) {
+    cfg_.maxStreams = std::max<uint32_t>(cfg.maxStreams, 1);
+    streams_.reserve(cfg_.maxStreams);
+    rx_stream_ = find_or_add(cfg.stream);
+    if (cfg.ioUring) {
+        uring_ = std::make_unique<IoUringRx>(cfg.ioUringEntries, cfg.mtu, cfg.sqPoll, cfg.timestamps);
+        if (!uring_->ok()) uring_.reset();
+    }
+}
+
+const DatagramSubscription::Stream* DatagramSubscription::find(StreamId stream) const noexcept {
+    // Consecutive frames are mostly of one stream
+    if (rx_stream_ != nullptr && rx_stream_->id == stream) return rx_stream_;
+    for (size_t i = table_index(stream);; i = (i + 1) & table_mask_) {
+        const int32_t index = table_[i];
+        if (index < 0) return nullptr;
+        if (streams_[index]->id == stream) return streams_[index].get();
+    }
+}
+
+DatagramSubscription::Stream* DatagramSubscription::find_or_add(StreamId stream) {
+    if (Stream* s = find(stream)) return s;
+    if (streams_.size() >= cfg_.maxStreams) return nullptr;
+    // The table is at most half full, so probing always ends at an empty entry
+    size_t i = table_index(stream);
+    while (table_[i] >= 0) i = (i + 1) & table_mask_;
+    table_[i] = static_cast<int32_t>(streams_.size());
+    streams_.push_back(std::make_unique<Stream>(stream, cfg_, batch_.batch_size()));
+    return streams_.back().get();
+}
+
+int DatagramSubscription::receive_in_place() noexcept {
+    Stream* pool = rx_stream_;
+    size_t slots = 0;
+    while (slots < batch_slots_.size()) {
+        const ReorderingBuffer::SlotId slot = pool->reorder_buffer.acquire();
+        if (slot == ReorderingBuffer::NO_SLOT) break;
+        batch_slots_[slots] = slot;
+        batch_.set_buffer(slots++, pool->reorder_buffer.slot_data(slot), pool->reorder_buffer.slot_bytes());
+    }
+    const int received = batch_.receive(sockfd_, slots);
+    if (received > 0) stats_.receiveBatches++;
+    for (size_t i = 0; i < slots; ++i) {
+        if (i < static_cast<size_t>(received)) {
+            accept(batch_.data(i), batch_.length(i), batch_.truncated(i), pool, batch_slots_[i], batch_.source(i),
+                   batch_.receive_time_ns(i));
+        } else {
+            pool->reorder_buffer.release(batch_slots_[i]);
+        }
+    }
+    return received;
+}
+
+int DatagramSubscription::receive_coalesced() noexcept {
+    const int received = batch_.receive(sockfd_);
+    if (received > 0) stats_.receiveBatches++;
+    for (int i = 0; i < received; ++i) {
+        const uint8_t* data = batch_.data(i);
+        const size_t length = batch_.length(i);
+        const size_t segment = batch_.segment_size(i);
+        const uint64_t received_ns = batch_.receive_time_ns(i);
+        for (size_t off = 0; off < length; off += segment) {
+            accept(data + off, std::min(segment, length - off), batch_.truncated(i), nullptr,
+                   ReorderingBuffer::NO_SLOT, batch_.source(i), received_ns);
+        }
+    }
+    return received;
+}
+
+int DatagramSubscription::receive_uring() noexcept {
+    if (!uring_->ok()) {  // The kernel turned the requests down: back to recvmmsg()
+        uring_.reset();
+        return receive();
+    }
+    const int received = uring_->receive(
+        sockfd_, [this](const uint8_t* data, size_t length, bool truncated, const sockaddr_in& source,
+                        uint64_t received_ns) {
+            accept(data, length, truncated, nullptr, ReorderingBuffer::NO_SLOT, source, received_ns);
+        });
+    if (received > 0) stats_.receiveBatches++;
+    return received;
+}
+
+void DatagramSubscription::accept(const uint8_t* frame, size_t n, bool truncated, Stream* pool,
+                                  ReorderingBuffer::SlotId slot, const sockaddr_in& source,
+                                  uint64_t received_ns) noexcept {
+    const auto release = [&] {
+        if (slot != ReorderingBuffer::NO_SLOT) pool->reorder_buffer.release(slot);
+    };
+    proto::Header header{};
+    bool valid = true;
+    if (truncated || n < sizeof(header) || !proto::parse_header(frame, header) ||
+        n < sizeof(header) + header.payload_length) {
+        stats_.malformedFrames++;
+        valid = false;
+    } else if (crc_ && (proto::frame_flags(header) & proto::FLAG_CRC32C) &&
+               !proto::verify_frame_crc(frame, sizeof(header) + header.payload_length, header)) {
+        // Corrupt frames never reach the reordering buffer
+        stats_.crcFailures++;
+        valid = false;
+    }
+    const bool data = valid && proto::frame_type(header) == proto::FrameType::DATA;
+    if (!valid || data) stats_.framesReceived++;
+    Stream* s = valid ? find_or_add(header.stream_id) : nullptr;
+    if (valid && s == nullptr) stats_.unknownStreams++;
+    if (s == nullptr) {
+        release();
+        return;
+    }
+
+    s->source = source;
+    s->have_source = true;
+    s->last_heard = TscClock::now();
+    if (!data) {
+        on_session_frame(*s, header, frame + sizeof(header));
+        release();
+        return;
+    }
+    s->ack_pending = true;  // Duplicates too: the sender is resending for want of an ACK
+
+    const ReorderingBuffer::Fragment fragment{header.fragment_index, header.fragments_total,
+                                              (proto::frame_flags(header) & proto::FLAG_CONTINUED) == 0};
+    const bool batched = (proto::frame_flags(header) & proto::FLAG_BATCHED) != 0;
+    const FrameTimes times{header.send_time_ns, received_ns};
+    bool added;
+    if (s == pool) {
+        added = s->reorder_buffer.add(header.sequence_number, slot, sizeof(header), header.payload_length,
+                                      header.stream_id, fragment, batched, times);
+    } else {
+        // Received into another stream's slot (or a GRO staging buffer)
+        added = s->reorder_buffer.add(header.sequence_number, {frame + sizeof(header), header.payload_length},
+                                      header.stream_id, fragment, batched, times);
+        release();
+    }
+    // Clocks a little apart across hosts can make it look negative
+    if (added && received_ns != 0 && header.send_time_ns != 0) {
+        s->latency.record(received_ns > header.send_time_ns ? received_ns - header.send_time_ns : 0);
+    }
+    rx_stream_ = s;  // The next read most likely continues this stream
+}
+
+void DatagramSubscription::check_gaps(Stream& s) noexcept {
+    // Anything buffered beyond the in-sequence run sits behind a gap, as does
+    // anything the publisher has announced but we haven't received
+    const ReorderingBuffer& rb = s.reorder_buffer;
+    if (nak_delay_ns_ == 0 || !s.have_source ||
+        (rb.size() == rb.ready_count() && rb.first_gap() >= s.sender_next)) {
+        s.gap_open = false;
+        return;
+    }
+    const uint64_t gap = rb.first_gap();
+    if (!s.gap_open || gap != s.gap_seq) {
+        s.gap_open = true;
+        s.gap_seq = gap;
+        s.gap_since = TscClock::now();
+        s.last_nak = 0;
+        return;
+    }
+    if (TscClock::elapsedNs(s.gap_since) < nak_delay_ns_) return;
+    if (s.last_nak != 0 && TscClock::elapsedNs(s.last_nak) < nak_retry_ns_) return;
+    send_nak(s);
+    s.last_nak = TscClock::now();
+}
+
+void DatagramSubscription::send_nak(Stream& s) noexcept {
+    const size_t count = s.reorder_buffer.missing_ranges(nak_ranges_, s.sender_next);
+    if (count == 0) return;
+    proto::Header header{};
+    header.stream_id = s.id;
+    proto::set_type_flags(header, proto::FrameType::NAK, crc_ ? proto::FLAG_CRC32C : 0);
+    const size_t len = proto::write_nak_frame(control_frame_.data(), header, {nak_ranges_.data(), count});
+    if (send_control(s, control_frame_.data(), len)) stats_.naksSent++;
+}
+
+void DatagramSubscription::on_session_frame(Stream& s, const proto::Header& header, const uint8_t* payload) noexcept {
+    uint64_t session = 0;
+    if (!proto::read_session_id(payload, header.payload_length, session)) return;
+    const uint64_t seq = header.sequence_number;
+    switch (proto::frame_type(header)) {
+        case proto::FrameType::HELLO: {
+            if (session != s.session_id) start_session(s, session, seq);
+            proto::Header reply{};
+            reply.sequence_number = s.reorder_buffer.next_expected();
+            reply.stream_id = s.id;
+            proto::set_type_flags(reply, proto::FrameType::HELLO, crc_ ? proto::FLAG_CRC32C : 0);
+            const size_t len =
+                proto::write_session_frame(control_frame_.data(), reply, proto::FrameType::HELLO, s.session_id);
+            send_control(s, control_frame_.data(), len);
+            break;
+        }
+        case proto::FrameType::HEARTBEAT:
+            stats_.heartbeatsReceived++;
+            if (s.session_id == 0) {
+                s.session_id = session;  // Joined after the HELLO; recover from the start via NAKs
+            } else if (session != s.session_id) {
+                start_session(s, session, seq);  // The publisher restarted while we weren't looking
+            }
+            s.sender_next = std::max(s.sender_next, seq);
+            break;
+        case proto::FrameType::RESET:
+            // Only subscribers still waiting for frames before `seq` lose anything
+            if ((session == s.session_id || s.session_id == 0) && s.reorder_buffer.next_expected() < seq) {
+                start_session(s, session, seq);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void DatagramSubscription::start_session(Stream& s, uint64_t session_id, uint64_t sequence) noexcept {
+    s.session_id = session_id;
+    s.reorder_buffer.clear(sequence);
+    s.sender_next = sequence;
+    s.gap_open = false;
+    stats_.resets++;
+}
+
+void DatagramSubscription::maybe_ack(Stream& s) noexcept {
+    if (!s.have_source || (!s.ack_pending && s.delivered == s.acked_delivered)) return;
+    if (s.last_ack != 0 && TscClock::elapsedNs(s.last_ack) < ack_interval_ns_) return;
+    if (socket_window_ == 0) {
+        // The kernel reports the doubled size that covers its own overhead
+        int rcvbuf = 0;
+        socklen_t len = sizeof(rcvbuf);
+        getsockopt(sockfd_, SOL_SOCKET, SO_RCVBUF, &rcvbuf, &len);
+        socket_window_ = std::max<uint64_t>(static_cast<uint64_t>(std::max(rcvbuf, 0)) / (2 * cfg_.mtu), 1);
+    }
+    // The socket buffer is shared by all streams
+    ctrl::Ack ack = s.reorder_buffer.ack();
+    ack.receive_window = std::min<uint64_t>(ack.receive_window, std::max<uint64_t>(socket_window_ / streams_.size(), 1));
+    proto::Header header{};
+    header.stream_id = s.id;
+    proto::set_type_flags(header, proto::FrameType::ACK, crc_ ? proto::FLAG_CRC32C : 0);
+    const size_t len = proto::write_ack_frame(control_frame_.data(), header, ack);
+    if (send_control(s, control_frame_.data(), len)) {
+        stats_.acksSent++;
+        s.ack_pending = false;
+        s.acked_delivered = s.delivered;
+        s.last_ack = TscClock::now();
+    }
+}
+
+bool DatagramSubscription::send_control(const Stream& s, const uint8_t* frame, size_t len) noexcept {
+    return sendto(sockfd_, frame, len, 0, reinterpret_cast<const sockaddr*>(&s.source), sizeof(s.source)) > 0;
+}
+
+} // namespace hsnet
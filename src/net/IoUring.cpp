@@ -0,0 +1,163 @@
+#include "net/IoUring.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+
+namespace hsnet {
+
+namespace {
+// Idle time before the SQPOLL thread sleeps and submit() has to wake it
+constexpr unsigned SQ_THREAD_IDLE_MS = 1000;
+
+void* map_ring(int fd, size_t bytes, off_t offset) noexcept {
+    void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+template <typename T>
+T* field(void* base, uint32_t offset) noexcept {
+    return reinterpret_cast<T*>(static_cast<uint8_t*>(base) + offset);
+}
+}  // namespace
+
+IoUring::IoUring(unsigned entries, bool sq_poll) : sq_poll_(sq_poll) {
+    io_uring_params params{};
+    if (sq_poll) {
+        params.flags |= IORING_SETUP_SQPOLL;
+        params.sq_thread_idle = SQ_THREAD_IDLE_MS;
+    }
+    fd_ = static_cast<int>(syscall(__NR_io_uring_setup, std::max(entries, 1u), &params));
+    if (fd_ < 0) return;
+
+    sq_map_bytes_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_map_bytes_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_map = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_map) sq_map_bytes_ = cq_map_bytes_ = std::max(sq_map_bytes_, cq_map_bytes_);
+    sq_map_ = map_ring(fd_, sq_map_bytes_, IORING_OFF_SQ_RING);
+    cq_map_ = single_map ? sq_map_ : map_ring(fd_, cq_map_bytes_, IORING_OFF_CQ_RING);
+    sqes_bytes_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe*>(map_ring(fd_, sqes_bytes_, IORING_OFF_SQES));
+    if (sq_map_ == nullptr || cq_map_ == nullptr || sqes_ == nullptr) {
+        unmap();
+        close(fd_);
+        fd_ = -1;
+        return;
+    }
+
+    sq_head_ = field<unsigned>(sq_map_, params.sq_off.head);
+    sq_tail_ = field<unsigned>(sq_map_, params.sq_off.tail);
+    sq_flags_ = field<unsigned>(sq_map_, params.sq_off.flags);
+    sq_array_ = field<unsigned>(sq_map_, params.sq_off.array);
+    sq_mask_ = *field<unsigned>(sq_map_, params.sq_off.ring_mask);
+    sq_entries_ = params.sq_entries;
+    sqe_tail_ = *sq_tail_;
+
+    cq_head_ = field<unsigned>(cq_map_, params.cq_off.head);
+    cq_tail_ = field<unsigned>(cq_map_, params.cq_off.tail);
+    cq_mask_ = *field<unsigned>(cq_map_, params.cq_off.ring_mask);
+    cqes_ = field<io_uring_cqe>(cq_map_, params.cq_off.cqes);
+}
+
+IoUring::~IoUring() {
+    unmap();
+    if (fd_ >= 0) close(fd_);
+}
+
+void IoUring::unmap() noexcept {
+    if (sqes_ != nullptr) munmap(sqes_, sqes_bytes_);
+    if (cq_map_ != nullptr && cq_map_ != sq_map_) munmap(cq_map_, cq_map_bytes_);
+    if (sq_map_ != nullptr) munmap(sq_map_, sq_map_bytes_);
+    sqes_ = nullptr;
+    cq_map_ = sq_map_ = nullptr;
+}
+
+io_uring_sqe* IoUring::get_sqe() noexcept {
+    const unsigned head = std::atomic_ref<unsigned>(*sq_head_).load(std::memory_order_acquire);
+    if (sqe_tail_ - head >= sq_entries_) return nullptr;
+    const unsigned index = sqe_tail_ & sq_mask_;
+    sq_array_[index] = index;
+    sqe_tail_++;
+    io_uring_sqe* sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+int IoUring::submit() noexcept {
+    // Includes SQEs an earlier submit() couldn't hand over
+    const unsigned to_submit = sqe_tail_ - std::atomic_ref<unsigned>(*sq_head_).load(std::memory_order_acquire);
+    if (to_submit == 0) return 0;
+    std::atomic_ref<unsigned>(*sq_tail_).store(sqe_tail_, std::memory_order_release);
+    if (!sq_poll_) return enter(to_submit, 0);
+    // The tail store must be visible before the thread's sleep flag is read
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (std::atomic_ref<unsigned>(*sq_flags_).load(std::memory_order_relaxed) & IORING_SQ_NEED_WAKEUP) {
+        const int woken = enter(0, IORING_ENTER_SQ_WAKEUP);
+        if (woken < 0) return woken;
+    }
+    return static_cast<int>(to_submit);
+}
+
+void IoUring::flush_overflow() noexcept { enter(0, IORING_ENTER_GETEVENTS); }
+
+int IoUring::enter(unsigned to_submit, unsigned flags) noexcept {
+    const long r = syscall(__NR_io_uring_enter, fd_, to_submit, 0, flags, nullptr, 0);
+    return r < 0 ? -errno : static_cast<int>(r);
+}
+
+IoUringRx::IoUringRx(unsigned buffers, size_t datagram_bytes, bool sq_poll, bool timestamps)
+    : ring_(std::clamp(buffers, 2u, MAX_BUFFERS), sq_poll),
+      headroom_(sizeof(io_uring_recvmsg_out) + sizeof(sockaddr_in) + (timestamps ? CMSG_SPACE(sizeof(timespec)) : 0)),
+      buffer_bytes_(headroom_ + datagram_bytes) {
+    const unsigned count = std::clamp(buffers, 2u, MAX_BUFFERS);
+    storage_.resize(static_cast<size_t>(count) * buffer_bytes_);
+    returned_.reserve(count);
+    msg_.msg_namelen = sizeof(sockaddr_in);
+    msg_.msg_controllen = timestamps ? CMSG_SPACE(sizeof(timespec)) : 0;
+    if (ring_.ok() && (!provide(0, count) || ring_.submit() < 0)) failed_ = true;
+}
+
+bool IoUringRx::provide(uint16_t bid, unsigned count) noexcept {
+    io_uring_sqe* sqe = ring_.get_sqe();
+    if (sqe == nullptr) return false;
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = static_cast<int32_t>(count);
+    sqe->addr = reinterpret_cast<uint64_t>(storage_.data() + static_cast<size_t>(bid) * buffer_bytes_);
+    sqe->len = static_cast<uint32_t>(buffer_bytes_);
+    sqe->off = bid;
+    sqe->buf_group = GROUP;
+    sqe->user_data = PROVIDE;
+    return true;
+}
+
+void IoUringRx::replenish(int sockfd) noexcept {
+    // Buffers mostly come back in the order they were handed out
+    size_t done = 0;
+    for (size_t i = 0; i < returned_.size();) {
+        size_t run = 1;
+        while (i + run < returned_.size() && returned_[i + run] == returned_[i] + run) ++run;
+        if (!provide(returned_[i], static_cast<unsigned>(run))) break;
+        i += run;
+        done = i;
+    }
+    returned_.erase(returned_.begin(), returned_.begin() + static_cast<std::ptrdiff_t>(done));
+    if (!armed_ && !failed_) {
+        if (io_uring_sqe* sqe = ring_.get_sqe()) {
+            sqe->opcode = IORING_OP_RECVMSG;
+            sqe->fd = sockfd;
+            sqe->addr = reinterpret_cast<uint64_t>(&msg_);
+            sqe->len = 1;
+            sqe->flags = IOSQE_BUFFER_SELECT;
+            sqe->buf_group = GROUP;
+            sqe->ioprio = IORING_RECV_MULTISHOT;
+            sqe->user_data = RECV;
+            armed_ = true;
+        }
+    }
+    ring_.submit();  // Whatever the kernel doesn't take now goes with the next one
+}
+
+} // namespace hsnet
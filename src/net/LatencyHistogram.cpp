@@ -0,0 +1,34 @@
+#include "net/LatencyHistogram.h"
+
+#include <cmath>
+
+namespace hsnet {
+
+uint64_t LatencyHistogram::bucket_upper(size_t index) noexcept {
+    if (index < SUB_COUNT) return index;
+    const size_t shift = index / SUB_COUNT - 1;
+    const uint64_t lower = static_cast<uint64_t>(SUB_COUNT + index % SUB_COUNT) << shift;
+    return lower + (uint64_t{1} << shift) - 1;
+}
+
+uint64_t LatencyHistogram::percentile(double fraction) const noexcept {
+    if (count_ == 0) return 0;
+    const double clamped = std::clamp(fraction, 0.0, 1.0);
+    const uint64_t rank = std::max<uint64_t>(static_cast<uint64_t>(std::ceil(clamped * static_cast<double>(count_))), 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        seen += buckets_[i];
+        if (seen >= rank) return std::clamp(bucket_upper(i), min_, max_);
+    }
+    return max_;
+}
+
+void LatencyHistogram::reset() noexcept {
+    buckets_.fill(0);
+    count_ = 0;
+    sum_ = 0;
+    min_ = UINT64_MAX;
+    max_ = 0;
+}
+
+} // namespace hsnet
@@ -0,0 +1,444 @@
+#include "net/NetworkAgent.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <stdexcept>
+#include <string>
+
+#include "TscClock.h"
+
+namespace hsnet {
+
+namespace {
+static constexpr size_t CACHE_LINE = 64;
+// How often the agent refreshes the snapshots the application side reads
+static constexpr uint64_t SNAPSHOT_INTERVAL_NS = 1'000'000;
+
+inline void cpu_pause() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Single-producer/single-consumer ring of variable-length records, one
+// message each. Positions are byte offsets that grow forever and are masked
+// into the ring. Records are whole cache lines and never wrap: one that
+// doesn't fit before the end of the ring is preceded by a padding record
+// filling it, which always has room for its header.
+class MessageRing {
+   public:
+    struct Record {
+        uint32_t length;  // Payload bytes after the header
+        uint32_t span;    // Bytes to the next record
+        StreamId stream;
+        uint32_t flags;
+        uint64_t sequence;
+        uint64_t receive_ns;
+        uint64_t send_ns;
+
+        uint8_t* payload() noexcept { return reinterpret_cast<uint8_t*>(this + 1); }
+    };
+    static constexpr uint32_t PADDING = 0x01;
+    static constexpr uint32_t END_OF_MESSAGE = 0x02;
+
+    explicit MessageRing(size_t capacity)
+        : capacity_(std::bit_ceil(std::max<size_t>(capacity, 4096))),
+          buffer_(new (std::align_val_t{CACHE_LINE}) uint8_t[capacity_]) {}
+    ~MessageRing() { ::operator delete[](buffer_, std::align_val_t{CACHE_LINE}); }
+
+    MessageRing(const MessageRing&) = delete;
+    MessageRing& operator=(const MessageRing&) = delete;
+
+    static size_t record_bytes(size_t length) noexcept {
+        return (sizeof(Record) + length + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    }
+    // Largest payload claim() accepts, so one record never holds the ring alone
+    size_t max_payload() const noexcept { return capacity_ / 4 - sizeof(Record); }
+
+    // Producer: room for a record with `length` payload bytes, nullptr if
+    // the ring is full; fill it in, then publish()
+    Record* claim(size_t length) noexcept {
+        if (length > max_payload()) return nullptr;
+        const size_t bytes = record_bytes(length);
+        const size_t to_end = capacity_ - (tail_ & (capacity_ - 1));
+        const size_t needed = bytes + (to_end < bytes ? to_end : 0);
+        if (tail_ + needed - head_cache_ > capacity_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail_ + needed - head_cache_ > capacity_) return nullptr;
+        }
+        uint64_t at = tail_;
+        if (to_end < bytes) {
+            Record* pad = record(at);
+            pad->span = static_cast<uint32_t>(to_end);
+            pad->flags = PADDING;
+            at += to_end;
+        }
+        claimed_ = at + bytes;
+        Record* r = record(at);
+        r->span = static_cast<uint32_t>(bytes);
+        return r;
+    }
+    void publish() noexcept {
+        tail_ = claimed_;
+        published_.store(tail_, std::memory_order_release);
+    }
+    // Producer's view of the unused bytes
+    size_t room() const noexcept { return capacity_ - (tail_ - head_.load(std::memory_order_acquire)); }
+    // Payload that surely fits right now, whatever the padding
+    size_t free_bytes() const noexcept {
+        const size_t r = room();
+        return r >= 2 * record_bytes(0) ? std::min((r / 2) - sizeof(Record), max_payload()) : 0;
+    }
+
+    // Consumer: oldest record, nullptr if the ring is empty
+    Record* front() noexcept {
+        for (;;) {
+            if (head_local_ == tail_cache_) {
+                tail_cache_ = published_.load(std::memory_order_acquire);
+                if (head_local_ == tail_cache_) return nullptr;
+            }
+            Record* r = record(head_local_);
+            if ((r->flags & PADDING) == 0) return r;
+            head_local_ += r->span;
+            head_.store(head_local_, std::memory_order_release);
+        }
+    }
+    void pop() noexcept {
+        head_local_ += record(head_local_)->span;
+        head_.store(head_local_, std::memory_order_release);
+    }
+    bool empty() const noexcept {
+        return head_.load(std::memory_order_acquire) == published_.load(std::memory_order_acquire);
+    }
+
+   private:
+    Record* record(uint64_t position) noexcept {
+        return reinterpret_cast<Record*>(buffer_ + (position & (capacity_ - 1)));
+    }
+
+    const size_t capacity_;
+    uint8_t* const buffer_;
+    // Producer side
+    alignas(CACHE_LINE) std::atomic<uint64_t> published_{0};
+    uint64_t tail_{0};
+    uint64_t claimed_{0};
+    uint64_t head_cache_{0};
+    // Consumer side
+    alignas(CACHE_LINE) std::atomic<uint64_t> head_{0};
+    uint64_t head_local_{0};
+    uint64_t tail_cache_{0};
+};
+}  // namespace
+
+struct NetworkAgent::SubscriptionBinding {
+    SubscriptionBinding(std::unique_ptr<ISubscription> s, size_t ring_bytes)
+        : subscription(std::move(s)), ring(ring_bytes) {}
+
+    std::unique_ptr<ISubscription> subscription;  // Agent thread only
+    MessageRing ring;                             // Agent produces, application consumes
+    uint64_t last_snapshot{0};                    // Agent thread only
+    std::atomic<bool> connected{false};
+    mutable std::mutex snapshot_mutex;
+    SubscriptionStats snapshot;
+};
+
+struct NetworkAgent::PublicationBinding {
+    PublicationBinding(std::unique_ptr<IPublication> p, size_t ring_bytes)
+        : publication(std::move(p)), ring(ring_bytes) {}
+
+    std::unique_ptr<IPublication> publication;  // Agent thread only
+    MessageRing ring;                           // Application produces, agent consumes
+    uint64_t last_snapshot{0};                  // Agent thread only
+    std::atomic<bool> connected{false};
+    mutable std::mutex snapshot_mutex;
+    PublicationStats snapshot;
+};
+
+namespace {
+// The application's side of a subscription run by the agent
+class AgentSubscription final : public ISubscription {
+   public:
+    explicit AgentSubscription(std::shared_ptr<NetworkAgent::SubscriptionBinding> binding)
+        : binding_(std::move(binding)) {}
+
+    int poll(FunctionRef<void(const MessageView&)> handler, int maxMessages) noexcept override {
+        int delivered = 0;
+        while (delivered < maxMessages) {
+            MessageRing::Record* r = binding_->ring.front();
+            if (r == nullptr) break;
+            handler(MessageView{r->payload(), r->length, r->stream, r->sequence, r->receive_ns, r->send_ns,
+                                (r->flags & MessageRing::END_OF_MESSAGE) != 0});
+            binding_->ring.pop();
+            ++delivered;
+        }
+        return delivered;
+    }
+
+    bool hasData() const noexcept override { return !binding_->ring.empty(); }
+
+    bool isConnected() const noexcept override { return binding_->connected.load(std::memory_order_relaxed); }
+
+    SubscriptionStats stats() const noexcept override {
+        std::lock_guard<std::mutex> lock(binding_->snapshot_mutex);
+        return binding_->snapshot;
+    }
+
+   private:
+    std::shared_ptr<NetworkAgent::SubscriptionBinding> binding_;
+};
+
+// The application's side of a publication run by the agent
+class AgentPublication final : public IPublication {
+   public:
+    explicit AgentPublication(std::shared_ptr<NetworkAgent::PublicationBinding> binding)
+        : binding_(std::move(binding)) {}
+
+    PublishResult offer(std::span<const uint8_t> payload, StreamId streamId, bool endOfMessage) noexcept override {
+        if (claimed_ != nullptr || payload.size() > binding_->ring.max_payload()) return PublishResult::ERROR;
+        MessageRing::Record* r = binding_->ring.claim(payload.size());
+        if (r == nullptr) return PublishResult::BACKPRESSURED;
+        std::memcpy(r->payload(), payload.data(), payload.size());
+        enqueue(r, payload.size(), streamId, endOfMessage);
+        return PublishResult::OK;
+    }
+
+    uint64_t availableWindow() const noexcept override { return binding_->ring.free_bytes(); }
+
+    std::span<uint8_t> tryClaim(size_t length) noexcept override {
+        if (claimed_ != nullptr) return {};
+        claimed_ = binding_->ring.claim(length);
+        if (claimed_ == nullptr) return {};
+        claimed_length_ = length;
+        return {claimed_->payload(), length};
+    }
+
+    PublishResult commit(size_t length, StreamId streamId, bool endOfMessage) noexcept override {
+        if (claimed_ == nullptr || length > claimed_length_) return PublishResult::ERROR;
+        enqueue(claimed_, length, streamId, endOfMessage);
+        claimed_ = nullptr;
+        return PublishResult::OK;
+    }
+
+    // Nothing was published; the next claim reuses the space
+    void abort() noexcept override { claimed_ = nullptr; }
+
+    bool isConnected() const noexcept override { return binding_->connected.load(std::memory_order_relaxed); }
+
+    PublicationStats stats() const noexcept override {
+        std::lock_guard<std::mutex> lock(binding_->snapshot_mutex);
+        return binding_->snapshot;
+    }
+
+   private:
+    void enqueue(MessageRing::Record* r, size_t length, StreamId stream, bool end_of_message) noexcept {
+        r->length = static_cast<uint32_t>(length);
+        r->stream = stream;
+        r->flags = end_of_message ? MessageRing::END_OF_MESSAGE : 0;
+        binding_->ring.publish();
+    }
+
+    std::shared_ptr<NetworkAgent::PublicationBinding> binding_;
+    MessageRing::Record* claimed_{nullptr};
+    size_t claimed_length_{0};
+};
+}  // namespace
+
+NetworkAgent::NetworkAgent(const NetworkAgentConfig& cfg) : cfg_(cfg) {}
+
+NetworkAgent::~NetworkAgent() { stop(); }
+
+std::unique_ptr<ISubscription> NetworkAgent::add_subscription(std::unique_ptr<ISubscription> subscription) {
+    if (!subscription) throw std::invalid_argument("NetworkAgent: null subscription");
+    auto binding = std::make_shared<SubscriptionBinding>(std::move(subscription), cfg_.ringBytes);
+    if (cfg_.maxMessageSize > binding->ring.max_payload())
+        throw std::invalid_argument("NetworkAgent: ringBytes must hold 4 messages of maxMessageSize");
+    {
+        std::lock_guard<std::mutex> lock(added_mutex_);
+        added_subscriptions_.push_back(binding);
+    }
+    added_pending_.store(true, std::memory_order_release);
+    return std::make_unique<AgentSubscription>(std::move(binding));
+}
+
+std::unique_ptr<IPublication> NetworkAgent::add_publication(std::unique_ptr<IPublication> publication) {
+    if (!publication) throw std::invalid_argument("NetworkAgent: null publication");
+    auto binding = std::make_shared<PublicationBinding>(std::move(publication), cfg_.ringBytes);
+    {
+        std::lock_guard<std::mutex> lock(added_mutex_);
+        added_publications_.push_back(binding);
+    }
+    added_pending_.store(true, std::memory_order_release);
+    return std::make_unique<AgentPublication>(std::move(binding));
+}
+
+void NetworkAgent::start() {
+    if (running_.exchange(true)) return;
+    // The thread pins itself before its first duty cycle, so no cycle runs
+    // off cfg.cpu, and reports back whether it could
+    std::promise<bool> pinned;
+    std::future<bool> pinned_result = pinned.get_future();
+    thread_ = std::thread([this, pinned = std::move(pinned)]() mutable {
+        pthread_setname_np(pthread_self(), "hsnet-agent");
+        const bool ok = pin();
+        pinned.set_value(ok);
+        if (ok) run();
+    });
+    if (!pinned_result.get()) {
+        stop();
+        throw std::runtime_error("NetworkAgent: failed to pin to CPU " + std::to_string(cfg_.cpu));
+    }
+}
+
+bool NetworkAgent::pin() noexcept {
+    if (cfg_.cpu < 0) return true;
+    if (cfg_.cpu >= CPU_SETSIZE) return false;
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cfg_.cpu, &cpus);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+}
+
+void NetworkAgent::stop() {
+    running_.store(false, std::memory_order_relaxed);
+    if (thread_.joinable()) thread_.join();
+}
+
+NetworkAgentStats NetworkAgent::stats() const noexcept {
+    NetworkAgentStats s;
+    s.dutyCycles = duty_cycles_.load(std::memory_order_relaxed);
+    s.idleCycles = idle_cycles_.load(std::memory_order_relaxed);
+    s.oversizedDropped = oversized_dropped_.load(std::memory_order_relaxed);
+    s.offersRejected = offers_rejected_.load(std::memory_order_relaxed);
+    return s;
+}
+
+void NetworkAgent::run() noexcept {
+    uint32_t idle_count = 0;
+    while (running_.load(std::memory_order_relaxed)) {
+        if (duty_cycle() > 0) {
+            idle_count = 0;
+        } else {
+            idle_cycles_.fetch_add(1, std::memory_order_relaxed);
+            TscClock::maybeRecalibrate();
+            idle(idle_count);
+        }
+    }
+    // Send what the application queued before stopping
+    for (int i = 0; i < 1000 && duty_cycle() > 0; ++i) {
+    }
+}
+
+int NetworkAgent::duty_cycle() noexcept {
+    if (added_pending_.load(std::memory_order_acquire)) adopt_added();
+    duty_cycles_.fetch_add(1, std::memory_order_relaxed);
+    int work = 0;
+    for (auto& binding : subscriptions_) work += poll_subscription(*binding);
+    for (auto& binding : publications_) work += drain_publication(*binding);
+    return work;
+}
+
+int NetworkAgent::poll_subscription(SubscriptionBinding& binding) noexcept {
+    // Only as many as surely fit, so a polled message is never lost to a full
+    // ring: one record's worth is kept back for padding at the wrap
+    const size_t record = MessageRing::record_bytes(cfg_.maxMessageSize);
+    const size_t fit = binding.ring.room() / record;
+    const int limit = static_cast<int>(std::min<size_t>(cfg_.dutyCycleLimit, fit > 0 ? fit - 1 : 0));
+    int work = 0;
+    if (limit > 0) {
+        work = binding.subscription->poll([&](const MessageView& mv) {
+            MessageRing::Record* r = mv.length <= cfg_.maxMessageSize ? binding.ring.claim(mv.length) : nullptr;
+            if (r == nullptr) {
+                oversized_dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            r->length = mv.length;
+            r->stream = mv.streamId;
+            r->flags = mv.endOfMessage ? MessageRing::END_OF_MESSAGE : 0;
+            r->sequence = mv.sequenceNumber;
+            r->receive_ns = mv.receiveTimeNs;
+            r->send_ns = mv.sendTimeNs;
+            std::memcpy(r->payload(), mv.data, mv.length);
+            binding.ring.publish();
+        }, limit);
+    }
+
+    const uint64_t now = TscClock::now();
+    if (binding.last_snapshot == 0 || TscClock::ticksToNs(now - binding.last_snapshot) >= SNAPSHOT_INTERVAL_NS) {
+        binding.connected.store(binding.subscription->isConnected(), std::memory_order_relaxed);
+        std::unique_lock<std::mutex> lock(binding.snapshot_mutex, std::try_to_lock);
+        if (lock.owns_lock()) {
+            binding.snapshot = binding.subscription->stats();
+            binding.last_snapshot = now;
+        }
+    }
+    return work;
+}
+
+int NetworkAgent::drain_publication(PublicationBinding& binding) noexcept {
+    int work = 0;
+    for (uint32_t i = 0; i < cfg_.dutyCycleLimit; ++i) {
+        MessageRing::Record* r = binding.ring.front();
+        if (r == nullptr) break;
+        const PublishResult result = binding.publication->offer(
+            {r->payload(), r->length}, r->stream, (r->flags & MessageRing::END_OF_MESSAGE) != 0);
+        if (result == PublishResult::BACKPRESSURED || result == PublishResult::NOTCONNECTED) break;
+        if (result != PublishResult::OK) offers_rejected_.fetch_add(1, std::memory_order_relaxed);
+        binding.ring.pop();
+        ++work;
+    }
+    work += binding.publication->flush();
+
+    const uint64_t now = TscClock::now();
+    if (binding.last_snapshot == 0 || TscClock::ticksToNs(now - binding.last_snapshot) >= SNAPSHOT_INTERVAL_NS) {
+        binding.connected.store(binding.publication->isConnected(), std::memory_order_relaxed);
+        std::unique_lock<std::mutex> lock(binding.snapshot_mutex, std::try_to_lock);
+        if (lock.owns_lock()) {
+            binding.snapshot = binding.publication->stats();
+            binding.last_snapshot = now;
+        }
+    }
+    return work;
+}
+
+void NetworkAgent::idle(uint32_t& idle_count) noexcept {
+    switch (cfg_.idle) {
+        case IdleStrategy::BUSY_SPIN:
+            cpu_pause();
+            return;
+        case IdleStrategy::YIELD:
+            sched_yield();
+            return;
+        case IdleStrategy::BACKOFF:
+            break;
+    }
+    const uint32_t n = idle_count++;
+    if (n < cfg_.spinsBeforeYield) {
+        cpu_pause();
+    } else if (n < cfg_.spinsBeforeYield + cfg_.yieldsBeforeSleep) {
+        sched_yield();
+    } else {
+        const uint32_t doublings = std::min<uint32_t>(n - cfg_.spinsBeforeYield - cfg_.yieldsBeforeSleep, 30);
+        const uint64_t ns = std::min<uint64_t>(1000ull << doublings, cfg_.maxIdleSleepNs);
+        std::this_thread::sleep_for(std::chrono::nanoseconds(ns));
+        if (ns >= cfg_.maxIdleSleepNs) idle_count--;  // Stay at the cap
+    }
+}
+
+void NetworkAgent::adopt_added() noexcept {
+    std::lock_guard<std::mutex> lock(added_mutex_);
+    subscriptions_.insert(subscriptions_.end(), added_subscriptions_.begin(), added_subscriptions_.end());
+    publications_.insert(publications_.end(), added_publications_.begin(), added_publications_.end());
+    added_subscriptions_.clear();
+    added_publications_.clear();
+    added_pending_.store(false, std::memory_order_relaxed);
+}
+
+} // namespace hsnet
@@ -1,8 +1,13 @@
 #include "net/Protocol.h"
 
 #include <arpa/inet.h>
+
+#include <algorithm>
+#include <cstddef>
 #include <cstring>
 
+#include "net/Crc32c.h"
+
 namespace hsnet::proto {
 
 static constexpr uint32_t MAGIC = 0x57554E4E41u; // "WUNNA"
@@ -16,8 +21,8 @@ void write_header(uint8_t* dst, const Header& h) noexcept {
     uint64_t magic_version_type_flags =
         (static_cast<uint64_t>(MAGIC) << 24) |
         (static_cast<uint64_t>(VERSION) << 16) |
-        (static_cast<uint64_t>(static_cast<uint8_t>(FrameType::DATA)) << 8) |
-        (static_cast<uint64_t>(0) << 0); // flags
+        (static_cast<uint64_t>(static_cast<uint8_t>(frame_type(h))) << 8) |
+        (static_cast<uint64_t>(frame_flags(h)) << 0);
     net_h.magic_version_type_flags = magic_version_type_flags;
 
     // Convert to network byte order
@@ -56,4 +61,105 @@ bool parse_header(const uint8_t* src, Header& out) noexcept {
     return true;
 }
 
-} // namespace hsnet::proto 
\ No newline at end of file
+size_t write_frame(uint8_t* dst, const Header& h, const uint8_t* payload, size_t len) noexcept {
+    Header unsigned_h = h;
+    unsigned_h.crc32c_payload = 0;
+    write_header(dst, unsigned_h);
+    if ((frame_flags(h) & FLAG_CRC32C) == 0) {
+        std::memcpy(dst + sizeof(Header), payload, len);
+        return sizeof(Header) + len;
+    }
+    // Single pass over the payload: checksum while copying
+    uint32_t crc = crc32c(dst, sizeof(Header));
+    crc = crc32c_copy(dst + sizeof(Header), payload, len, crc);
+    const uint32_t net_crc = htonl(crc);
+    std::memcpy(dst + offsetof(Header, crc32c_payload), &net_crc, sizeof(net_crc));
+    return sizeof(Header) + len;
+}
+
+size_t seal_frame(uint8_t* dst, const Header& h) noexcept {
+    Header unsigned_h = h;
+    unsigned_h.crc32c_payload = 0;
+    write_header(dst, unsigned_h);
+    if ((frame_flags(h) & FLAG_CRC32C) != 0) {
+        const uint32_t net_crc = htonl(crc32c(dst, sizeof(Header) + h.payload_length));
+        std::memcpy(dst + offsetof(Header, crc32c_payload), &net_crc, sizeof(net_crc));
+    }
+    return sizeof(Header) + h.payload_length;
+}
+
+bool verify_frame_crc(const uint8_t* frame, size_t len, const Header& parsed) noexcept {
+    static constexpr size_t CRC_OFFSET = offsetof(Header, crc32c_payload);
+    static constexpr uint8_t ZEROS[sizeof(Header::crc32c_payload)] = {};
+    static_assert(CRC_OFFSET + sizeof(ZEROS) == sizeof(Header), "crc32c_payload must end the header");
+    if (len < sizeof(Header)) return false;
+    // The CRC was computed with its own field zeroed
+    uint32_t crc = crc32c(frame, CRC_OFFSET);
+    crc = crc32c_extend(crc, ZEROS, sizeof(ZEROS));
+    crc = crc32c_extend(crc, frame + sizeof(Header), len - sizeof(Header));
+    return crc == parsed.crc32c_payload;
+}
+
+size_t write_nak_frame(uint8_t* dst, Header h, std::span<const ctrl::NakRange> ranges) noexcept {
+    const ctrl::Nak nak{static_cast<uint16_t>(std::min(ranges.size(), MAX_NAK_RANGES))};
+    uint8_t* payload = dst + sizeof(Header);
+    std::memset(payload, 0, NAK_COUNT_BYTES);
+    const uint16_t net_count = htons(nak.count);
+    std::memcpy(payload, &net_count, sizeof(net_count));
+    for (size_t i = 0; i < nak.count; ++i) {
+        const uint64_t net_range[2] = {htonll(ranges[i].start_seq), htonll(ranges[i].end_seq)};
+        std::memcpy(payload + NAK_COUNT_BYTES + i * sizeof(net_range), net_range, sizeof(net_range));
+    }
+    h.payload_length = static_cast<uint16_t>(NAK_COUNT_BYTES + nak.count * sizeof(ctrl::NakRange));
+    set_type_flags(h, FrameType::NAK, frame_flags(h));
+    return seal_frame(dst, h);
+}
+
+size_t read_nak(const uint8_t* payload, size_t len, std::span<ctrl::NakRange> out) noexcept {
+    if (len < NAK_COUNT_BYTES) return 0;
+    uint16_t net_count;
+    std::memcpy(&net_count, payload, sizeof(net_count));
+    const ctrl::Nak nak{ntohs(net_count)};
+    if (len < NAK_COUNT_BYTES + nak.count * sizeof(ctrl::NakRange)) return 0;
+    const size_t count = std::min<size_t>(nak.count, out.size());
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t net_range[2];
+        std::memcpy(net_range, payload + NAK_COUNT_BYTES + i * sizeof(net_range), sizeof(net_range));
+        out[i] = {ntohll(net_range[0]), ntohll(net_range[1])};
+    }
+    return count;
+}
+
+size_t write_ack_frame(uint8_t* dst, Header h, const ctrl::Ack& ack) noexcept {
+    const uint64_t net_ack[3] = {htonll(ack.cumulative_ack), htonll(ack.sack_bitmap), htonll(ack.receive_window)};
+    std::memcpy(dst + sizeof(Header), net_ack, sizeof(net_ack));
+    h.payload_length = sizeof(net_ack);
+    set_type_flags(h, FrameType::ACK, frame_flags(h));
+    return seal_frame(dst, h);
+}
+
+bool read_ack(const uint8_t* payload, size_t len, ctrl::Ack& out) noexcept {
+    uint64_t net_ack[3];
+    if (len < sizeof(net_ack)) return false;
+    std::memcpy(net_ack, payload, sizeof(net_ack));
+    out = ctrl::Ack{ntohll(net_ack[0]), ntohll(net_ack[1]), ntohll(net_ack[2])};
+    return true;
+}
+
+size_t write_session_frame(uint8_t* dst, Header h, FrameType type, uint64_t session_id) noexcept {
+    const uint64_t net_session = htonll(session_id);
+    std::memcpy(dst + sizeof(Header), &net_session, sizeof(net_session));
+    h.payload_length = sizeof(net_session);
+    set_type_flags(h, type, frame_flags(h));
+    return seal_frame(dst, h);
+}
+
+bool read_session_id(const uint8_t* payload, size_t len, uint64_t& session_id) noexcept {
+    uint64_t net_session;
+    if (len < sizeof(net_session)) return false;
+    std::memcpy(&net_session, payload, sizeof(net_session));
+    session_id = ntohll(net_session);
+    return true;
+}
+
+} // namespace hsnet::proto
@@ -1,102 +1,303 @@
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 #include "net/ReorderingBuffer.h"
+#include "net/Protocol.h"
 
 namespace hsnet {
 
-ReorderingBuffer::ReorderingBuffer(size_t max_size)
-    : max_size_(max_size), next_seq_(0), head_(0), count_(0) {
-    buffer_.resize(max_size);
+ReorderingBuffer::ReorderingBuffer(size_t max_size, size_t slot_bytes, size_t spare_slots, size_t max_capacity,
+                                   size_t max_message_bytes)
+    : capacity_(std::bit_ceil(std::max<size_t>(max_size, 1))),
+      mask_(capacity_ - 1),
+      max_capacity_(std::max(capacity_, std::bit_ceil(std::max<size_t>(max_capacity, 1)))),
+      next_seq_(0),
+      count_(0),
+      overruns_(0),
+      reassembly_(max_message_bytes),
+      slot_bytes_(slot_bytes),
+      slot_count_(0) {
+    buffer_.resize(capacity_);
+    present_.resize((capacity_ + 63) / 64);
+    add_slots(capacity_ + spare_slots);
 }
 
-bool ReorderingBuffer::add(uint64_t sequence, std::vector<uint8_t> data, uint32_t stream_id) {
-    // If sequence is too old, ignore it
-    if (sequence < next_seq_) {
-        return false;
+void ReorderingBuffer::add_slots(size_t count) {
+    const size_t total = slot_count_ + count;
+    while (chunks_.size() * CHUNK_SLOTS < total) {
+        chunks_.push_back(std::make_unique<uint8_t[]>(CHUNK_SLOTS * slot_bytes_));
     }
-    
-    // If sequence is too far ahead, we might need to expand buffer
-    if (sequence >= next_seq_ + max_size_) {
-        // For now, just drop packets that are too far ahead
-        // In a real implementation, we might want to expand or handle this differently
-        return false;
+    free_.reserve(total);
+    // Hand out low slots first
+    for (size_t i = total; i > slot_count_; --i) free_.push_back(static_cast<SlotId>(i - 1));
+    slot_count_ = total;
+}
+
+ReorderingBuffer::SlotId ReorderingBuffer::acquire() noexcept {
+    if (free_.empty()) return NO_SLOT;
+    const SlotId slot = free_.back();
+    free_.pop_back();
+    return slot;
+}
+
+void ReorderingBuffer::release(SlotId slot) noexcept {
+    // Never reallocates: every slot was popped from free_ before
+    free_.push_back(slot);
+}
+
+bool ReorderingBuffer::fits(uint64_t sequence) {
+    if (sequence < next_seq_ + capacity_) return true;
+    // Delivery moved a whole window on since the last overruns: they were strays
+    if (pressure_ == 0 || next_seq_ - pressure_start_ >= capacity_) {
+        pressure_ = 0;
+        pressure_start_ = next_seq_;
     }
-    
-    // Calculate position in circular buffer
-    size_t pos = (head_ + (sequence - next_seq_)) % max_size_;
-    
-    // If this position is already occupied, we have a duplicate
-    if (buffer_[pos].valid && buffer_[pos].sequence == sequence) {
-        return false;
+    if (sequence - next_seq_ < max_capacity_ && ++pressure_ >= GROW_AFTER_OVERRUNS) {
+        pressure_ = 0;
+        grow(capacity_ * 2);
+        if (sequence < next_seq_ + capacity_) return true;
     }
-    
-    // Store the packet
-    if (!buffer_[pos].valid) {
-        count_++;
+    overruns_++;
+    return false;
+}
+
+void ReorderingBuffer::grow(size_t capacity) {
+    std::vector<Packet> buffer(capacity);
+    std::vector<uint64_t> present((capacity + 63) / 64);
+    const size_t mask = capacity - 1;
+    for (size_t pos = 0; pos < capacity_; ++pos) {
+        if (!test_bit(pos)) continue;
+        const size_t to = buffer_[pos].sequence & mask;
+        buffer[to] = buffer_[pos];
+        present[to >> 6] |= 1ull << (to & 63);
     }
-    buffer_[pos] = Packet(sequence, std::move(data), stream_id);
+    add_slots(capacity - capacity_);
+    buffer_.swap(buffer);
+    present_.swap(present);
+    capacity_ = capacity;
+    mask_ = mask;
+}
 
+bool ReorderingBuffer::add(uint64_t sequence, SlotId slot, uint16_t offset, uint16_t length, uint32_t stream_id,
+                           Fragment fragment, bool batched, FrameTimes times) {
+    // If sequence is too old (or a duplicate), ignore it
+    // If sequence is too far ahead even for the largest window, drop it
+    if (sequence < next_seq_ || !fits(sequence) || test_bit(sequence & mask_)) {
+        release(slot);
+        return false;
+    }
+
+    const size_t pos = sequence & mask_;
+    buffer_[pos] = Packet{sequence, slot, offset, length, stream_id, fragment, batched, times};
+    set_bit(pos);
+    count_++;
     return true;
 }
 
-std::optional<std::pair<std::vector<uint8_t>, uint32_t>> ReorderingBuffer::get_next() {
-    if (!has_ready()) {
-        return std::nullopt;
+bool ReorderingBuffer::add(uint64_t sequence, std::span<const uint8_t> data, uint32_t stream_id, Fragment fragment,
+                           bool batched, FrameTimes times) {
+    if (data.size() > slot_bytes_ || data.size() > UINT16_MAX) return false;
+    // Cheap rejection before spending a slot and a copy
+    if (sequence < next_seq_ || !fits(sequence) || test_bit(sequence & mask_)) return false;
+    const SlotId slot = acquire();
+    if (slot == NO_SLOT) return false;
+    if (!data.empty()) std::memcpy(slot_data(slot), data.data(), data.size());
+    return add(sequence, slot, 0, static_cast<uint16_t>(data.size()), stream_id, fragment, batched, times);
+}
+
+MessageView ReorderingBuffer::view_of(const Packet& packet, uint64_t receive_time_ns) const noexcept {
+    const bool last = packet.fragment.index + 1 >= packet.fragment.total;
+    return MessageView{slot_data(packet.slot) + packet.offset,
+                       packet.length,
+                       packet.stream_id,
+                       packet.sequence,
+                       packet.times.received_ns != 0 ? packet.times.received_ns : receive_time_ns,
+                       packet.times.sent_ns,
+                       last && packet.fragment.end_of_message};
+}
+
+size_t ReorderingBuffer::message_span() const noexcept {
+    if (!test_bit(next_seq_ & mask_)) return 0;
+    const Packet& head = buffer_[next_seq_ & mask_];
+    const size_t total = head.fragment.total;
+    // Whole frames, stray middle fragments, and messages too large to
+    // reassemble go out one frame at a time (the last fragment may be short;
+    // peek_ready() checks the exact length)
+    if (head.fragment.index != 0 || total <= 1 || total > max_capacity_ ||
+        (total - 1) * head.length >= reassembly_.size()) {
+        return 1;
     }
-    
-    // Get the packet at head
-    auto& packet = buffer_[head_];
-    // Ensure it is valid and matches the expected sequence number
-    assert(packet.valid && packet.sequence == next_seq_);
-    
-    // Extract data and stream_id
-    auto data = std::move(packet.data);
-    auto stream_id = packet.stream_id;
-    
-    // Mark slot as invalid
-    packet.valid = false;
-    packet.sequence = 0;
-    packet.stream_id = 0;
-    
-    // Advance sequence number and head pointer
+    return ready_count() >= total ? total : 0;
+}
+
+size_t ReorderingBuffer::peek_ready(std::span<MessageView> out, uint64_t receive_time_ns) noexcept {
+    size_t views = 0;
+    size_t packets = 0;
+    pending_unpacked_ = 0;
+    while (views < out.size() && test_bit((next_seq_ + packets) & mask_)) {
+        const Packet& head = buffer_[(next_seq_ + packets) & mask_];
+        if (head.batched) {
+            const uint8_t* payload = slot_data(head.slot) + head.offset;
+            size_t offset = 0;
+            std::span<const uint8_t> msg;
+            while (views < out.size() && proto::next_batched(payload, head.length, offset, msg)) {
+                MessageView& view = out[views++];
+                view = view_of(head, receive_time_ns);
+                view.data = msg.data();
+                view.length = static_cast<uint32_t>(msg.size());
+                view.endOfMessage = true;
+            }
+            if (views == out.size() && offset < head.length) {
+                // More messages than views: the rest wait in the slot
+                pending_unpacked_ = offset;
+                break;
+            }
+            if (packets == 0 && views == 0) {
+                // Empty or unparsable, nothing to hand over: free it now so
+                // what follows starts at the head
+                drop_head();
+                continue;
+            }
+            packets++;  // Unpacked, or what is left can't be parsed
+            continue;
+        }
+        if (head.fragment.index == 0 && head.fragment.total > 1) {
+            // Reassembly starts a span of its own, at next_seq_
+            if (packets > 0) break;
+            const size_t span = message_span();
+            if (span == 0) break;
+            if (span > 1) {
+                size_t length = 0;
+                bool consistent = true;
+                for (size_t i = 0; i < span && consistent; ++i) {
+                    const Packet& fragment = buffer_[(next_seq_ + i) & mask_];
+                    consistent = fragment.fragment.index == i && fragment.fragment.total == span &&
+                                 length + fragment.length <= reassembly_.size();
+                    if (consistent) {
+                        std::memcpy(reassembly_.data() + length, slot_data(fragment.slot) + fragment.offset,
+                                    fragment.length);
+                        length += fragment.length;
+                    }
+                }
+                if (consistent) {
+                    const Packet& last = buffer_[(next_seq_ + span - 1) & mask_];
+                    out[0] = MessageView{reassembly_.data(),
+                                         static_cast<uint32_t>(length),
+                                         head.stream_id,
+                                         head.sequence,
+                                         last.times.received_ns != 0 ? last.times.received_ns : receive_time_ns,
+                                         head.times.sent_ns,
+                                         last.fragment.end_of_message};
+                    pending_consume_ = span;
+                    return 1;
+                }
+                // Mismatched fragment headers: hand the frames over as they are
+            }
+        }
+        out[views++] = view_of(head, receive_time_ns);
+        packets++;
+    }
+    pending_consume_ = packets;
+    return views;
+}
+
+void ReorderingBuffer::drop_head() noexcept {
+    const size_t pos = next_seq_ & mask_;
+    assert(test_bit(pos));
+    clear_bit(pos);
+    release(buffer_[pos].slot);
     next_seq_++;
-    advance_head();
     count_--;
-    
-    return std::make_pair(std::move(data), stream_id);
 }
 
-bool ReorderingBuffer::has_ready() const {
-    return buffer_[head_].valid && buffer_[head_].sequence == next_seq_;
+void ReorderingBuffer::consume() noexcept {
+    for (size_t i = 0; i < pending_consume_; ++i) drop_head();
+    pending_consume_ = 0;
+    if (pending_unpacked_ > 0) {
+        Packet& head = buffer_[next_seq_ & mask_];
+        head.offset = static_cast<uint16_t>(head.offset + pending_unpacked_);
+        head.length = static_cast<uint16_t>(head.length - pending_unpacked_);
+        pending_unpacked_ = 0;
+    }
 }
 
-void ReorderingBuffer::clear() {
-    for (auto& packet : buffer_) {
-        packet.valid = false;
-        packet.sequence = 0;
-        packet.data.clear();
+uint64_t ReorderingBuffer::window_bits(uint64_t seq) const noexcept {
+    const uint64_t end = next_seq_ + capacity_;
+    if (seq >= end) return 0;
+    uint64_t bits;
+    if (capacity_ >= 64) {
+        const size_t pos = seq & mask_;
+        const size_t word = pos >> 6;
+        const size_t shift = pos & 63;
+        bits = present_[word] >> shift;
+        if (shift != 0) bits |= present_[(word + 1) & (present_.size() - 1)] << (64 - shift);
+    } else {
+        // Window smaller than a word: wrap bit by bit
+        bits = 0;
+        for (size_t i = 0; i < capacity_; ++i) bits |= static_cast<uint64_t>(test_bit((seq + i) & mask_)) << i;
     }
-    next_seq_ = 0;
-    head_ = 0;
-    count_ = 0;
+    if (end - seq < 64) bits &= (1ull << (end - seq)) - 1;
+    return bits;
 }
 
-size_t ReorderingBuffer::find_packet(uint64_t sequence) const {
-    if (sequence < next_seq_ || sequence >= next_seq_ + max_size_) {
-        return max_size_; // Invalid position
+size_t ReorderingBuffer::ready_count() const noexcept {
+    size_t run = 0;
+    for (;;) {
+        const int ones = std::countr_one(window_bits(next_seq_ + run));
+        run += static_cast<size_t>(ones);
+        if (ones < 64) return run;
     }
-    
-    size_t pos = (head_ + (sequence - next_seq_)) % max_size_;
-    if (buffer_[pos].valid && buffer_[pos].sequence == sequence) {
-        return pos;
+}
+
+uint64_t ReorderingBuffer::next_received(uint64_t from) const noexcept {
+    const uint64_t end = next_seq_ + capacity_;
+    uint64_t seq = std::max(from, next_seq_);
+    while (seq < end) {
+        const uint64_t bits = window_bits(seq);
+        if (bits != 0) return seq + static_cast<uint64_t>(std::countr_zero(bits));
+        seq += 64;
+    }
+    return end;
+}
+
+ctrl::Ack ReorderingBuffer::ack() const noexcept {
+    const uint64_t cumulative = first_gap();
+    return ctrl::Ack{cumulative, window_bits(cumulative + 1), next_seq_ + capacity_ - cumulative};
+}
+
+size_t ReorderingBuffer::missing_ranges(std::span<ctrl::NakRange> out, uint64_t known_end) const noexcept {
+    const uint64_t end = next_seq_ + capacity_;
+    size_t count = 0;
+    uint64_t seq = first_gap();
+    while (count < out.size()) {
+        const uint64_t received = next_received(seq);
+        if (received >= end) {
+            // Nothing after this gap yet, but the sender may have said otherwise
+            const uint64_t tail_end = std::min(known_end, end);
+            if (seq < tail_end) out[count++] = ctrl::NakRange{seq, tail_end};
+            break;
+        }
+        out[count++] = ctrl::NakRange{seq, received};
+        // Skip the run that arrived
+        for (seq = received;;) {
+            const int ones = std::countr_one(window_bits(seq));
+            seq += static_cast<uint64_t>(ones);
+            if (ones < 64) break;
+        }
     }
-    
-    return max_size_; // Not found
+    return count;
 }
 
-void ReorderingBuffer::advance_head() {
-    // Move head to next valid packet or wrap around (MAINTAIN BUFFER INVARIANT)
-    head_ = (head_ + 1) % max_size_;
+void ReorderingBuffer::clear(uint64_t next_sequence) {
+    for (size_t pos = 0; pos < capacity_; ++pos) {
+        if (test_bit(pos)) release(buffer_[pos].slot);
+    }
+    std::fill(present_.begin(), present_.end(), 0);
+    next_seq_ = next_sequence;
+    count_ = 0;
+    pending_consume_ = 0;
+    pending_unpacked_ = 0;
+    pressure_ = 0;
 }
 
-} // namespace hsnet 
\ No newline at end of file
+} // namespace hsnet 
@@ -0,0 +1,68 @@
+#include "net/RxBatch.h"
+
+#include <netinet/udp.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace hsnet {
+
+RxBatch::RxBatch(size_t batch_size, size_t slot_bytes, bool gro, bool timestamps)
+    : storage_(std::max<size_t>(batch_size, 1) * slot_bytes),
+      iov_(std::max<size_t>(batch_size, 1)),
+      msgs_(std::max<size_t>(batch_size, 1)),
+      sources_(msgs_.size()),
+      control_(gro || timestamps ? msgs_.size() : 0) {
+    for (size_t i = 0; i < msgs_.size(); ++i) {
+        set_buffer(i, storage_.data() + i * slot_bytes, slot_bytes);
+        msgs_[i] = {};
+        msgs_[i].msg_hdr.msg_iov = &iov_[i];
+        msgs_[i].msg_hdr.msg_iovlen = 1;
+        msgs_[i].msg_hdr.msg_name = &sources_[i];
+    }
+}
+
+int RxBatch::receive(int sockfd, size_t count) noexcept {
+    count = std::min(count, msgs_.size());
+    if (count == 0) return 0;
+    // The kernel shrinks msg_namelen and msg_controllen to what it wrote;
+    // give the room back
+    for (size_t i = 0; i < count; ++i) msgs_[i].msg_hdr.msg_namelen = sizeof(sources_[i]);
+    for (size_t i = 0; i < std::min(count, control_.size()); ++i) {
+        msgs_[i].msg_hdr.msg_control = control_[i].buf;
+        msgs_[i].msg_hdr.msg_controllen = sizeof(control_[i].buf);
+    }
+    const int n = recvmmsg(sockfd, msgs_.data(), static_cast<unsigned>(count), MSG_DONTWAIT, nullptr);
+    return n > 0 ? n : 0;
+}
+
+size_t RxBatch::segment_size(size_t i) const noexcept {
+    const msghdr& hdr = msgs_[i].msg_hdr;
+    if (!control_.empty()) {
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr); cmsg != nullptr; cmsg = CMSG_NXTHDR(const_cast<msghdr*>(&hdr), cmsg)) {
+            if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+                int segment = 0;
+                std::memcpy(&segment, CMSG_DATA(cmsg), sizeof(segment));
+                if (segment > 0) return static_cast<size_t>(segment);
+            }
+        }
+    }
+    return std::max<size_t>(length(i), 1);
+}
+
+uint64_t RxBatch::receive_time_ns(size_t i) const noexcept {
+    return control_.empty() ? 0 : receive_timestamp_ns(msgs_[i].msg_hdr);
+}
+
+uint64_t receive_timestamp_ns(const msghdr& hdr) noexcept {
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr); cmsg != nullptr; cmsg = CMSG_NXTHDR(const_cast<msghdr*>(&hdr), cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+            timespec ts;
+            std::memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000 + static_cast<uint64_t>(ts.tv_nsec);
+        }
+    }
+    return 0;
+}
+
+} // namespace hsnet
@@ -0,0 +1,317 @@
+#include "net/ShmTransport.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "TscClock.h"
+
+namespace hsnet {
+
+namespace {
+static constexpr size_t CACHE_LINE = 64;
+
+// Log layout: a LogHeader page, then the ring. Positions are byte offsets
+// that grow forever and are masked into the ring; every record starts
+// RECORD_ALIGNMENT-aligned, so the space left before the end of the ring
+// always fits at least a record header.
+struct Record {
+    uint32_t length;  // Payload bytes after the header
+    uint16_t flags;
+    uint16_t reserved;
+    uint64_t sequence;
+};
+static constexpr size_t RECORD_ALIGNMENT = sizeof(Record);
+static constexpr uint16_t RECORD_PADDING = 0x01;    // Fills the ring up to its end; skip to the start
+static constexpr uint16_t RECORD_CONTINUED = 0x02;  // Message continues in the next record (!endOfMessage)
+
+struct alignas(CACHE_LINE) ReaderSlot {
+    std::atomic<uint64_t> position;  // Everything before it has been read
+    std::atomic<int32_t> pid;        // 0: free
+};
+
+struct LogHeader {
+    alignas(CACHE_LINE) std::atomic<uint64_t> capacity;  // Ring bytes, set by whoever maps the log first
+    std::atomic<int32_t> writer_pid;                      // 0: no publication
+    alignas(CACHE_LINE) std::atomic<uint64_t> tail;      // Everything before it is published
+    uint64_t next_sequence;                               // The writer's, kept across publications
+    ReaderSlot readers[ShmConfig::MAX_SUBSCRIBERS];
+};
+
+// The log is shared between processes, so its atomics must not need locks
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<int32_t>::is_always_lock_free);
+
+size_t record_bytes(size_t length) noexcept {
+    return (sizeof(Record) + length + RECORD_ALIGNMENT - 1) / RECORD_ALIGNMENT * RECORD_ALIGNMENT;
+}
+
+bool process_alive(int32_t pid) noexcept { return kill(pid, 0) == 0 || errno == EPERM; }
+
+// One mapping of a stream's log file, created on first use
+class LogMapping {
+   public:
+    LogMapping(const std::string& path, size_t capacity) {
+        const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        data_offset_ = (sizeof(LogHeader) + page - 1) / page * page;
+        capacity_ = std::bit_ceil(std::max<size_t>(capacity, page));
+        mapped_ = data_offset_ + capacity_;
+
+        const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (fd < 0) throw std::runtime_error("Failed to open log buffer " + path);
+        struct stat st{};
+        // A new file reads as zeros: an empty log with no writer or readers
+        if (fstat(fd, &st) != 0 ||
+            (static_cast<size_t>(st.st_size) < mapped_ && ftruncate(fd, static_cast<off_t>(mapped_)) != 0)) {
+            ::close(fd);
+            throw std::runtime_error("Failed to size log buffer " + path);
+        }
+        void* p = mmap(nullptr, mapped_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) throw std::runtime_error("Failed to map log buffer " + path);
+        base_ = static_cast<uint8_t*>(p);
+
+        uint64_t expected = 0;
+        if (!header()->capacity.compare_exchange_strong(expected, capacity_) && expected != capacity_) {
+            munmap(base_, mapped_);
+            throw std::runtime_error("Log buffer " + path + " has a different size");
+        }
+    }
+
+    ~LogMapping() { munmap(base_, mapped_); }
+
+    LogMapping(const LogMapping&) = delete;
+    LogMapping& operator=(const LogMapping&) = delete;
+
+    LogHeader* header() const noexcept { return reinterpret_cast<LogHeader*>(base_); }
+    uint8_t* at(uint64_t position) const noexcept { return base_ + data_offset_ + (position & (capacity_ - 1)); }
+    size_t capacity() const noexcept { return capacity_; }
+    // Bytes from `position` to the end of the ring
+    size_t until_end(uint64_t position) const noexcept { return capacity_ - (position & (capacity_ - 1)); }
+
+   private:
+    uint8_t* base_{nullptr};
+    size_t data_offset_;
+    size_t capacity_;
+    size_t mapped_;
+};
+
+// The single writer of a stream's log. tryClaim() hands out the payload
+// space of the next record in place; commit() fills in the record header and
+// publishes it with a release store of the tail. The writer never laps a
+// subscriber: the oldest read position plus the ring size bounds what can
+// be claimed (BACKPRESSURED beyond it), refreshed only when a claim hits
+// the cached bound. Subscribers whose process has died are evicted then.
+class ShmPublication : public IPublication {
+   public:
+    ShmPublication(const std::string& path, const ShmConfig& cfg, StreamId stream)
+        : log_(path, cfg.logBufferSize), stream_(stream), max_payload_(log_.capacity() / 4 - sizeof(Record)) {
+        LogHeader* header = log_.header();
+        int32_t writer = 0;
+        const int32_t self = static_cast<int32_t>(getpid());
+        while (!header->writer_pid.compare_exchange_strong(writer, self)) {
+            if (process_alive(writer)) throw std::runtime_error("Log buffer " + path + " already has a publication");
+        }
+        tail_ = header->tail.load(std::memory_order_relaxed);
+        next_seq_ = header->next_sequence;
+        refresh_limit();
+    }
+
+    ~ShmPublication() override { log_.header()->writer_pid.store(0, std::memory_order_release); }
+
+    PublishResult offer(std::span<const uint8_t> payload, StreamId streamId, bool endOfMessage) noexcept override {
+        if (claimed_ || streamId != stream_ || payload.size() > max_payload_) return PublishResult::ERROR;
+        const std::span<uint8_t> claim = tryClaim(payload.size());
+        if (claim.data() == nullptr) return PublishResult::BACKPRESSURED;
+        if (!payload.empty()) std::memcpy(claim.data(), payload.data(), payload.size());
+        return commit(payload.size(), streamId, endOfMessage);
+    }
+
+    std::span<uint8_t> tryClaim(size_t length) noexcept override {
+        if (claimed_ || length > max_payload_) return {};
+        // A record that would straddle the end of the ring starts over at its beginning
+        const size_t to_end = log_.until_end(tail_);
+        const size_t padding = record_bytes(length) > to_end ? to_end : 0;
+        if (!has_room(padding + record_bytes(length))) return {};
+        if (padding > 0) {
+            new (log_.at(tail_)) Record{static_cast<uint32_t>(padding - sizeof(Record)), RECORD_PADDING, 0, 0};
+        }
+        claimed_ = true;
+        claim_position_ = tail_ + padding;
+        claim_length_ = length;
+        return {log_.at(claim_position_) + sizeof(Record), length};
+    }
+
+    PublishResult commit(size_t length, StreamId streamId, bool endOfMessage) noexcept override {
+        if (!claimed_ || length > claim_length_ || streamId != stream_) return PublishResult::ERROR;
+        claimed_ = false;
+        new (log_.at(claim_position_))
+            Record{static_cast<uint32_t>(length), static_cast<uint16_t>(endOfMessage ? 0 : RECORD_CONTINUED), 0,
+                   next_seq_++};
+        tail_ = claim_position_ + record_bytes(length);
+        LogHeader* header = log_.header();
+        header->next_sequence = next_seq_;
+        header->tail.store(tail_, std::memory_order_release);
+        stats_.framesSent++;
+        return PublishResult::OK;
+    }
+
+    void abort() noexcept override { claimed_ = false; }
+
+    uint64_t availableWindow() const noexcept override {
+        const uint64_t limit = oldest_reader() + log_.capacity();
+        return limit > tail_ + sizeof(Record) ? limit - tail_ - sizeof(Record) : 0;
+    }
+
+    PublicationStats stats() const noexcept override { return stats_; }
+
+   private:
+    bool has_room(size_t bytes) noexcept {
+        if (tail_ + bytes <= limit_) return true;
+        refresh_limit();
+        if (tail_ + bytes <= limit_) return true;
+        evict_dead_readers();
+        refresh_limit();
+        return tail_ + bytes <= limit_;
+    }
+
+    void refresh_limit() noexcept { limit_ = oldest_reader() + log_.capacity(); }
+
+    // Oldest read position among the subscribers, tail_ if there are none
+    uint64_t oldest_reader() const noexcept {
+        uint64_t oldest = tail_;
+        for (const ReaderSlot& reader : log_.header()->readers) {
+            if (reader.pid.load(std::memory_order_acquire) != 0) {
+                oldest = std::min(oldest, reader.position.load(std::memory_order_acquire));
+            }
+        }
+        return oldest;
+    }
+
+    void evict_dead_readers() noexcept {
+        for (ReaderSlot& reader : log_.header()->readers) {
+            int32_t pid = reader.pid.load(std::memory_order_acquire);
+            if (pid != 0 && !process_alive(pid)) reader.pid.compare_exchange_strong(pid, 0);
+        }
+    }
+
+    LogMapping log_;
+    StreamId stream_;
+    size_t max_payload_;  // A quarter of the ring, so padding never starves a claim
+    uint64_t tail_{0};
+    uint64_t limit_{0};   // Claims must end at or before this position
+    uint64_t next_seq_{0};
+    bool claimed_{false};
+    uint64_t claim_position_{0};
+    size_t claim_length_{0};
+    PublicationStats stats_{};
+};
+
+// One reader of a stream's log. It takes a reader slot, starts at the
+// current tail and delivers records in place; its position is published
+// after the handlers return, so the writer can't reuse the space of a
+// message that is still being read.
+class ShmSubscription : public ISubscription {
+   public:
+    ShmSubscription(const std::string& path, const ShmConfig& cfg, StreamId stream)
+        : log_(path, cfg.logBufferSize), stream_(stream) {
+        const int32_t self = static_cast<int32_t>(getpid());
+        for (ReaderSlot& reader : log_.header()->readers) {
+            int32_t free = 0;
+            if (reader.pid.compare_exchange_strong(free, self)) {
+                slot_ = &reader;
+                break;
+            }
+        }
+        if (slot_ == nullptr) throw std::runtime_error("Log buffer " + path + " has no free subscriber slot");
+        // The slot's old position holds the writer back until this one is seen
+        position_ = log_.header()->tail.load(std::memory_order_acquire);
+        slot_->position.store(position_, std::memory_order_release);
+    }
+
+    ~ShmSubscription() override { slot_->pid.store(0, std::memory_order_release); }
+
+    int poll(FunctionRef<void(const MessageView&)> handler, int maxMessages) noexcept override {
+        const uint64_t tail = log_.header()->tail.load(std::memory_order_acquire);
+        if (position_ == tail) {
+            TscClock::maybeRecalibrate();  // Keeps receive times on CLOCK_REALTIME without a logger
+            return 0;
+        }
+        const uint64_t now = TscClock::realtimeNs();
+        uint64_t position = position_;
+        int count = 0;
+        while (count < maxMessages && position < tail) {
+            const Record* record = reinterpret_cast<const Record*>(log_.at(position));
+            if (record->flags & RECORD_PADDING) {
+                position += log_.until_end(position);
+                continue;
+            }
+            handler(MessageView{log_.at(position) + sizeof(Record), record->length, stream_, record->sequence, now, 0,
+                                (record->flags & RECORD_CONTINUED) == 0});
+            position += record_bytes(record->length);
+            count++;
+        }
+        position_ = position;
+        slot_->position.store(position, std::memory_order_release);
+        stats_.framesReceived += count;
+        stats_.messagesDelivered += count;
+        return count;
+    }
+
+    bool hasData() const noexcept override {
+        return position_ != log_.header()->tail.load(std::memory_order_acquire);
+    }
+
+    // A publication that crashed leaves its pid behind
+    bool isConnected() const noexcept override {
+        const int32_t writer = log_.header()->writer_pid.load(std::memory_order_acquire);
+        return writer != 0 && process_alive(writer);
+    }
+
+    SubscriptionStats stats() const noexcept override { return stats_; }
+
+   private:
+    LogMapping log_;
+    StreamId stream_;
+    ReaderSlot* slot_{nullptr};
+    uint64_t position_{0};
+    SubscriptionStats stats_{};
+};
+
+class ShmTransport : public ITransport {
+   public:
+    explicit ShmTransport(const ShmConfig& cfg) : cfg_(cfg) {}
+
+    std::unique_ptr<IPublication> create_publication(std::string_view endpoint, StreamId stream) override {
+        return std::make_unique<ShmPublication>(log_path(endpoint, stream), cfg_, stream);
+    }
+
+    std::unique_ptr<ISubscription> create_subscription(std::string_view endpoint, StreamId stream) override {
+        return std::make_unique<ShmSubscription>(log_path(endpoint, stream), cfg_, stream);
+    }
+
+   private:
+    std::string log_path(std::string_view endpoint, StreamId stream) const {
+        return cfg_.directory + "/" + (endpoint.empty() ? cfg_.name : std::string{endpoint}) + "-" +
+               std::to_string(stream);
+    }
+
+    ShmConfig cfg_;
+};
+
+}  // namespace
+
+std::unique_ptr<ITransport> make_shm_transport(const ShmConfig& cfg) { return std::make_unique<ShmTransport>(cfg); }
+
+} // namespace hsnet
@@ -0,0 +1,20 @@
+#include "net/TxRing.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace hsnet {
+
+namespace {
+constexpr size_t CACHE_LINE = 64;
+}
+
+TxRing::TxRing(size_t slots, size_t frame_capacity)
+    : frame_capacity_(std::max(frame_capacity, sizeof(proto::Header) + 1)),
+      slot_stride_((frame_capacity_ + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE),
+      mask_(std::bit_ceil(std::max<size_t>(slots, 2)) - 1) {
+    storage_.resize(slot_count() * slot_stride_);
+    lengths_.resize(slot_count(), 0);
+}
+
+} // namespace hsnet
@@ -2,305 +2,900 @@
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <netinet/udp.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <bit>
+#include <cerrno>
 #include <cstring>
 #include <memory>
 #include <optional>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <vector>
 #include <iostream>
 
+#include "TscClock.h"
 #include "net/Protocol.h"
-#include "net/ReorderingBuffer.h"
+#include "net/DatagramSubscription.h"
+#include "net/IoUring.h"
+#include "net/RxBatch.h"
+#include "net/TxRing.h"
 
 namespace hsnet {
 
 namespace {
-static constexpr std::string_view MULTICAST_ADDR = "239.1.1.1";
-static constexpr int MULTICAST_PORT{8170};
+// Largest UDP payload that fits in one IPv4 packet of the configured MTU
+static constexpr size_t IP_UDP_OVERHEAD = 20 + 8;
+
+// Kernel limits for one UDP_SEGMENT send: segment count and total payload
+static constexpr size_t GSO_MAX_SEGMENTS = 64;
+static constexpr size_t GSO_MAX_BYTES = 0xFFFF - IP_UDP_OVERHEAD;
+
+// Control frames (NAKs, ACKs) read per check, and how often flush() checks
+static constexpr size_t CONTROL_BATCH = 8;
+static constexpr uint64_t CONTROL_POLL_INTERVAL_NS = 50'000;
+
+// Retransmission timeout bounds (RFC 6298 style, scaled to a LAN)
+static constexpr uint64_t INITIAL_RTO_NS = 1'000'000;
+static constexpr uint64_t MIN_RTO_NS = 200'000;
+static constexpr uint64_t MAX_RTO_NS = 1'000'000'000;
+
+// Interval between HELLOs while a point-to-point peer hasn't answered
+static constexpr uint64_t HELLO_RETRY_NS = 1'000'000;
+
+// True if the kernel knows the UDP socket option (UDP_SEGMENT, UDP_GRO)
+bool udp_offload_supported(int sockfd, int option) {
+    int value = 0;
+    socklen_t len = sizeof(value);
+    return sockfd >= 0 && getsockopt(sockfd, SOL_UDP, option, &value, &len) == 0;
+}
 
-class UdpPublication : public IPublication {
-   public:
-    explicit UdpPublication(int sockfd, sockaddr_in dest)
-        : sockfd_(sockfd), dest_(dest), next_seq_(0) {}
+in_addr parse_ipv4(const std::string& ip, const char* what) {
+    in_addr a{};
+    if (inet_pton(AF_INET, ip.c_str(), &a) != 1) throw std::runtime_error(std::string("Invalid ") + what + " address: " + ip);
+    return a;
+}
 
+in_addr multicast_group(const std::string& ip) {
+    const in_addr a = parse_ipv4(ip, "multicast group");
+    if (!IN_MULTICAST(ntohl(a.s_addr))) throw std::runtime_error("Not a multicast group: " + ip);
+    return a;
+}
 
-    PublishResult offer(std::span<const uint8_t> payload, StreamId streamId, bool endOfMessage) noexcept override {
-        (void)streamId;
-        (void)endOfMessage;
+// Empty: INADDR_ANY, the kernel picks by route
+in_addr interface_address(const std::string& ip) {
+    if (ip.empty()) return in_addr{htonl(INADDR_ANY)};
+    return parse_ipv4(ip, "interface");
+}
 
-        // Create header with proper sequence number
-        hsnet::proto::Header header{};
-        header.sequence_number = next_seq_;
-        header.payload_length = static_cast<uint16_t>(payload.size());
-        header.stream_id = streamId;
+// Send multicast out of `interface` rather than wherever the route points
+void set_multicast_interface(int sockfd, in_addr interface) {
+    if (interface.s_addr != htonl(INADDR_ANY) &&
+        setsockopt(sockfd, IPPROTO_IP, IP_MULTICAST_IF, &interface, sizeof(interface)) != 0)
+        throw std::runtime_error("Failed to select the multicast interface");
+}
 
-        std::vector<uint8_t> buffer(sizeof(header) + payload.size());
-        hsnet::proto::write_header(buffer.data(), header);
-        std::memcpy(buffer.data() + sizeof(header), payload.data(), payload.size());
-        ssize_t sent = sendto(sockfd_, buffer.data(), buffer.size(), 0, reinterpret_cast<sockaddr*>(&dest_), sizeof(dest_));
-        if (sent >= 0) {
-            next_seq_++;
-            return PublishResult::OK;
-        }
-        return PublishResult::ERROR;
+// Join each group on `interface`. Without IP_MULTICAST_ALL off, a socket
+// bound to INADDR_ANY also receives every group any other socket on the
+// host joined on the same port.
+void join_groups(int sockfd, std::span<const std::string> groups, in_addr interface) {
+    int off = 0;
+    setsockopt(sockfd, IPPROTO_IP, IP_MULTICAST_ALL, &off, sizeof(off));
+    for (const std::string& group : groups) {
+        ip_mreq mreq{};
+        mreq.imr_multiaddr = multicast_group(group);
+        mreq.imr_interface = interface;
+        if (setsockopt(sockfd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0)
+            throw std::runtime_error("Failed to join multicast group " + group);
     }
+}
 
-    uint64_t availableWindow() const noexcept override { return UINT64_MAX; }
+// Socket buffer sizes and busy polling from any of the configs. Best effort:
+// the *FORCE variants go past rmem_max/wmem_max but need CAP_NET_ADMIN, and
+// SO_BUSY_POLL needs kernel support (and CAP_NET_ADMIN to raise it)
+template <typename Config>
+void tune_socket(int sockfd, const Config& cfg) {
+    if (sockfd < 0) return;
+    if (int bytes = static_cast<int>(cfg.socketRecvBufferBytes); bytes > 0 &&
+        setsockopt(sockfd, SOL_SOCKET, SO_RCVBUFFORCE, &bytes, sizeof(bytes)) != 0)
+        setsockopt(sockfd, SOL_SOCKET, SO_RCVBUF, &bytes, sizeof(bytes));
+    if (int bytes = static_cast<int>(cfg.socketSendBufferBytes); bytes > 0 &&
+        setsockopt(sockfd, SOL_SOCKET, SO_SNDBUFFORCE, &bytes, sizeof(bytes)) != 0)
+        setsockopt(sockfd, SOL_SOCKET, SO_SNDBUF, &bytes, sizeof(bytes));
+    if (int us = static_cast<int>(cfg.busyPollUs); us > 0) setsockopt(sockfd, SOL_SOCKET, SO_BUSY_POLL, &us, sizeof(us));
+}
 
-   private:
-    int sockfd_;
-    sockaddr_in dest_{};
-    std::atomic<uint64_t> next_seq_{0};
+// Send-side settings of a DatagramPublication; see UdpConfig and
+// FeedPublisherConfig for what they mean
+struct DatagramPublicationConfig {
+    StreamId stream{0};
+    uint32_t mtu{1500};
+    uint32_t txRingSize{1024};
+    uint32_t retransmitRingSize{7168};
+    uint32_t maxMessageSize{1u << 20};
+    bool crc{false};
+    uint32_t sendBatchSize{1};
+    uint64_t sendBatchLatencyNs{0};  // 0: until the batch is full or flush()
+    bool coalesce{false};
+    uint64_t coalesceDelayNs{0};
+    uint64_t nakSuppressNs{0};
+    uint64_t heartbeatIntervalNs{0};  // 0: no heartbeats
+    bool flowControl{false};          // Point-to-point: follow the peer's ACKs
+    uint32_t initialWindow{0};        // Frames in flight before the first ACK
 };
 
-class FeedPublication : public IPublication {
+// Send path shared by UdpPublication and FeedPublication, for one stream and
+// a single publisher thread. Messages are encoded straight into the next
+// TxRing slot and sent from there: nothing is allocated, and the only copy
+// after encoding is the kernel's.
+//
+// Committed frames queue in the ring and go out together once sendBatchSize
+// are pending, the oldest has waited sendBatchLatencyNs, or flush() is
+// called: in one sendmmsg(), where GSO turns each run of equal-length frames
+// into a single UDP_SEGMENT message, or as one io_uring SENDMSG per frame,
+// whose slot isn't reused until the send completes. offer() fragments
+// messages larger than a frame, up to maxMessageSize, and with coalescing
+// packs small whole messages into a shared frame (proto::FLAG_BATCHED).
+// tryClaim() is limited to a single frame.
+//
+// The ring keeps txRingSize + retransmitRingSize frames. flush() answers
+// NAKs by resending from it, each frame at most once per nakSuppressNs, or
+// with a RESET once the frame has been overwritten. With flow control frames
+// stay until they are ACKed, at most one receive window is in flight
+// (BACKPRESSURED beyond it), and what isn't acknowledged within an RTO of
+// the smoothed round trip is resent.
+//
+// A HELLO announces the session; a point-to-point publication repeats it
+// every HELLO_RETRY_NS and returns NOTCONNECTED until the peer answers. A
+// HEARTBEAT goes out after heartbeatIntervalNs without a frame, so receivers
+// notice tail loss.
+class DatagramPublication : public IPublication {
    public:
-    explicit FeedPublication(const FeedPublisherConfig& cfg) : txSock_({}), next_seq_(0) {
-        // Multicast setup
-        sockfd_ = socket(AF_INET, SOCK_DGRAM, 0);
-        if (sockfd_ >= 0) {
-            int optval = 1;
-            // setsockopt(sockfd_, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval));
-            // setup multicast
-            txSock_.sin_family = AF_INET;
-            txSock_.sin_port = htons(MULTICAST_PORT);
-            txSock_.sin_addr.s_addr = inet_addr(std::string{MULTICAST_ADDR}.c_str());
-            setsockopt(sockfd_, IPPROTO_IP, IP_MULTICAST_TTL, &optval, sizeof(optval));
+    explicit DatagramPublication(const DatagramPublicationConfig& cfg)
+        : stream_(cfg.stream),
+          crc_(cfg.crc),
+          ring_(static_cast<size_t>(cfg.txRingSize) + cfg.retransmitRingSize,
+                cfg.mtu > IP_UDP_OVERHEAD ? cfg.mtu - IP_UDP_OVERHEAD : 0),
+          max_message_size_(cfg.maxMessageSize),
+          batch_size_(std::clamp<size_t>(cfg.sendBatchSize, 1, ring_.slot_count())),
+          batch_latency_ns_(cfg.sendBatchLatencyNs),
+          iov_(batch_size_),
+          msgs_(batch_size_),
+          run_frames_(batch_size_),
+          coalesce_(cfg.coalesce),
+          coalesce_delay_ns_(cfg.coalesceDelayNs),
+          gso_control_(batch_size_),
+          retransmitted_at_(ring_.slot_count(), 0),
+          nak_suppress_ns_(cfg.nakSuppressNs),
+          control_(CONTROL_BATCH, hsnet::proto::NAK_FRAME_BYTES),
+          flow_control_(cfg.flowControl),
+          peer_window_(cfg.initialWindow),
+          sent_at_(cfg.flowControl ? ring_.slot_count() : 0, 0),
+          session_id_(TscClock::realtimeNs() | 1),
+          heartbeat_interval_ns_(cfg.heartbeatIntervalNs) {
+        const size_t max_fragments = (max_message_size_ + ring_.max_payload() - 1) / ring_.max_payload();
+        if (max_fragments > ring_.slot_count() || max_fragments > UINT16_MAX) {
+            throw std::runtime_error("maxMessageSize needs more fragments than the TX ring holds");
+        }
+        for (size_t i = 0; i < msgs_.size(); ++i) {
+            msgs_[i] = {};
+            msgs_[i].msg_hdr.msg_name = &dest_;
+            msgs_[i].msg_hdr.msg_namelen = sizeof(dest_);
+            cmsghdr* cmsg = reinterpret_cast<cmsghdr*>(gso_control_[i].buf);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
         }
     }
 
-    ~FeedPublication() override {
-        close(sockfd_);
+    PublishResult offer(std::span<const uint8_t> payload, StreamId streamId, bool endOfMessage) noexcept override {
+        const size_t max_payload = ring_.max_payload();
+        const size_t fragments = payload.empty() ? 1 : (payload.size() + max_payload - 1) / max_payload;
+        if (claimed_ || streamId != stream_ || payload.size() > max_message_size_) {
+            return PublishResult::ERROR;
+        }
+        if (coalesce_ && endOfMessage && payload.size() + hsnet::proto::BATCH_PREFIX_BYTES <= max_payload) {
+            return pack(payload);
+        }
+        if (packing_) enqueue(finish_packed());
+        if (!connect()) return PublishResult::NOTCONNECTED;
+        if (!make_room(fragments)) return PublishResult::BACKPRESSURED;
+        for (size_t i = 0; i < fragments; ++i) {
+            const std::span<const uint8_t> part = payload.subspan(i * max_payload).first(
+                std::min(max_payload, payload.size() - i * max_payload));
+            hsnet::proto::Header header = make_header(part.size(), endOfMessage);
+            header.fragment_index = static_cast<uint16_t>(i);
+            header.fragments_total = static_cast<uint16_t>(fragments);
+            // Payload is copied into the slot and checksummed in the same pass
+            enqueue(hsnet::proto::write_frame(ring_.frame(next_seq_), header, part.data(), part.size()));
+        }
+        return PublishResult::OK;
     }
 
-    PublishResult offer(std::span<const uint8_t> payload, StreamId streamId, bool endOfMessage) noexcept override {
-        (void)streamId;
-        (void)endOfMessage;
+    std::span<uint8_t> tryClaim(size_t length) noexcept override {
+        if (claimed_ || length > ring_.max_payload()) return {};
+        if (packing_) enqueue(finish_packed());
+        if (!connect() || !make_room(1)) return {};
+        claimed_ = true;
+        claim_length_ = length;
+        return {ring_.payload(next_seq_), length};
+    }
 
-        // Create header with proper sequence number
-        hsnet::proto::Header header{};
-        header.sequence_number = next_seq_;
-        header.payload_length = static_cast<uint16_t>(payload.size());
-        header.stream_id = streamId;
+    PublishResult commit(size_t length, StreamId streamId, bool endOfMessage) noexcept override {
+        if (!claimed_ || length > claim_length_ || streamId != stream_) return PublishResult::ERROR;
+        claimed_ = false;
+        const hsnet::proto::Header header = make_header(length, endOfMessage);
+        return enqueue(hsnet::proto::seal_frame(ring_.frame(next_seq_), header));
+    }
 
-        std::vector<uint8_t> buffer(sizeof(header) + payload.size());
-        hsnet::proto::write_header(buffer.data(), header);
-        std::memcpy(buffer.data() + sizeof(header), payload.data(), payload.size());
-        ssize_t sent = sendto(sockfd_, buffer.data(), buffer.size(), 0, reinterpret_cast<sockaddr*>(&txSock_), sizeof(txSock_));
-        if (sent >= 0) {
-            next_seq_++;
-            return PublishResult::OK;
+    void abort() noexcept override { claimed_ = false; }
+
+    int flush() noexcept override {
+        if (packing_) queue(finish_packed());
+        if (uring_) reap_sends();
+        if (TscClock::elapsedNs(last_control_poll_) >= CONTROL_POLL_INTERVAL_NS) serve_control();
+        if (flow_control_) check_timeout();
+        int sent_total = 0;
+        while (flushed_ < next_seq_) {
+            const size_t frames = std::min<uint64_t>(next_seq_ - flushed_, iov_.size());
+            const size_t sent_frames = uring_ ? submit_sends(frames) : send_batch(frames);
+            if (sent_frames == 0) break;  // Frames stay queued and are retried on the next flush
+            if (flow_control_) {
+                const uint64_t now = TscClock::now();
+                if (acked_ == flushed_) last_progress_ = now;  // The RTO runs from the first frame in flight
+                for (size_t i = 0; i < sent_frames; ++i) sent_at_[(flushed_ + i) & (ring_.slot_count() - 1)] = now;
+            }
+            flushed_ += sent_frames;
+            stats_.framesSent += sent_frames;
+            sent_total += static_cast<int>(sent_frames);
+            last_sent_ = TscClock::now();
         }
-        return PublishResult::ERROR;
+        if (!isConnected() && TscClock::elapsedNs(last_hello_) >= HELLO_RETRY_NS) hello();
+        if (heartbeat_interval_ns_ != 0 && TscClock::elapsedNs(last_sent_) >= heartbeat_interval_ns_) keep_alive();
+        // Keeps the send_time_ns stamps on CLOCK_REALTIME; after the sends so they don't wait for it
+        TscClock::maybeRecalibrate();
+        return sent_total;
     }
 
-    uint64_t availableWindow() const noexcept override { return UINT64_MAX; }
+    bool isConnected() const noexcept override { return !flow_control_ || peer_connected_; }
 
-   private:
-    int sockfd_;
-    sockaddr_in txSock_;
-    std::atomic<uint64_t> next_seq_;
-};
+    uint64_t availableWindow() const noexcept override {
+        if (!flow_control_) return UINT64_MAX;
+        const uint64_t in_flight = next_seq_ - acked_;
+        const uint64_t window = send_window();
+        return window > in_flight ? (window - in_flight) * ring_.max_payload() : 0;
+    }
 
-class FeedSubscription : public ISubscription {
-   public:
-    explicit FeedSubscription(const FeedSubscriberConfig& cfg) : addr({}), mreq({}),reorder_buff(1024) {
-        sockfd_ = socket(AF_INET, SOCK_DGRAM, 0);
-        if (sockfd_ >= 0) {
-            addr.sin_family = AF_INET;
-            addr.sin_addr.s_addr = htonl(INADDR_ANY);
-            addr.sin_port = htons(cfg.port);
-            int optval = 1;
-            setsockopt(sockfd_, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval));
-            setsockopt(sockfd_, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof(optval));
+    PublicationStats stats() const noexcept override {
+        PublicationStats stats = stats_;
+        stats.ioUring = uring_ != nullptr;
+        return stats;
+    }
+
+   protected:
+    // Announce the session; subclasses call this once the socket is set up
+    void hello() noexcept {
+        send_session_frame(hsnet::proto::FrameType::HELLO, next_seq_);
+        last_hello_ = TscClock::now();
+    }
 
-            if (bind(sockfd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
-                throw std::runtime_error("Failed to bind or create subscription socket!");
+    // Send through io_uring from now on, if the kernel allows it
+    void use_io_uring(uint32_t entries, bool sq_poll) {
+        uring_ = std::make_unique<IoUring>(entries, sq_poll);
+        if (!uring_->ok()) {
+            uring_.reset();
+            return;
+        }
+        gso_ = false;
+        uring_sends_.resize(std::bit_ceil(std::max<size_t>(entries, 1)));
+    }
+
+    // Wait for io_uring sends still in flight; subclasses call this before
+    // closing the socket
+    void drain_sends() noexcept {
+        const uint64_t start = TscClock::now();
+        while (uring_ && uring_retired_ < uring_submitted_ && TscClock::elapsedNs(start) < DRAIN_TIMEOUT_NS) {
+            reap_sends();
+        }
+    }
+
+    int sockfd_{-1};
+    sockaddr_in dest_{};
+    bool gso_{false};  // Set by subclasses once the socket supports UDP_SEGMENT
+
+   private:
+    static constexpr uint64_t DRAIN_TIMEOUT_NS = 100'000'000;
 
-            // Set mx_addr to constant (Might use config value in the future)
-            mreq.imr_multiaddr.s_addr = inet_addr(std::string{MULTICAST_ADDR}.c_str());
-            // Setting to loopback for now, once again ignoring config value
-            mreq.imr_interface.s_addr = htonl(INADDR_ANY);
-            int did_set_sock = setsockopt(sockfd_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq));
-            if (did_set_sock < 0) {
-                throw std::runtime_error("Failed to set socket options for membership!");
+    // sendmmsg() the next `frames` queued frames; returns how many went out
+    size_t send_batch(size_t frames) noexcept {
+        for (size_t i = 0; i < frames; ++i) {
+            iov_[i].iov_base = ring_.frame(flushed_ + i);
+            iov_[i].iov_len = ring_.frame_length(flushed_ + i);
+        }
+        for (;;) {
+            const size_t msg_count = build_messages(frames);
+            const int sent = sendmmsg(sockfd_, msgs_.data(), static_cast<unsigned>(msg_count), 0);
+            if (sent > 0) {
+                size_t sent_frames = 0;
+                for (int m = 0; m < sent; ++m) sent_frames += run_frames_[m];
+                return sent_frames;
             }
+            // EIO/EINVAL: the route can't segment after all; resend unsegmented
+            if (!gso_ || msg_count == frames || (errno != EIO && errno != EINVAL)) return 0;
+            gso_ = false;
         }
     }
 
-    ~FeedSubscription() override { close(sockfd_); }
+    // Queue a SENDMSG per frame for the next `frames` queued frames, as many
+    // as the rings take; returns how many were handed to the kernel
+    size_t submit_sends(size_t frames) noexcept {
+        const size_t mask = uring_sends_.size() - 1;
+        size_t queued = 0;
+        for (; queued < frames && uring_submitted_ - uring_retired_ < uring_sends_.size(); ++queued) {
+            io_uring_sqe* sqe = uring_->get_sqe();
+            if (sqe == nullptr) break;
+            const uint64_t seq = flushed_ + queued;
+            UringSend& send = uring_sends_[uring_submitted_ & mask];
+            send.iov = {ring_.frame(seq), ring_.frame_length(seq)};
+            send.msg = {};
+            send.msg.msg_name = &dest_;
+            send.msg.msg_namelen = sizeof(dest_);
+            send.msg.msg_iov = &send.iov;
+            send.msg.msg_iovlen = 1;
+            send.done = false;
+            sqe->opcode = IORING_OP_SENDMSG;
+            sqe->fd = sockfd_;
+            sqe->addr = reinterpret_cast<uint64_t>(&send.msg);
+            sqe->len = 1;
+            sqe->user_data = uring_submitted_++;
+        }
+        // SQEs the kernel didn't take now are picked up by the next submit
+        if (queued > 0) uring_->submit();
+        return queued;
+    }
+
+    // Retire completed sends in submission order, freeing their slots. A
+    // failed send is a lost datagram, recovered by NAK or RTO like any other.
+    void reap_sends() noexcept {
+        const size_t mask = uring_sends_.size() - 1;
+        uring_->reap([&](const io_uring_cqe& cqe) { uring_sends_[cqe.user_data & mask].done = true; });
+        while (uring_retired_ < uring_submitted_ && uring_sends_[uring_retired_ & mask].done) uring_retired_++;
+    }
+
+    // Group the first `frames` iov_ entries into messages: one per frame, or
+    // with GSO one per run of equal-length frames (a shorter frame may end a
+    // run, as the kernel allows a short last segment)
+    size_t build_messages(size_t frames) noexcept {
+        size_t msg_count = 0;
+        for (size_t i = 0; i < frames; ++msg_count) {
+            const size_t len = iov_[i].iov_len;
+            size_t run = 1;
+            if (gso_) {
+                const size_t max_run = std::min(GSO_MAX_SEGMENTS, GSO_MAX_BYTES / len);
+                while (i + run < frames && run < max_run && iov_[i + run].iov_len <= len) {
+                    if (iov_[i + run++].iov_len < len) break;
+                }
+            }
+            msghdr& hdr = msgs_[msg_count].msg_hdr;
+            hdr.msg_iov = &iov_[i];
+            hdr.msg_iovlen = run;
+            if (run > 1) {
+                const uint16_t segment = static_cast<uint16_t>(len);
+                std::memcpy(CMSG_DATA(reinterpret_cast<cmsghdr*>(gso_control_[msg_count].buf)), &segment,
+                            sizeof(segment));
+                hdr.msg_control = gso_control_[msg_count].buf;
+                hdr.msg_controllen = sizeof(gso_control_[msg_count].buf);
+            } else {
+                hdr.msg_control = nullptr;
+                hdr.msg_controllen = 0;
+            }
+            run_frames_[msg_count] = run;
+            i += run;
+        }
+        return msg_count;
+    }
 
-    int poll(std::function<void(const MessageView&)> handler, int maxMessages) noexcept override {
-        int count = 0;
-        using namespace std::chrono;
-        while (count < maxMessages && reorder_buff.has_ready()) {
-            auto data = reorder_buff.get_next();
-            if (data) {
-                auto now_time_point = steady_clock::now().time_since_epoch();
-                uint64_t recv_ts = duration_cast<nanoseconds>(now_time_point).count();
-                MessageView v{
-                    data->first.data(),
-                    static_cast<uint16_t>(data->first.size()),
-                    data->second,
-                    reorder_buff.next_expected() - 1,
-                    recv_ts,
-                    true};
-                handler(v);
-                count++;
+    // Handle the NAKs and ACKs queued on the socket
+    void serve_control() noexcept {
+        last_control_poll_ = TscClock::now();
+        for (;;) {
+            const int received = control_.receive(sockfd_);
+            for (int i = 0; i < received; ++i) {
+                handle_control(control_.data(i), control_.length(i), control_.truncated(i));
             }
+            if (received < static_cast<int>(control_.batch_size())) break;
         }
+    }
 
-        while (count < maxMessages) {
-            uint8_t buff[2048];
-            sockaddr src{};
-            socklen_t socklen{sizeof(src)};
-
-            ssize_t n = recvfrom(sockfd_, &buff, sizeof(buff), MSG_DONTWAIT, reinterpret_cast<sockaddr*>(&src), &socklen);
-            if (n <= 0) break;
-
-            hsnet::proto::Header header{};
-            auto is_parsed = hsnet::proto::parse_header(buff, header);
-            if (!is_parsed) continue;
-
-            auto payload_len = header.payload_length;
-            if (n < static_cast<ssize_t>(sizeof(header) + payload_len)) continue;
-
-            // Extract payload data
-            std::vector<uint8_t> data(buff + sizeof(header), buff + sizeof(header) + payload_len);
-            auto seq = header.sequence_number;
-            // Add to reordering buffer
-            if (reorder_buff.add(seq, std::move(data), header.stream_id)) {
-                // Packet was added successfully, try to deliver if it's in sequence
-                while (reorder_buff.has_ready()) {
-                    auto ready_data = reorder_buff.get_next();
-                    if (ready_data) {
-                        MessageView v{
-                            ready_data->first.data(),
-                            static_cast<uint16_t>(ready_data->first.size()),
-                            ready_data->second,                // stream_id from packet
-                            reorder_buff.next_expected() - 1,  // sequence number
-                            0,                                 // receive time
-                            true                               // endOfMessage
-                        };
-                        handler(v);
-                        count++;
-                    }
+    void handle_control(const uint8_t* frame, size_t n, bool truncated) noexcept {
+        hsnet::proto::Header header{};
+        if (truncated || n < sizeof(header) || !hsnet::proto::parse_header(frame, header) ||
+            n < sizeof(header) + header.payload_length || header.stream_id != stream_) {
+            return;
+        }
+        if ((hsnet::proto::frame_flags(header) & hsnet::proto::FLAG_CRC32C) &&
+            !hsnet::proto::verify_frame_crc(frame, sizeof(header) + header.payload_length, header)) {
+            return;
+        }
+        const uint8_t* payload = frame + sizeof(header);
+        switch (hsnet::proto::frame_type(header)) {
+            case hsnet::proto::FrameType::NAK: {
+                const size_t count = hsnet::proto::read_nak(payload, header.payload_length, nak_ranges_);
+                stats_.naksReceived++;
+                for (size_t i = 0; i < count; ++i) retransmit(nak_ranges_[i].start_seq, nak_ranges_[i].end_seq);
+                break;
+            }
+            case hsnet::proto::FrameType::ACK: {
+                hsnet::ctrl::Ack ack{};
+                if (hsnet::proto::read_ack(payload, header.payload_length, ack)) on_ack(ack);
+                break;
+            }
+            case hsnet::proto::FrameType::HELLO: {
+                // A subscriber answering our HELLO
+                uint64_t session = 0;
+                if (hsnet::proto::read_session_id(payload, header.payload_length, session) && session == session_id_) {
+                    peer_connected_ = true;
                 }
+                break;
             }
+            default:
+                break;
         }
-        return count;
     }
 
-    bool hasData() const noexcept override {
-        return reorder_buff.has_ready();
+    void on_ack(const hsnet::ctrl::Ack& ack) noexcept {
+        stats_.acksReceived++;
+        // Stale, or about frames this publication never sent
+        if (!flow_control_ || ack.cumulative_ack < acked_ || ack.cumulative_ack > flushed_) return;
+        if (ack.cumulative_ack > acked_) {
+            const uint64_t now = TscClock::now();
+            const size_t slot = (ack.cumulative_ack - 1) & (ring_.slot_count() - 1);
+            // Karn's rule: a resent frame's ACK can't be matched to one send
+            if (retransmitted_at_[slot] == 0) update_rtt(TscClock::ticksToNs(now - sent_at_[slot]));
+            acked_ = ack.cumulative_ack;
+            last_progress_ = now;
+            rto_backoff_ = 1;
+        }
+        sack_ = ack.sack_bitmap;
+        peer_window_ = ack.receive_window;
     }
 
-   private:
-    int sockfd_;
-    sockaddr_in addr;
-    ip_mreq mreq;
-    ReorderingBuffer reorder_buff;
+    void update_rtt(uint64_t sample_ns) noexcept {
+        if (srtt_ns_ == 0) {
+            srtt_ns_ = sample_ns;
+            rttvar_ns_ = sample_ns / 2;
+        } else {
+            const uint64_t delta = srtt_ns_ > sample_ns ? srtt_ns_ - sample_ns : sample_ns - srtt_ns_;
+            rttvar_ns_ = (3 * rttvar_ns_ + delta) / 4;
+            srtt_ns_ = (7 * srtt_ns_ + sample_ns) / 8;
+        }
+        stats_.rttNs = srtt_ns_;
+    }
+
+    uint64_t rto_ns() const noexcept {
+        const uint64_t base = srtt_ns_ == 0 ? INITIAL_RTO_NS : std::max(MIN_RTO_NS, srtt_ns_ + 4 * rttvar_ns_);
+        return std::min(base * rto_backoff_, MAX_RTO_NS);
+    }
+
+    // Nothing acknowledged for an RTO: resend the oldest unacknowledged frame
+    // and whatever the last SACK shows missing after it
+    void check_timeout() noexcept {
+        if (acked_ == flushed_ || TscClock::elapsedNs(last_progress_) < rto_ns()) return;
+        stats_.timeouts++;
+        const uint64_t now = TscClock::now();
+        resend(acked_, now);
+        for (uint64_t i = 0; i < 64 && acked_ + 1 + i < flushed_; ++i) {
+            if (((sack_ >> i) & 1) == 0) resend(acked_ + 1 + i, now);
+        }
+        last_progress_ = now;
+        if (rto_ns() < MAX_RTO_NS) rto_backoff_ *= 2;
+    }
+
+    uint64_t send_window() const noexcept { return std::min<uint64_t>(ring_.slot_count(), peer_window_); }
+
+    // Resend the sent frames in [start, end) that are still in the ring
+    void retransmit(uint64_t start, uint64_t end) noexcept {
+        // Older slots have been reused; a claimed or packing slot is being overwritten
+        const uint64_t reused = next_seq_ + (claimed_ || packing_ ? 1 : 0);
+        const uint64_t oldest = reused > ring_.slot_count() ? reused - ring_.slot_count() : 0;
+        end = std::min(end, flushed_);  // Later frames are still queued
+        if (start >= end) return;
+        if (start < oldest) {
+            stats_.retransmitsUnavailable += std::min(end, oldest) - start;
+            start = oldest;
+            // Move the receivers past what is gone; they NAK again from there
+            send_session_frame(hsnet::proto::FrameType::RESET, oldest);
+            stats_.resetsSent++;
+        }
+        const uint64_t now = TscClock::now();
+        for (uint64_t seq = start; seq < end; ++seq) {
+            uint64_t& resent = retransmitted_at_[seq & (ring_.slot_count() - 1)];
+            if (resent != 0 && TscClock::ticksToNs(now - resent) < nak_suppress_ns_) {
+                stats_.retransmitsSuppressed++;
+                continue;
+            }
+            resend(seq, now);
+        }
+    }
+
+    void resend(uint64_t seq, uint64_t now) noexcept {
+        if (sendto(sockfd_, ring_.frame(seq), ring_.frame_length(seq), 0, reinterpret_cast<const sockaddr*>(&dest_),
+                   sizeof(dest_)) > 0) {
+            retransmitted_at_[seq & (ring_.slot_count() - 1)] = now;
+            stats_.retransmits++;
+        }
+    }
+
+    hsnet::proto::Header make_header(size_t length, bool endOfMessage) const noexcept {
+        hsnet::proto::Header header{};
+        header.sequence_number = next_seq_;
+        header.payload_length = static_cast<uint16_t>(length);
+        header.stream_id = stream_;
+        header.send_time_ns = TscClock::realtimeNs();
+        header.fragment_index = 0;
+        header.fragments_total = 1;
+        const uint8_t flags = (crc_ ? hsnet::proto::FLAG_CRC32C : 0) | (endOfMessage ? 0 : hsnet::proto::FLAG_CONTINUED);
+        hsnet::proto::set_type_flags(header, hsnet::proto::FrameType::DATA, flags);
+        return header;
+    }
+
+    // A point-to-point publication waits for its peer's answer to the HELLO
+    bool connect() noexcept {
+        if (isConnected()) return true;
+        flush();  // Reads the answer, or repeats the HELLO
+        return isConnected();
+    }
+
+    // Nothing sent for a heartbeat interval; before the peer answers, the
+    // HELLO retries stand in for heartbeats
+    void keep_alive() noexcept {
+        if (!isConnected()) return;
+        send_session_frame(hsnet::proto::FrameType::HEARTBEAT, flushed_);
+        stats_.heartbeatsSent++;
+    }
+
+    void send_session_frame(hsnet::proto::FrameType type, uint64_t sequence) noexcept {
+        hsnet::proto::Header header{};
+        header.sequence_number = sequence;
+        header.stream_id = stream_;
+        header.send_time_ns = TscClock::realtimeNs();
+        hsnet::proto::set_type_flags(header, type, crc_ ? hsnet::proto::FLAG_CRC32C : 0);
+        const size_t len = hsnet::proto::write_session_frame(session_frame_.data(), header, type, session_id_);
+        sendto(sockfd_, session_frame_.data(), len, 0, reinterpret_cast<const sockaddr*>(&dest_), sizeof(dest_));
+        last_sent_ = TscClock::now();
+    }
+
+    // The next `frames` slots must not hold frames that haven't been sent
+    // (with flow control, acknowledged) yet, and must fit in the window
+    bool make_room(size_t frames) noexcept {
+        if (has_room(frames)) return true;
+        flush();
+        if (flow_control_ && !has_room(frames)) serve_control();  // An ACK may be waiting
+        return has_room(frames);
+    }
+
+    bool has_room(size_t frames) const noexcept {
+        // Frames of io_uring sends still in flight are being read by the kernel
+        const uint64_t reusable = flushed_ - (uring_submitted_ - uring_retired_);
+        if (next_seq_ + frames - reusable > ring_.slot_count()) return false;
+        // A message larger than the window still goes out once nothing is in flight
+        return !flow_control_ || next_seq_ == acked_ || next_seq_ + frames - acked_ <= send_window();
+    }
+
+    PublishResult enqueue(size_t len) noexcept {
+        queue(len);
+        if (next_seq_ - flushed_ >= batch_size_ ||
+            (batch_latency_ns_ > 0 && TscClock::elapsedNs(oldest_pending_) >= batch_latency_ns_)) {
+            flush();
+        }
+        return PublishResult::OK;
+    }
+
+    void queue(size_t len) noexcept {
+        ring_.set_frame_length(next_seq_, static_cast<uint16_t>(len));
+        retransmitted_at_[next_seq_ & (ring_.slot_count() - 1)] = 0;
+        if (next_seq_ == flushed_) oldest_pending_ = TscClock::now();
+        next_seq_++;  // The ring position doubles as the sequence number
+    }
+
+    // Add a whole message to the frame being packed at next_seq_
+    PublishResult pack(std::span<const uint8_t> payload) noexcept {
+        const size_t max_payload = ring_.max_payload();
+        if (packing_ && packed_length_ + hsnet::proto::BATCH_PREFIX_BYTES + payload.size() > max_payload) {
+            enqueue(finish_packed());
+        }
+        if (!packing_) {
+            if (!connect()) return PublishResult::NOTCONNECTED;
+            if (!make_room(1)) return PublishResult::BACKPRESSURED;
+            packing_ = true;
+            packed_length_ = 0;
+            packing_since_ = TscClock::now();
+        }
+        packed_length_ =
+            hsnet::proto::append_batched(ring_.payload(next_seq_), packed_length_, payload.data(), payload.size());
+        stats_.messagesPacked++;
+        // Full (not even an empty message fits), or waited long enough
+        if (packed_length_ + hsnet::proto::BATCH_PREFIX_BYTES > max_payload ||
+            TscClock::elapsedNs(packing_since_) >= coalesce_delay_ns_) {
+            enqueue(finish_packed());
+        }
+        return PublishResult::OK;
+    }
+
+    // Seal the packed frame; returns its length for queue()/enqueue()
+    size_t finish_packed() noexcept {
+        packing_ = false;
+        hsnet::proto::Header header = make_header(packed_length_, true);
+        hsnet::proto::set_type_flags(header, hsnet::proto::FrameType::DATA,
+                                     hsnet::proto::frame_flags(header) | hsnet::proto::FLAG_BATCHED);
+        return hsnet::proto::seal_frame(ring_.frame(next_seq_), header);
+    }
+
+    StreamId stream_;
+    bool crc_;
+    TxRing ring_;
+    size_t max_message_size_;
+    uint64_t next_seq_{0};
+    uint64_t flushed_{0};         // Frames before this sequence have been sent
+    uint64_t oldest_pending_{0};  // TscClock ticks when frame `flushed_` was queued
+    bool claimed_{false};
+    size_t claim_length_{0};
+
+    size_t batch_size_;
+    uint64_t batch_latency_ns_;       // 0: no bound
+    std::vector<iovec> iov_;          // One per queued frame
+    std::vector<mmsghdr> msgs_;       // One per datagram, or per GSO run
+    std::vector<size_t> run_frames_;  // Frames carried by each message
+
+    bool coalesce_;
+    uint64_t coalesce_delay_ns_;
+    bool packing_{false};        // A batched frame is being packed at next_seq_
+    size_t packed_length_{0};    // Its payload so far
+    uint64_t packing_since_{0};  // TscClock ticks of its first message
+
+    struct GsoControl {
+        alignas(cmsghdr) char buf[CMSG_SPACE(sizeof(uint16_t))];
+    };
+    std::vector<GsoControl> gso_control_;
+
+    // A SENDMSG in flight; the kernel reads msg until it completes
+    struct UringSend {
+        msghdr msg;
+        iovec iov;
+        bool done;
+    };
+    std::unique_ptr<IoUring> uring_;    // Null unless sending through io_uring
+    std::vector<UringSend> uring_sends_;  // Indexed by submission count
+    uint64_t uring_submitted_{0};
+    uint64_t uring_retired_{0};         // Sends before this one have completed
+
+    std::vector<uint64_t> retransmitted_at_;  // TscClock ticks of each slot's last resend, 0 if none
+    uint64_t nak_suppress_ns_;
+    RxBatch control_;                         // NAKs read from the socket
+    uint64_t last_control_poll_{0};
+    std::array<hsnet::ctrl::NakRange, hsnet::proto::MAX_NAK_RANGES> nak_ranges_{};
+    PublicationStats stats_{};
+
+    bool flow_control_;
+    uint64_t acked_{0};           // Frames before this sequence have been acknowledged
+    uint64_t sack_{0};            // Last SACK bitmap, relative to acked_
+    uint64_t peer_window_;        // Receive window from the last ACK
+    std::vector<uint64_t> sent_at_;  // TscClock ticks each slot's frame was sent
+    uint64_t last_progress_{0};   // TscClock ticks of the last ACK that moved acked_
+    uint64_t srtt_ns_{0};
+    uint64_t rttvar_ns_{0};
+    uint64_t rto_backoff_{1};
+
+    uint64_t session_id_;
+    uint64_t heartbeat_interval_ns_;  // 0: no heartbeats
+    uint64_t last_sent_{0};           // TscClock ticks of the last frame of any kind
+    bool peer_connected_{false};      // The peer answered our HELLO
+    uint64_t last_hello_{0};          // TscClock ticks of the last HELLO
+    std::array<uint8_t, hsnet::proto::SESSION_FRAME_BYTES> session_frame_{};
 };
 
-class UdpSubscription : public ISubscription {
+// Send-side settings shared by UdpConfig and FeedPublisherConfig
+template <typename Config>
+DatagramPublicationConfig publication_config(const Config& cfg) {
+    DatagramPublicationConfig out;
+    out.stream = cfg.stream_id;
+    out.mtu = cfg.mtu;
+    out.txRingSize = cfg.txRingSize;
+    out.retransmitRingSize = cfg.retransmitRingSize;
+    out.maxMessageSize = cfg.maxMessageSize;
+    out.crc = cfg.enable_crc32_c;
+    out.sendBatchSize = cfg.sendBatchSize;
+    out.sendBatchLatencyNs = cfg.sendBatchLatencyNs;
+    out.coalesce = cfg.enable_coalescing;
+    out.coalesceDelayNs = cfg.coalesceDelayNs;
+    out.nakSuppressNs = cfg.nakSuppressNs;
+    out.heartbeatIntervalNs = cfg.heartbeatIntervalNs;
+    return out;
+}
+
+// Point-to-point sessions are flow controlled by the peer's ACKs, starting
+// from a window of its (assumed matching) reorderWindow. Each publication
+// sends from its own socket, so the subscriber's NAKs, ACKs and HELLO
+// replies for the stream come back to it alone.
+class UdpPublication : public DatagramPublication {
    public:
-    explicit UdpSubscription(int sockfd) : sockfd_(sockfd), reorder_buffer_(1024) {}
-
-    int poll(std::function<void(const MessageView&)> handler, int maxMessages) noexcept override {
-        int count = 0;
-
-        // First, try to deliver any in-sequence packets from the reordering buffer
-        while (count < maxMessages && reorder_buffer_.has_ready()) {
-            auto data = reorder_buffer_.get_next();
-            if (data) {
-                MessageView v{
-                    data->first.data(),
-                    static_cast<uint16_t>(data->first.size()),
-                    data->second,                         // stream_id from packet
-                    reorder_buffer_.next_expected() - 1,  // sequence number
-                    0,                                    // receive time
-                    true                                  // endOfMessage
-                };
-                handler(v);
-                count++;
+    UdpPublication(StreamId stream, sockaddr_in dest, const UdpConfig& cfg)
+        : DatagramPublication(session_config(stream, cfg)) {
+        sockfd_ = socket(AF_INET, SOCK_DGRAM, 0);
+        if (sockfd_ < 0) throw std::runtime_error("Failed to create TX socket");
+        if (cfg.remote_endpoint == "multicast") {
+            int optval = 1;
+            setsockopt(sockfd_, IPPROTO_IP, IP_MULTICAST_TTL, &optval, sizeof(optval));
+            try {
+                set_multicast_interface(sockfd_, interface_address(cfg.local_endpoint.substr(0, cfg.local_endpoint.find(':'))));
+            } catch (...) {
+                close(sockfd_);
+                throw;
             }
         }
+        tune_socket(sockfd_, cfg);
+        dest_ = dest;
+        gso_ = cfg.enable_gso && udp_offload_supported(sockfd_, UDP_SEGMENT);
+        if (cfg.ioBackend == IoBackend::IO_URING) use_io_uring(cfg.ioUringEntries, cfg.ioUringSqPoll);
+        hello();
+    }
 
-        // Then try to receive new packets from the network
-        while (count < maxMessages) {
-            uint8_t buffer[2048];
-            sockaddr_in src{};
-            socklen_t sl = sizeof(src);
-            ssize_t n = recvfrom(sockfd_, buffer, sizeof(buffer), MSG_DONTWAIT, reinterpret_cast<sockaddr*>(&src), &sl);
-            if (n <= 0) break;
+    ~UdpPublication() override {
+        flush();
+        drain_sends();
+        close(sockfd_);
+    }
 
-            // Parse protocol header
-            hsnet::proto::Header header{};
-            if (n < static_cast<ssize_t>(sizeof(header))) {
-                // Packet too small, skip
-                continue;
-            }
+   private:
+    static DatagramPublicationConfig session_config(StreamId stream, const UdpConfig& cfg) {
+        DatagramPublicationConfig out = publication_config(cfg);
+        out.stream = stream;
+        out.flowControl = cfg.remote_endpoint != "multicast";
+        out.initialWindow = cfg.reorderWindow;
+        return out;
+    }
+};
 
-            auto parsed_header = hsnet::proto::parse_header(buffer, header);
-            if (!parsed_header) {
-                // Invalid header, skip
-                continue;
+class FeedPublication : public DatagramPublication {
+   public:
+    explicit FeedPublication(const FeedPublisherConfig& cfg)
+        : DatagramPublication(publication_config(cfg)) {
+        // Multicast setup
+        dest_.sin_family = AF_INET;
+        dest_.sin_port = htons(cfg.port);
+        dest_.sin_addr = multicast_group(cfg.multicast_group);
+        const in_addr interface = interface_address(cfg.local_interface);
+        sockfd_ = socket(AF_INET, SOCK_DGRAM, 0);
+        if (sockfd_ >= 0) {
+            int optval = 1;
+            setsockopt(sockfd_, IPPROTO_IP, IP_MULTICAST_TTL, &optval, sizeof(optval));
+            try {
+                set_multicast_interface(sockfd_, interface);
+            } catch (...) {
+                close(sockfd_);
+                throw;
             }
+            tune_socket(sockfd_, cfg);
+            gso_ = cfg.enable_gso && udp_offload_supported(sockfd_, UDP_SEGMENT);
+            hello();
+        }
+    }
 
-            // (problematic if receiving from multiple sources)
-            // (see UdpPublication constructor)
-            // uint64_t seq = header.sequence_number;
+    ~FeedPublication() override {
+        flush();
+        close(sockfd_);
+    }
+};
 
-            // For simplicity, assume in-order for now
-            uint64_t seq = reorder_buffer_.next_expected();
-            uint16_t payload_len = header.payload_length;
+// Receive-side settings shared by UdpConfig and FeedSubscriberConfig
+template <typename Config>
+DatagramSubscriptionConfig subscription_config(const Config& cfg) {
+    DatagramSubscriptionConfig out;
+    out.crc = cfg.enable_crc32_c;
+    out.mtu = cfg.mtu;
+    out.recvBatchSize = cfg.recvBatchSize;
+    out.gro = cfg.enable_gro;
+    out.timestamps = cfg.enable_timestamps;
+    out.reorderWindow = cfg.reorderWindow;
+    out.maxReorderWindow = cfg.maxReorderWindow;
+    out.maxMessageSize = cfg.maxMessageSize;
+    out.nakDelayNs = cfg.nakDelayNs;
+    out.nakRetryNs = cfg.nakRetryNs;
+    out.livenessTimeoutNs = cfg.livenessTimeoutNs;
+    out.stream = cfg.stream_id;
+    out.maxStreams = cfg.maxStreams;
+    return out;
+}
 
-            // Validate payload length
-            if (n < static_cast<ssize_t>(sizeof(header) + payload_len)) {
-                // Packet truncated, skip
-                continue;
-            }
+// Delivers every stream published to the group
+class FeedSubscription : public DatagramSubscription {
+   public:
+    explicit FeedSubscription(const FeedSubscriberConfig& cfg)
+        : DatagramSubscription(subscription_config(cfg)),
+          addr({}) {
+        sockfd_ = socket(AF_INET, SOCK_DGRAM, 0);
+        if (sockfd_ >= 0) {
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_ANY);
+            addr.sin_port = htons(cfg.port);
+            int optval = 1;
+            setsockopt(sockfd_, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval));
+            setsockopt(sockfd_, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof(optval));
 
-            // Extract payload data
-            std::vector<uint8_t> data(buffer + sizeof(header), buffer + sizeof(header) + payload_len);
-            
-            // Add to reordering buffer
-            if (reorder_buffer_.add(seq, std::move(data), header.stream_id)) {
-                // Packet was added successfully, try to deliver if it's in sequence
-                if (reorder_buffer_.has_ready()) {
-                    auto ready_data = reorder_buffer_.get_next();
-                    if (ready_data) {
-                        MessageView v{
-                            ready_data->first.data(),
-                            static_cast<uint16_t>(ready_data->first.size()),
-                            ready_data->second,                   // stream_id from packet
-                            reorder_buffer_.next_expected() - 1,  // sequence number
-                            0,                                    // receive time
-                            true                                  // endOfMessage
-                        };
-                        handler(v);
-                        count++;
-                    }
-                }
+            try {
+                if (bind(sockfd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+                    throw std::runtime_error("Failed to bind or create subscription socket!");
+                // Only the channels asked for reach the socket
+                const std::vector<std::string> single{cfg.multicast_group};
+                join_groups(sockfd_, cfg.multicast_groups.empty() ? single : cfg.multicast_groups,
+                            interface_address(cfg.local_interface));
+            } catch (...) {
+                close(sockfd_);
+                throw;
             }
+            // Best effort: without GRO every datagram simply arrives on its own
+            if (cfg.enable_gro) setsockopt(sockfd_, SOL_UDP, UDP_GRO, &optval, sizeof(optval));
+            if (cfg.enable_timestamps) setsockopt(sockfd_, SOL_SOCKET, SO_TIMESTAMPNS, &optval, sizeof(optval));
+            tune_socket(sockfd_, cfg);
         }
+    }
+
+    ~FeedSubscription() override { close(sockfd_); }
 
-        return count;
+   private:
+    sockaddr_in addr;
+};
+
+// The transport's receiver: owns the RX socket and ACKs every stream's
+// sender for flow control
+class UdpSubscription : public DatagramSubscription {
+   public:
+    UdpSubscription(int sockfd, const UdpConfig& cfg) : DatagramSubscription(ack_config(cfg)) { sockfd_ = sockfd; }
+
+    ~UdpSubscription() override { close(sockfd_); }
+
+   private:
+    static DatagramSubscriptionConfig ack_config(const UdpConfig& cfg) {
+        DatagramSubscriptionConfig out = subscription_config(cfg);
+        out.acks = true;
+        out.ackIntervalNs = cfg.ackIntervalNs;
+        out.ioUring = cfg.ioBackend == IoBackend::IO_URING;
+        out.sqPoll = cfg.ioUringSqPoll;
+        out.ioUringEntries = cfg.ioUringEntries;
+        return out;
     }
+};
 
-    bool hasData() const noexcept override {
-        return reorder_buffer_.has_ready();
+// One stream of the transport's receiver. Polling it reads the socket for
+// all streams, delivers this one and leaves the rest buffered for theirs.
+class StreamSubscription : public ISubscription {
+   public:
+    StreamSubscription(std::shared_ptr<UdpSubscription> receiver, StreamId stream)
+        : receiver_(std::move(receiver)), stream_(stream) {}
+
+    int poll(FunctionRef<void(const MessageView&)> handler, int maxMessages) noexcept override {
+        return receiver_->pollStream(stream_, handler, maxMessages);
     }
 
+    int pollBatch(FunctionRef<void(std::span<const MessageView>)> handler, int maxMessages) noexcept override {
+        return receiver_->pollStreamBatch(stream_, handler, maxMessages);
+    }
+
+    bool hasData() const noexcept override { return receiver_->hasData(stream_); }
+    bool isConnected() const noexcept override { return receiver_->isConnected(stream_); }
+    // The receiver's counters, all streams included
+    SubscriptionStats stats() const noexcept override { return receiver_->stats(); }
+    const LatencyHistogram* latency(StreamId stream) const noexcept override { return receiver_->latency(stream); }
+
    private:
-    int sockfd_;
-    ReorderingBuffer reorder_buffer_;
-    static constexpr size_t buffer_size = 2048;
+    std::shared_ptr<UdpSubscription> receiver_;
+    StreamId stream_;
 };
 
 class UdpReliableTransport : public ITransport {
@@ -314,18 +909,20 @@ class UdpReliableTransport : public ITransport {
             auto colon = cfg.local_endpoint.find(':');
             std::string ip = cfg.local_endpoint.substr(0, colon);
             uint16_t port = static_cast<uint16_t>(std::stoi(cfg.local_endpoint.substr(colon + 1)));
-            addr.sin_addr.s_addr = ip.empty() ? INADDR_ANY : inet_addr(ip.c_str());
-            addr.sin_addr.s_addr = INADDR_ANY;
-            addr.sin_port = htons(MULTICAST_PORT);
-            if (bind(rxSock_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            // Multicast sessions receive the group on its port through the
+            // local ip's interface, point-to-point ones on their own address
+            // so two peers can share a host
+            const bool multicast = cfg_.remote_endpoint == "multicast";
+            addr.sin_addr = multicast ? in_addr{htonl(INADDR_ANY)} : interface_address(ip);
+            addr.sin_port = htons(multicast ? cfg_.multicast_port : port);
+            try {
+                if (bind(rxSock_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+                    throw std::runtime_error("Failed to create or bind RX socket");
+                if (multicast) join_groups(rxSock_, std::span<const std::string>(&cfg_.multicast_group, 1), interface_address(ip));
+            } catch (...) {
                 close(rxSock_);
-                rxSock_ = -1;  // Mark as invalid
+                throw;
             }
-            ip_mreq mreq;
-            mreq.imr_multiaddr.s_addr = inet_addr(std::string{MULTICAST_ADDR}.c_str());
-            mreq.imr_interface.s_addr = htonl(INADDR_ANY);
-            //
-            setsockopt(rxSock_, IPPROTO_IP, IP_ADD_MEMBERSHIP, (char*)&mreq, sizeof(mreq));
         }
         if (rxSock_ < 0) {
             throw std::runtime_error("Failed to create or bind RX socket");
@@ -333,61 +930,72 @@ class UdpReliableTransport : public ITransport {
         // Set socket options
         int optval = 1;
         setsockopt(rxSock_, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval));
-
-        // Create TX socket and set destination
-        // Make tx socket non-blocking and multicast
-        txSock_ = socket(AF_INET, SOCK_DGRAM, 0);
-        sockaddr_in tx_addr{};
-        if (txSock_ >= 0) {
-            // setup multicast
-            tx_addr.sin_family = AF_INET;
-            if (cfg_.remote_endpoint == "multicast") {
-                tx_addr.sin_port = htons(MULTICAST_PORT);
-                tx_addr.sin_addr.s_addr = inet_addr(std::string{MULTICAST_ADDR}.c_str());
-                dest_ = tx_addr;
-                setsockopt(txSock_, IPPROTO_IP, IP_MULTICAST_TTL, &optval, sizeof(optval));
-            } else {
-                auto colon = cfg.remote_endpoint.find(':');
-                std::string ip = cfg.remote_endpoint.substr(0, colon);
-                uint16_t port = static_cast<uint16_t>(std::stoi(cfg.remote_endpoint.substr(colon + 1)));
-                dest_.sin_family = AF_INET;
-                dest_.sin_port = htons(port);
-                inet_pton(AF_INET, ip.c_str(), &dest_.sin_addr);
-            }
+        if (cfg_.enable_gro) setsockopt(rxSock_, SOL_UDP, UDP_GRO, &optval, sizeof(optval));
+        if (cfg_.enable_timestamps) setsockopt(rxSock_, SOL_SOCKET, SO_TIMESTAMPNS, &optval, sizeof(optval));
+        tune_socket(rxSock_, cfg_);
+        // Subscriptions share the receiver, which closes the socket
+        receiver_ = std::make_shared<UdpSubscription>(rxSock_, cfg_);
+
+        // Destination of the publications, which each send from their own socket
+        dest_.sin_family = AF_INET;
+        if (cfg_.remote_endpoint == "multicast") {
+            dest_.sin_port = htons(cfg_.multicast_port);
+            dest_.sin_addr = multicast_group(cfg_.multicast_group);
+        } else {
+            auto colon = cfg.remote_endpoint.find(':');
+            std::string ip = cfg.remote_endpoint.substr(0, colon);
+            uint16_t port = static_cast<uint16_t>(std::stoi(cfg.remote_endpoint.substr(colon + 1)));
+            dest_.sin_port = htons(port);
+            inet_pton(AF_INET, ip.c_str(), &dest_.sin_addr);
         }
     }
 
-    ~UdpReliableTransport() override {
-        if (rxSock_ >= 0) close(rxSock_);
-        if (txSock_ >= 0) close(txSock_);
-    }
-
     std::unique_ptr<IPublication> create_publication(std::string_view endpoint, StreamId stream) override {
         (void)endpoint;
-        (void)stream;
-        return std::make_unique<UdpPublication>(txSock_, dest_);
+        return std::make_unique<UdpPublication>(stream, dest_, cfg_);
     }
 
     std::unique_ptr<ISubscription> create_subscription(std::string_view endpoint, StreamId stream) override {
         (void)endpoint;
-        (void)stream;
-        return std::make_unique<UdpSubscription>(rxSock_);
+        return std::make_unique<StreamSubscription>(receiver_, stream);
     }
 
    private:
     UdpConfig cfg_{};
     int rxSock_{-1};
-    int txSock_{-1};
+    std::shared_ptr<UdpSubscription> receiver_;
     sockaddr_in dest_{};
 };
 
 }  // namespace
 
+std::string FeedChannels::group(uint32_t channel) const {
+    const uint32_t base = ntohl(multicast_group(base_group).s_addr);
+    const uint64_t address = static_cast<uint64_t>(base) + channel;
+    if (address > 0xEFFFFFFFu) throw std::runtime_error("Channel " + std::to_string(channel) + " is past the multicast range");
+    in_addr a{htonl(static_cast<uint32_t>(address))};
+    char text[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &a, text, sizeof(text));
+    return text;
+}
+
+std::vector<std::string> FeedChannels::groups_for(std::span<const uint32_t> instruments) const {
+    std::vector<uint32_t> channels;
+    channels.reserve(instruments.size());
+    for (uint32_t instrument : instruments) channels.push_back(channel_of(instrument));
+    std::sort(channels.begin(), channels.end());
+    channels.erase(std::unique(channels.begin(), channels.end()), channels.end());
+    std::vector<std::string> groups;
+    groups.reserve(channels.size());
+    for (uint32_t channel : channels) groups.push_back(group(channel));
+    return groups;
+}
+
 std::unique_ptr<IPublication> make_udp_reliable_publisher(const FeedPublisherConfig& cfg) {
     return std::make_unique<FeedPublication>(cfg);
 }
 
-std::unique_ptr<ISubscription> make_udp_reliable_subscriber(const FeedSubscriberConfig& cfg) {
+std::unique_ptr<DatagramSubscription> make_udp_reliable_subscriber(const FeedSubscriberConfig& cfg) {
     return std::make_unique<FeedSubscription>(cfg);
 }
 
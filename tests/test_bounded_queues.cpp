@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MpmcQueue.h"
+#include "Order.h"
+#include "SpscQueue.h"
+
+// Suite: SpscQueueTest
+// Purpose: Bounded SPSC ring semantics (capacity, FIFO order, wrap-around).
+TEST(SpscQueueTest, CapacityRoundsToPowerOfTwo) {
+    SpscQueue<int> q(5);
+    EXPECT_EQ(q.capacity(), 8u);
+}
+
+TEST(SpscQueueTest, PushUntilFullThenDrain) {
+    SpscQueue<int> q(4);
+    for (int i = 0; i < 4; ++i) EXPECT_TRUE(q.try_push(i));
+    EXPECT_FALSE(q.try_push(99)) << "Push into a full ring should fail";
+
+    for (int i = 0; i < 4; ++i) {
+        auto v = q.pop();
+        ASSERT_TRUE(v.has_value());
+        EXPECT_EQ(*v, i);
+    }
+    EXPECT_FALSE(q.pop().has_value());
+}
+
+TEST(SpscQueueTest, WrapAroundKeepsOrder) {
+    SpscQueue<std::string> q(4);
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_TRUE(q.try_push(std::to_string(i)));
+        std::string out;
+        ASSERT_TRUE(q.pop(out));
+        EXPECT_EQ(out, std::to_string(i));
+    }
+}
+
+TEST(SpscQueueTest, FrontPeeksWithoutConsuming) {
+    SpscQueue<int> q(4);
+    EXPECT_EQ(q.front(), nullptr);
+    q.try_push(7);
+    ASSERT_NE(q.front(), nullptr);
+    EXPECT_EQ(*q.front(), 7);
+    q.pop_front();
+    EXPECT_EQ(q.front(), nullptr);
+}
+
+TEST(SpscQueueTest, HoldsNonDefaultConstructibleOrders) {
+    SpscQueue<Order> q(2);
+    EXPECT_TRUE(q.try_push(Order::createLimitOrder(BUY, 100.0, 10)));
+    auto o = q.pop();
+    ASSERT_TRUE(o.has_value());
+    EXPECT_EQ(o->getSize(), 10u);
+}
+
+TEST(SpscQueueTest, ConcurrentProducerConsumer) {
+    SpscQueue<uint64_t> q(64);
+    const uint64_t N = 200000;
+    std::thread producer([&] {
+        for (uint64_t i = 0; i < N; ++i) {
+            while (!q.try_push(i)) std::this_thread::yield();
+        }
+    });
+
+    uint64_t expected = 0;
+    while (expected < N) {
+        auto v = q.pop();
+        if (!v) {
+            std::this_thread::yield();
+            continue;
+        }
+        ASSERT_EQ(*v, expected);
+        ++expected;
+    }
+    producer.join();
+}
+
+// Suite: MpmcQueueTest
+// Purpose: Bounded MPMC ring semantics and no loss/duplication under contention.
+TEST(MpmcQueueTest, PushUntilFullThenDrain) {
+    MpmcQueue<int> q(4);
+    for (int i = 0; i < 4; ++i) EXPECT_TRUE(q.try_push(i));
+    EXPECT_FALSE(q.try_push(99));
+    for (int i = 0; i < 4; ++i) {
+        auto v = q.pop();
+        ASSERT_TRUE(v.has_value());
+        EXPECT_EQ(*v, i);
+    }
+    EXPECT_FALSE(q.pop().has_value());
+}
+
+TEST(MpmcQueueTest, MultiProducerMultiConsumer) {
+    MpmcQueue<uint64_t> q(128);
+    const size_t producers = 3, consumers = 3;
+    const uint64_t per_producer = 50000;
+    const uint64_t total = producers * per_producer;
+
+    std::atomic<uint64_t> consumed{0};
+    std::atomic<uint64_t> sum{0};
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            for (uint64_t i = 0; i < per_producer; ++i) {
+                uint64_t v = p * per_producer + i;
+                while (!q.try_push(v)) std::this_thread::yield();
+            }
+        });
+    }
+    for (size_t c = 0; c < consumers; ++c) {
+        threads.emplace_back([&] {
+            while (consumed.load() < total) {
+                auto v = q.pop();
+                if (!v) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                sum += *v;
+                consumed++;
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    EXPECT_EQ(consumed.load(), total);
+    EXPECT_EQ(sum.load(), total * (total - 1) / 2) << "Every value should be delivered exactly once";
+}
@@ -1,6 +1,23 @@
 #include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
 #include "net/Crc32c.h"
 
+namespace {
+// Bit-at-a-time reference, independent of every table in Crc32c.cpp
+uint32_t crc32c_reference(const uint8_t* data, size_t len) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < len; ++i) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; ++b) crc = (crc >> 1) ^ (0x82F63B78 & (0u - (crc & 1)));
+    }
+    return crc ^ 0xFFFFFFFF;
+}
+}  // namespace
+
 TEST(Crc32c, KnownVectors) {
     // Test vectors from RFC 3720 (iSCSI)
     const char test1[] = "";
@@ -44,4 +61,53 @@ TEST(Crc32c, LargeData) {
     uint32_t result = hsnet::crc32c(large_data.data(), large_data.size());
     // Just ensure it doesn't crash and produces a non-zero result
     EXPECT_NE(result, 0x00000000);
-} 
\ No newline at end of file
+} 
+TEST(Crc32c, AllImplementationsAgree) {
+    std::mt19937 rng(42);
+    std::vector<uint8_t> buffer(3 * 8192 * 2 + 3 * 256 + 64);
+    for (auto& b : buffer) b = static_cast<uint8_t>(rng());
+
+    // Cover every path: unaligned heads, the long and short interleaved
+    // blocks, the 8-byte loop and the byte tail
+    std::vector<size_t> lengths = {0, 1, 7, 8, 9, 63, 255, 767, 768, 769, 1500, 3 * 8192, 3 * 8192 + 3 * 256 + 5,
+                                   buffer.size() - 8};
+    for (int i = 0; i < 200; ++i) lengths.push_back(rng() % (buffer.size() - 8));
+
+    for (size_t len : lengths) {
+        for (size_t offset = 0; offset < 8; ++offset) {
+            const uint8_t* p = buffer.data() + offset;
+            const uint32_t expected = crc32c_reference(p, len);
+            ASSERT_EQ(hsnet::crc32c_sw(p, len), expected) << "sw len=" << len << " offset=" << offset;
+            ASSERT_EQ(hsnet::crc32c_hw(p, len), expected) << "hw len=" << len << " offset=" << offset;
+            ASSERT_EQ(hsnet::crc32c(p, len), expected) << "dispatch len=" << len << " offset=" << offset;
+        }
+    }
+}
+
+TEST(Crc32c, ReportsHardwareSupport) {
+#if defined(__x86_64__)
+    EXPECT_EQ(hsnet::crc32c_hw_available(), static_cast<bool>(__builtin_cpu_supports("sse4.2")));
+#else
+    GTEST_SKIP() << "Feature probe only checked on x86-64";
+#endif
+}
+
+TEST(Crc32c, ExtendAndCopyMatchOneShot) {
+    std::mt19937 rng(7);
+    std::vector<uint8_t> src(3 * 8192 + 3 * 256 + 99);
+    for (auto& b : src) b = static_cast<uint8_t>(rng());
+
+    for (size_t len : {size_t{0}, size_t{5}, size_t{40}, size_t{1460}, src.size() - 3}) {
+        for (size_t split : {size_t{0}, len / 3, len}) {
+            const uint8_t* p = src.data() + 3;
+            const uint32_t whole = hsnet::crc32c(p, len);
+            EXPECT_EQ(hsnet::crc32c_extend(hsnet::crc32c(p, split), p + split, len - split), whole);
+
+            std::vector<uint8_t> dst(len + 1, 0xAA);
+            const uint32_t head = hsnet::crc32c(p, split);
+            EXPECT_EQ(hsnet::crc32c_copy(dst.data() + 1, p + split, len - split, head), whole) << "len=" << len;
+            EXPECT_EQ(std::memcmp(dst.data() + 1, p + split, len - split), 0);
+            EXPECT_EQ(dst[0], 0xAA) << "Copy must not write before dst";
+        }
+    }
+}
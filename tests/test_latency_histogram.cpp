@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "net/LatencyHistogram.h"
+
+TEST(LatencyHistogram, SmallValuesAreExact) {
+    hsnet::LatencyHistogram h;
+    EXPECT_EQ(h.percentile(0.5), 0u);
+    for (uint64_t v = 1; v <= 20; ++v) h.record(v);
+    EXPECT_EQ(h.count(), 20u);
+    EXPECT_EQ(h.min(), 1u);
+    EXPECT_EQ(h.max(), 20u);
+    EXPECT_EQ(h.mean(), 10u);
+    EXPECT_EQ(h.percentile(0.5), 10u);
+    EXPECT_EQ(h.percentile(0.0), 1u);
+    EXPECT_EQ(h.percentile(1.0), 20u);
+
+    h.reset();
+    EXPECT_EQ(h.count(), 0u);
+    EXPECT_EQ(h.min(), 0u);
+    EXPECT_EQ(h.max(), 0u);
+}
+
+TEST(LatencyHistogram, PercentilesWithinBucketPrecision) {
+    std::mt19937_64 rng(7);
+    std::lognormal_distribution<double> dist(10.0, 1.5);  // Around 20us, long tail
+    std::vector<uint64_t> values;
+    hsnet::LatencyHistogram h;
+    for (int i = 0; i < 100000; ++i) {
+        const uint64_t v = static_cast<uint64_t>(dist(rng));
+        values.push_back(v);
+        h.record(v);
+    }
+    std::sort(values.begin(), values.end());
+    for (double p : {0.5, 0.9, 0.99, 0.999}) {
+        const uint64_t exact = values[static_cast<size_t>(p * values.size()) - 1];
+        const uint64_t reported = h.percentile(p);
+        EXPECT_GE(reported, exact) << p;
+        EXPECT_LE(reported, exact + exact / 16 + 1) << p;
+    }
+    EXPECT_EQ(h.max(), values.back());
+
+    // Beyond the range: counted at the top
+    h.record(UINT64_MAX);
+    EXPECT_EQ(h.max(), hsnet::LatencyHistogram::MAX_NS);
+    EXPECT_EQ(h.percentile(1.0), hsnet::LatencyHistogram::MAX_NS);
+}
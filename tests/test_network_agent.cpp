@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+
+#include "net/NetworkAgent.h"
+#include "net/ShmTransport.h"
+#include "net/Transport.h"
+#include "net/UdpReliable.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+hsnet::ShmConfig shm_config(const std::string& test) {
+    hsnet::ShmConfig cfg;
+    cfg.name = "hsnet-test-agent-" + test + "-" + std::to_string(getpid());
+    cfg.logBufferSize = 1u << 16;
+    return cfg;
+}
+
+std::string shm_path(const hsnet::ShmConfig& cfg, hsnet::StreamId stream) {
+    return cfg.directory + "/" + cfg.name + "-" + std::to_string(stream);
+}
+
+// Message i: its index, then filler up to a length that varies with it
+std::vector<uint8_t> message(uint32_t i) {
+    std::vector<uint8_t> m(4 + i % 300, static_cast<uint8_t>(i));
+    std::memcpy(m.data(), &i, sizeof(i));
+    return m;
+}
+
+template <typename Done>
+void wait_for(Done&& done) {
+    const auto start = std::chrono::steady_clock::now();
+    while (!done() && std::chrono::steady_clock::now() - start < 10s) std::this_thread::sleep_for(100us);
+}
+}  // namespace
+
+TEST(NetworkAgent, RelaysBothWaysInOrder) {
+    const hsnet::ShmConfig cfg = shm_config("order");
+    auto transport = hsnet::make_shm_transport(cfg);
+
+    hsnet::NetworkAgentConfig agentCfg;
+    agentCfg.idle = hsnet::IdleStrategy::BACKOFF;
+    agentCfg.ringBytes = 1u << 14;  // Small: both rings wrap and fill many times over
+    agentCfg.maxMessageSize = 1024;
+    hsnet::NetworkAgent agent(agentCfg);
+    auto sub = agent.add_subscription(transport->create_subscription("", 7));
+    auto pub = agent.add_publication(transport->create_publication("", 7));
+    agent.start();
+    EXPECT_TRUE(agent.running());
+
+    constexpr uint32_t total = 20000;
+    uint32_t offered = 0;
+    uint32_t received = 0;
+    auto check = [&](const hsnet::MessageView& mv) {
+        const std::vector<uint8_t> expected = message(received);
+        ASSERT_EQ(mv.length, expected.size());
+        EXPECT_EQ(std::memcmp(mv.data, expected.data(), expected.size()), 0);
+        EXPECT_EQ(mv.sequenceNumber, received);
+        EXPECT_EQ(mv.streamId, 7u);
+        EXPECT_TRUE(mv.endOfMessage);
+        ++received;
+    };
+    const auto start = std::chrono::steady_clock::now();
+    while (received < total && std::chrono::steady_clock::now() - start < 10s) {
+        while (offered < total) {
+            const std::vector<uint8_t> m = message(offered);
+            if (offered % 2 == 0) {
+                if (pub->offer(m, 7) != hsnet::PublishResult::OK) break;
+            } else {
+                // Claimed generously, committed at the real length
+                std::span<uint8_t> claim = pub->tryClaim(m.size() + 64);
+                if (claim.empty()) break;
+                std::memcpy(claim.data(), m.data(), m.size());
+                ASSERT_EQ(pub->commit(m.size(), 7), hsnet::PublishResult::OK);
+            }
+            ++offered;
+        }
+        sub->poll(check, 50);
+    }
+    EXPECT_EQ(received, total);
+    EXPECT_FALSE(sub->hasData());
+
+    // Snapshots catch up within a few milliseconds
+    wait_for([&] { return sub->stats().messagesDelivered == total && pub->stats().framesSent == total; });
+    EXPECT_EQ(sub->stats().messagesDelivered, total);
+    EXPECT_EQ(pub->stats().framesSent, total);
+    EXPECT_TRUE(sub->isConnected());
+    EXPECT_TRUE(pub->isConnected());
+
+    agent.stop();
+    EXPECT_FALSE(agent.running());
+    const hsnet::NetworkAgentStats stats = agent.stats();
+    EXPECT_GT(stats.dutyCycles, 0u);
+    EXPECT_EQ(stats.oversizedDropped, 0u);
+    EXPECT_EQ(stats.offersRejected, 0u);
+
+    // Too big for the ring
+    EXPECT_EQ(pub->offer(std::vector<uint8_t>(1u << 14), 7), hsnet::PublishResult::ERROR);
+    unlink(shm_path(cfg, 7).c_str());
+}
+
+TEST(NetworkAgent, DropsMessagesOverMaxMessageSize) {
+    const hsnet::ShmConfig cfg = shm_config("oversized");
+    auto transport = hsnet::make_shm_transport(cfg);
+    auto direct = transport->create_publication("", 2);
+
+    hsnet::NetworkAgentConfig agentCfg;
+    agentCfg.ringBytes = 1u << 12;
+    agentCfg.maxMessageSize = 64;
+    agentCfg.idle = hsnet::IdleStrategy::YIELD;
+    hsnet::NetworkAgent agent(agentCfg);
+    auto sub = agent.add_subscription(transport->create_subscription("", 2));
+    agent.start();
+
+    ASSERT_EQ(direct->offer(std::vector<uint8_t>(200), 2), hsnet::PublishResult::OK);
+    ASSERT_EQ(direct->offer(std::vector<uint8_t>(64, 1), 2), hsnet::PublishResult::OK);
+    std::vector<uint32_t> lengths;
+    wait_for([&] {
+        sub->poll([&](const hsnet::MessageView& mv) { lengths.push_back(mv.length); }, 8);
+        return !lengths.empty();
+    });
+    EXPECT_EQ(lengths, std::vector<uint32_t>{64});
+    EXPECT_EQ(agent.stats().oversizedDropped, 1u);
+
+    // A ring that can't hold four of the largest messages is refused
+    hsnet::NetworkAgentConfig tight;
+    tight.ringBytes = 1u << 12;
+    tight.maxMessageSize = 4096;
+    hsnet::NetworkAgent small(tight);
+    EXPECT_THROW(small.add_subscription(transport->create_subscription("", 2)), std::invalid_argument);
+    agent.stop();
+    unlink(shm_path(cfg, 2).c_str());
+}
+
+TEST(NetworkAgent, PinnedAgentRunsAFeed) {
+    hsnet::FeedPublisherConfig pubCfg;
+    pubCfg.socketSendBufferBytes = 1u << 20;
+    hsnet::FeedSubscriberConfig subCfg;
+    subCfg.socketRecvBufferBytes = 1u << 22;
+    subCfg.busyPollUs = 50;
+
+    hsnet::NetworkAgentConfig agentCfg;
+    agentCfg.cpu = 0;
+    hsnet::NetworkAgent agent(agentCfg);
+    auto sub = agent.add_subscription(hsnet::make_udp_reliable_subscriber(subCfg));
+    agent.start();
+    // Added while running
+    auto pub = agent.add_publication(hsnet::make_udp_reliable_publisher(pubCfg));
+
+    constexpr uint32_t total = 2000;
+    uint32_t offered = 0;
+    std::vector<uint32_t> received;
+    const auto start = std::chrono::steady_clock::now();
+    while (received.size() < total && std::chrono::steady_clock::now() - start < 10s) {
+        while (offered < total &&
+               pub->offer(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(&offered), sizeof(offered)),
+                          pubCfg.stream_id) == hsnet::PublishResult::OK)
+            ++offered;
+        sub->poll([&](const hsnet::MessageView& mv) {
+            uint32_t v;
+            std::memcpy(&v, mv.data, sizeof(v));
+            received.push_back(v);
+        }, 64);
+    }
+    ASSERT_EQ(received.size(), total);
+    for (uint32_t i = 0; i < total; ++i) ASSERT_EQ(received[i], i);
+
+    // Pinning to a core that doesn't exist fails loudly
+    hsnet::NetworkAgentConfig bad;
+    bad.cpu = CPU_SETSIZE - 1;
+    hsnet::NetworkAgent unpinnable(bad);
+    EXPECT_THROW(unpinnable.start(), std::runtime_error);
+    EXPECT_FALSE(unpinnable.running());
+}
@@ -1,9 +1,21 @@
 #include <gtest/gtest.h>
 #include "net/ReorderingBuffer.h"
+#include "net/Protocol.h"
 
+#include <cstring>
+#include <optional>
 #include <string>
 #include <vector>
 
+namespace {
+// Deliver the next packet and copy it out before its slot is released
+std::optional<std::vector<uint8_t>> next(hsnet::ReorderingBuffer& buffer) {
+    std::optional<std::vector<uint8_t>> out;
+    buffer.deliver_next(0, [&](const hsnet::MessageView& v) { out.emplace(v.data, v.data + v.length); });
+    return out;
+}
+}  // namespace
+
 TEST(ReorderingBuffer, BasicOperations) {
     hsnet::ReorderingBuffer buffer(4);
     
@@ -26,17 +38,17 @@ TEST(ReorderingBuffer, InSequenceDelivery) {
     EXPECT_TRUE(buffer.has_ready());
     
     // Get first packet
-    auto result1 = buffer.get_next();
+    auto result1 = next(buffer);
     EXPECT_TRUE(result1.has_value());
     auto d1 = *result1;
-    EXPECT_EQ(d1.first, data1);
+    EXPECT_EQ(d1, data1);
     EXPECT_EQ(buffer.next_expected(), 1);
     // Get second packet
-    auto result2 = buffer.get_next();
+    auto result2 = next(buffer);
 
     EXPECT_TRUE(result2.has_value());
     d1 = *result2;
-    EXPECT_EQ(d1.first, data2);
+    EXPECT_EQ(d1, data2);
     EXPECT_EQ(buffer.next_expected(), 2);
     
     EXPECT_EQ(buffer.size(), 0);
@@ -59,20 +71,20 @@ TEST(ReorderingBuffer, OutOfOrderDelivery) {
     EXPECT_TRUE(buffer.has_ready());
     
     // Should deliver in sequence: 0, 1, 2
-    auto result1 = buffer.get_next();
+    auto result1 = next(buffer);
     EXPECT_TRUE(result1.has_value());
     auto p = *result1;
-    EXPECT_EQ(p.first, data1);
+    EXPECT_EQ(p, data1);
     
-    auto result2 = buffer.get_next();
+    auto result2 = next(buffer);
     EXPECT_TRUE(result2.has_value());
     p = *result2;
-    EXPECT_EQ(p.first, data2);
+    EXPECT_EQ(p, data2);
     
-    auto result3 = buffer.get_next();
+    auto result3 = next(buffer);
     EXPECT_TRUE(result3.has_value());
     p = *result3;
-    EXPECT_EQ(p.first, data3);
+    EXPECT_EQ(p, data3);
     
     EXPECT_EQ(buffer.size(), 0);
     EXPECT_FALSE(buffer.has_ready());
@@ -98,7 +110,7 @@ TEST(ReorderingBuffer, OldPackets) {
     
     // Advance sequence to 5
     buffer.add(5, data);
-    buffer.get_next(); // Consume packet 5
+    next(buffer); // Consume packet 5
     
     // Try to add old packet
     EXPECT_FALSE(buffer.add(4, data)); // Old packet should be ignored
@@ -132,9 +144,9 @@ TEST(ReorderingBuffer, GapsInSequence) {
     EXPECT_TRUE(buffer.add(6, data1));
 
     // Should only be able to get packet 0
-    auto result = buffer.get_next();
+    auto result = next(buffer);
     EXPECT_TRUE(result.has_value());
-    EXPECT_EQ(result->first, data1);
+    EXPECT_EQ(*result, data1);
 
     // No more packets should be ready
     EXPECT_FALSE(buffer.has_ready());
@@ -149,7 +161,7 @@ TEST(ReorderingBuffer, CircularBufferWrapping) {
     // Fill buffer and consume to force wrapping
     for (uint64_t i = 0; i < 10; ++i) {
         EXPECT_TRUE(buffer.add(i, data));
-        auto result = buffer.get_next();
+        auto result = next(buffer);
         EXPECT_TRUE(result.has_value());
     }
 
@@ -160,7 +172,7 @@ TEST(ReorderingBuffer, CircularBufferWrapping) {
 
     // Should deliver in sequence
     for (int i = 0; i < 3; ++i) {
-        auto result = buffer.get_next();
+        auto result = next(buffer);
         EXPECT_TRUE(result.has_value());
     }
 }
@@ -172,7 +184,7 @@ TEST(ReorderingBuffer, LargeGapThenFill) {
 
     // Add packet at sequence 0
     EXPECT_TRUE(buffer.add(0, data));
-    auto result = buffer.get_next();
+    auto result = next(buffer);
     EXPECT_TRUE(result.has_value());
 
     // Add packet far ahead
@@ -187,7 +199,7 @@ TEST(ReorderingBuffer, LargeGapThenFill) {
     // Should now be able to consume all
     for (int i = 0; i < 7; ++i) {
         EXPECT_TRUE(buffer.has_ready());
-        result = buffer.get_next();
+        result = next(buffer);
         EXPECT_TRUE(result.has_value());
     }
 }
@@ -204,11 +216,293 @@ TEST(ReorderingBuffer, BufferFullWithGaps) {
     EXPECT_FALSE(buffer.add(6, data));
 
     // Should only be able to get first packet
-    auto result = buffer.get_next();
+    auto result = next(buffer);
     EXPECT_TRUE(result.has_value());
     EXPECT_FALSE(buffer.has_ready()); // Gap at sequence 1
 
     // Adding sequence 1 should not cause issues
     EXPECT_TRUE(buffer.add(1, data));
     EXPECT_TRUE(buffer.has_ready());
-}
\ No newline at end of file
+}
+TEST(ReorderingBuffer, DeliversFromSlotsWithoutCopying) {
+    hsnet::ReorderingBuffer buffer(4, 64, 2);
+    EXPECT_EQ(buffer.free_slots(), 6u);
+
+    // Frames land in their slots with a header in front of the payload
+    const uint8_t frame1[] = {0xAA, 0xAA, 4, 5, 6};
+    const uint8_t frame0[] = {0xAA, 0xAA, 1, 2, 3};
+    auto s1 = buffer.acquire();
+    auto s0 = buffer.acquire();
+    std::memcpy(buffer.slot_data(s1), frame1, sizeof(frame1));
+    std::memcpy(buffer.slot_data(s0), frame0, sizeof(frame0));
+    EXPECT_TRUE(buffer.add(1, s1, 2, 3, 7));
+    EXPECT_FALSE(buffer.has_ready());
+    EXPECT_TRUE(buffer.add(0, s0, 2, 3, 7));
+    EXPECT_EQ(buffer.free_slots(), 4u);
+
+    // A duplicate gives its slot straight back
+    auto dup = buffer.acquire();
+    EXPECT_FALSE(buffer.add(1, dup, 2, 3, 7));
+    EXPECT_EQ(buffer.free_slots(), 4u);
+
+    std::vector<uint64_t> seqs;
+    while (buffer.deliver_next(42, [&](const hsnet::MessageView& v) {
+        EXPECT_EQ(v.data, buffer.slot_data(v.sequenceNumber == 0 ? s0 : s1) + 2);
+        EXPECT_EQ(v.length, 3);
+        EXPECT_EQ(v.streamId, 7u);
+        EXPECT_EQ(v.receiveTimeNs, 42u);
+        seqs.push_back(v.sequenceNumber);
+    })) {
+    }
+    EXPECT_EQ(seqs, (std::vector<uint64_t>{0, 1}));
+    // Slots are released once the handler returns
+    EXPECT_EQ(buffer.free_slots(), 6u);
+}
+
+TEST(ReorderingBuffer, RoundsToPowerOfTwoAndScansGaps) {
+    hsnet::ReorderingBuffer buffer(100);
+    EXPECT_EQ(buffer.max_size(), 128u);
+
+    std::vector<uint8_t> data = {1};
+    for (uint64_t seq : {0, 1, 2, 5, 6, 60, 130}) buffer.add(seq, data);
+
+    EXPECT_EQ(buffer.ready_count(), 3u);
+    EXPECT_EQ(buffer.first_gap(), 3u);
+    EXPECT_EQ(buffer.next_received(3), 5u);
+    EXPECT_EQ(buffer.next_received(7), 60u);
+    EXPECT_EQ(buffer.next_received(61), 128u);  // Window end; 130 didn't fit
+
+    // Cumulative ack is the first gap; bit i of the SACK is first_gap + 1 + i
+    const hsnet::ctrl::Ack ack = buffer.ack();
+    EXPECT_EQ(ack.cumulative_ack, 3u);
+    EXPECT_EQ(ack.sack_bitmap, (1ull << 1) | (1ull << 2) | (1ull << 56));
+
+    EXPECT_EQ(buffer.overruns(), 1u);
+}
+
+TEST(ReorderingBuffer, CoalescesMissingRangesForNaks) {
+    hsnet::ReorderingBuffer buffer(256);
+    std::vector<uint8_t> data = {1};
+    for (uint64_t seq : {0, 1, 4, 5, 6, 70, 200}) buffer.add(seq, data);
+
+    hsnet::ctrl::NakRange ranges[4];
+    ASSERT_EQ(buffer.missing_ranges(ranges), 3u);
+    EXPECT_EQ(ranges[0].start_seq, 2u);
+    EXPECT_EQ(ranges[0].end_seq, 4u);
+    EXPECT_EQ(ranges[1].start_seq, 7u);
+    EXPECT_EQ(ranges[1].end_seq, 70u);
+    EXPECT_EQ(ranges[2].start_seq, 71u);
+    EXPECT_EQ(ranges[2].end_seq, 200u);
+
+    // Oldest first when there are more gaps than room
+    EXPECT_EQ(buffer.missing_ranges(std::span(ranges, 1)), 1u);
+    EXPECT_EQ(ranges[0].start_seq, 2u);
+
+    buffer.add(2, data);
+    buffer.add(3, data);
+    ASSERT_EQ(buffer.missing_ranges(ranges), 2u);
+    EXPECT_EQ(ranges[0].start_seq, 7u);
+
+    // Nothing is missing while everything buffered is in sequence, unless the
+    // sender says it has sent more
+    buffer.clear();
+    buffer.add(0, data);
+    EXPECT_EQ(buffer.missing_ranges(ranges), 0u);
+    ASSERT_EQ(buffer.missing_ranges(ranges, 5), 1u);
+    EXPECT_EQ(ranges[0].start_seq, 1u);
+    EXPECT_EQ(ranges[0].end_seq, 5u);
+
+    // A reset starts over at a later sequence
+    buffer.clear(1000);
+    EXPECT_EQ(buffer.next_expected(), 1000u);
+    EXPECT_EQ(buffer.size(), 0u);
+    EXPECT_TRUE(buffer.add(1000, data));
+    EXPECT_EQ(next(buffer), data);
+}
+
+TEST(ReorderingBuffer, GrowsUpToCapKeepingPackets) {
+    hsnet::ReorderingBuffer buffer(4, 16, 0, 64);
+    const size_t slots = buffer.free_slots();
+
+    std::vector<uint8_t> a = {1};
+    std::vector<uint8_t> b = {2};
+    std::vector<uint8_t> c = {3};
+    EXPECT_TRUE(buffer.add(1, b));
+    // Frames keep arriving past the window before it moves: each eighth
+    // overrun doubles it, until sequence 20 fits in 32
+    uint64_t dropped = 0;
+    while (!buffer.add(20, c)) ++dropped;
+    EXPECT_EQ(dropped, 3 * 8 - 1);
+    EXPECT_EQ(buffer.overruns(), dropped);
+    EXPECT_EQ(buffer.max_size(), 32u);
+    EXPECT_EQ(buffer.free_slots(), slots + 28 - 2);
+    for (int i = 0; i < 8; ++i) EXPECT_FALSE(buffer.add(64, c));  // Beyond the cap, however often
+    EXPECT_EQ(buffer.max_size(), 32u);
+
+    EXPECT_TRUE(buffer.add(0, a));
+    EXPECT_EQ(next(buffer), a);
+    EXPECT_EQ(next(buffer), b);
+    EXPECT_FALSE(buffer.has_ready());
+    for (uint64_t seq = 2; seq < 20; ++seq) EXPECT_TRUE(buffer.add(seq, a));
+    EXPECT_EQ(buffer.ready_count(), 19u);
+}
+
+TEST(ReorderingBuffer, StrayFramesDoNotGrowTheWindow) {
+    hsnet::ReorderingBuffer buffer(4, 16, 0, 1024);
+    const size_t slots = buffer.free_slots();
+    std::vector<uint8_t> data = {1};
+
+    // One far-ahead frame per window's worth of delivery: dropped, no growth
+    for (uint64_t base = 0; base < 64; base += 4) {
+        EXPECT_FALSE(buffer.add(base + 500, data));
+        for (uint64_t seq = base; seq < base + 4; ++seq) {
+            EXPECT_TRUE(buffer.add(seq, data));
+            EXPECT_EQ(next(buffer), data);
+        }
+    }
+    EXPECT_EQ(buffer.max_size(), 4u);
+    EXPECT_EQ(buffer.free_slots(), slots);
+    EXPECT_EQ(buffer.overruns(), 16u);
+}
+
+TEST(ReorderingBuffer, ReassemblesFragmentsOnceComplete) {
+    hsnet::ReorderingBuffer buffer(8, 16, 0, 0, 64);
+
+    using Fragment = hsnet::ReorderingBuffer::Fragment;
+    std::vector<uint8_t> f0 = {1, 2, 3, 4};
+    std::vector<uint8_t> f1 = {5, 6, 7, 8};
+    std::vector<uint8_t> f2 = {9};
+    EXPECT_TRUE(buffer.add(2, f2, 0, Fragment{2, 3, true}));
+    EXPECT_TRUE(buffer.add(0, f0, 0, Fragment{0, 3, true}));
+    EXPECT_FALSE(buffer.has_ready());  // Fragment 1 still missing
+    EXPECT_TRUE(buffer.add(1, f1, 0, Fragment{1, 3, true}));
+    EXPECT_TRUE(buffer.add(3, f2, 0, Fragment{0, 1, false}));
+
+    std::vector<std::vector<uint8_t>> messages;
+    std::vector<bool> ends;
+    while (buffer.deliver_next(0, [&](const hsnet::MessageView& v) {
+        messages.emplace_back(v.data, v.data + v.length);
+        ends.push_back(v.endOfMessage);
+    })) {
+    }
+    ASSERT_EQ(messages.size(), 2u);
+    EXPECT_EQ(messages[0], (std::vector<uint8_t>{1, 2, 3, 4, 5, 6, 7, 8, 9}));
+    EXPECT_EQ(messages[1], f2);
+    EXPECT_EQ(ends, (std::vector<bool>{true, false}));
+    EXPECT_EQ(buffer.next_expected(), 4u);
+    EXPECT_EQ(buffer.size(), 0u);
+}
+
+TEST(ReorderingBuffer, StreamsMessagesTooLargeToReassemble) {
+    hsnet::ReorderingBuffer buffer(8, 16, 0, 0, 6);
+
+    // Three fragments of 4: over the limit even if the last one were empty
+    using Fragment = hsnet::ReorderingBuffer::Fragment;
+    std::vector<uint8_t> part = {1, 2, 3, 4};
+    EXPECT_TRUE(buffer.add(0, part, 0, Fragment{0, 3, true}));
+    EXPECT_TRUE(buffer.has_ready());  // Delivered as it comes
+
+    std::vector<bool> ends;
+    auto handler = [&](const hsnet::MessageView& v) {
+        EXPECT_EQ(v.length, 4u);
+        ends.push_back(v.endOfMessage);
+    };
+    EXPECT_TRUE(buffer.deliver_next(0, handler));
+    EXPECT_TRUE(buffer.add(1, part, 0, Fragment{1, 3, true}));
+    EXPECT_TRUE(buffer.deliver_next(0, handler));
+    EXPECT_TRUE(buffer.add(2, part, 0, Fragment{2, 3, true}));
+    EXPECT_TRUE(buffer.deliver_next(0, handler));
+    EXPECT_EQ(ends, (std::vector<bool>{false, false, true}));
+}
+
+TEST(ReorderingBuffer, ReassemblesAMessageOfExactlyTheLimit) {
+    hsnet::ReorderingBuffer buffer(8, 16, 0, 0, 6);
+
+    // Full fragments overestimate it (2 x 4 > 6) but the short last one fits
+    using Fragment = hsnet::ReorderingBuffer::Fragment;
+    EXPECT_TRUE(buffer.add(0, std::vector<uint8_t>{1, 2, 3, 4}, 0, Fragment{0, 2, true}));
+    EXPECT_FALSE(buffer.has_ready());
+    EXPECT_TRUE(buffer.add(1, std::vector<uint8_t>{5, 6}, 0, Fragment{1, 2, true}));
+    std::vector<uint8_t> message;
+    EXPECT_TRUE(buffer.deliver_next(0, [&](const hsnet::MessageView& v) {
+        message.assign(v.data, v.data + v.length);
+        EXPECT_TRUE(v.endOfMessage);
+    }));
+    EXPECT_EQ(message, (std::vector<uint8_t>{1, 2, 3, 4, 5, 6}));
+    EXPECT_EQ(buffer.size(), 0u);
+}
+
+TEST(ReorderingBuffer, UnpacksBatchedFramesAcrossPeeks) {
+    hsnet::ReorderingBuffer buffer(8, 256);
+
+    // Three messages packed into sequence 0, one plain frame after it
+    uint8_t packed[64];
+    size_t len = 0;
+    for (uint8_t v = 1; v <= 3; ++v) {
+        const std::vector<uint8_t> msg(v, v);
+        len = hsnet::proto::append_batched(packed, len, msg.data(), msg.size());
+    }
+    const std::vector<uint8_t> plain = {9, 9};
+    ASSERT_TRUE(buffer.add(0, std::span<const uint8_t>(packed, len), 4, {}, true));
+    ASSERT_TRUE(buffer.add(1, plain, 4));
+
+    // Two views: the third message stays in the slot for the next peek
+    hsnet::MessageView views[2];
+    ASSERT_EQ(buffer.peek_ready(views, 0), 2u);
+    EXPECT_EQ(std::vector<uint8_t>(views[0].data, views[0].data + views[0].length), (std::vector<uint8_t>{1}));
+    EXPECT_EQ(std::vector<uint8_t>(views[1].data, views[1].data + views[1].length), (std::vector<uint8_t>{2, 2}));
+    EXPECT_EQ(views[1].sequenceNumber, 0u);
+    EXPECT_EQ(views[1].streamId, 4u);
+    buffer.consume();
+    EXPECT_EQ(buffer.next_expected(), 0u);
+
+    ASSERT_EQ(buffer.peek_ready(views, 0), 2u);
+    EXPECT_EQ(std::vector<uint8_t>(views[0].data, views[0].data + views[0].length), (std::vector<uint8_t>{3, 3, 3}));
+    EXPECT_EQ(std::vector<uint8_t>(views[1].data, views[1].data + views[1].length), plain);
+    buffer.consume();
+    EXPECT_EQ(buffer.next_expected(), 2u);
+    EXPECT_EQ(buffer.size(), 0u);
+    EXPECT_FALSE(next(buffer).has_value());
+}
+
+TEST(ReorderingBuffer, EmptyBatchedFrameBeforeAFragmentedMessage) {
+    hsnet::ReorderingBuffer buffer(8, 16, 0, 0, 64);
+
+    // Nothing to unpack at sequence 0, then a two-fragment message
+    using Fragment = hsnet::ReorderingBuffer::Fragment;
+    ASSERT_TRUE(buffer.add(0, std::span<const uint8_t>(), 0, {}, true));
+    ASSERT_TRUE(buffer.add(1, std::vector<uint8_t>{1, 2}, 0, Fragment{0, 2, true}));
+    ASSERT_TRUE(buffer.add(2, std::vector<uint8_t>{3}, 0, Fragment{1, 2, true}));
+
+    hsnet::MessageView views[4];
+    ASSERT_EQ(buffer.peek_ready(views, 0), 1u);
+    EXPECT_EQ(std::vector<uint8_t>(views[0].data, views[0].data + views[0].length), (std::vector<uint8_t>{1, 2, 3}));
+    EXPECT_EQ(views[0].sequenceNumber, 1u);
+    EXPECT_TRUE(views[0].endOfMessage);
+    buffer.consume();
+    EXPECT_EQ(buffer.next_expected(), 3u);
+    EXPECT_EQ(buffer.size(), 0u);
+}
+
+TEST(ReorderingBuffer, ViewsCarryFrameTimes) {
+    hsnet::ReorderingBuffer buffer(8, 16, 0, 0, 64);
+
+    using Fragment = hsnet::ReorderingBuffer::Fragment;
+    const std::vector<uint8_t> f0 = {1, 2};
+    const std::vector<uint8_t> f1 = {3};
+    uint8_t packed[16];
+    size_t len = hsnet::proto::append_batched(packed, 0, f0.data(), f0.size());
+    len = hsnet::proto::append_batched(packed, len, f1.data(), f1.size());
+    // Fragments sent at 100 and 110, the second received last
+    ASSERT_TRUE(buffer.add(1, f1, 0, Fragment{1, 2, true}, false, {110, 250}));
+    ASSERT_TRUE(buffer.add(0, f0, 0, Fragment{0, 2, true}, false, {100, 200}));
+    ASSERT_TRUE(buffer.add(2, std::span<const uint8_t>(packed, len), 0, {}, true, {300, 400}));
+    ASSERT_TRUE(buffer.add(3, f1, 0));  // No receive time: the poll's stands in
+
+    std::vector<std::pair<uint64_t, uint64_t>> times;
+    while (buffer.deliver_next(999, [&](const hsnet::MessageView& v) {
+        times.emplace_back(v.sendTimeNs, v.receiveTimeNs);
+    })) {
+    }
+    EXPECT_EQ(times, (std::vector<std::pair<uint64_t, uint64_t>>{{100, 250}, {300, 400}, {300, 400}, {0, 999}}));
+}
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+
+#include "net/ShmTransport.h"
+#include "net/Transport.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+// A log name of its own per test, removed afterwards
+class ShmLog {
+   public:
+    ShmLog(const std::string& test, hsnet::StreamId stream, uint32_t size = 1u << 16)
+        : name_("hsnet-test-" + test + "-" + std::to_string(getpid())),
+          path_(cfg_.directory + "/" + name_ + "-" + std::to_string(stream)) {
+        cfg_.name = name_;
+        cfg_.logBufferSize = size;
+        unlink(path_.c_str());
+    }
+    ~ShmLog() { unlink(path_.c_str()); }
+
+    const hsnet::ShmConfig& cfg() const { return cfg_; }
+
+   private:
+    hsnet::ShmConfig cfg_;
+    std::string name_;
+    std::string path_;
+};
+
+std::span<const uint8_t> bytes(const uint32_t& v) { return {reinterpret_cast<const uint8_t*>(&v), sizeof(v)}; }
+}  // namespace
+
+TEST(ShmTransport, EverySubscriberReceivesInOrder) {
+    ShmLog log("order", 3);
+    auto transport = hsnet::make_shm_transport(log.cfg());
+    auto sub1 = transport->create_subscription("", 3);
+    auto sub2 = transport->create_subscription("", 3);
+    EXPECT_FALSE(sub1->isConnected());
+    auto pub = transport->create_publication("", 3);
+    EXPECT_TRUE(sub1->isConnected());
+    EXPECT_FALSE(sub1->hasData());
+
+    for (uint32_t i = 0; i < 3; ++i) ASSERT_EQ(pub->offer(bytes(i), 3), hsnet::PublishResult::OK);
+    EXPECT_EQ(pub->offer(bytes(9), 4), hsnet::PublishResult::ERROR);
+
+    auto collect = [](std::vector<uint32_t>& out) {
+        return [&out](const hsnet::MessageView& mv) {
+            EXPECT_EQ(mv.streamId, 3u);
+            EXPECT_EQ(mv.sequenceNumber, out.size());
+            EXPECT_TRUE(mv.endOfMessage);
+            ASSERT_EQ(mv.length, sizeof(uint32_t));
+            uint32_t v;
+            std::memcpy(&v, mv.data, sizeof(v));
+            out.push_back(v);
+        };
+    };
+    std::vector<uint32_t> first;
+    std::vector<uint32_t> second;
+    EXPECT_TRUE(sub1->hasData());
+    EXPECT_EQ(sub1->poll(collect(first), 16), 3);
+
+    // Encoded in place, visible once committed
+    std::span<uint8_t> claim = pub->tryClaim(8);
+    ASSERT_EQ(claim.size(), 8u);
+    EXPECT_TRUE(pub->tryClaim(8).empty());
+    const uint32_t three = 3;
+    std::memcpy(claim.data(), &three, sizeof(three));
+    EXPECT_FALSE(sub1->hasData());
+    ASSERT_EQ(pub->commit(sizeof(three), 3), hsnet::PublishResult::OK);
+
+    EXPECT_EQ(sub1->poll(collect(first), 16), 1);
+    EXPECT_EQ(sub2->poll(collect(second), 16), 4);
+    EXPECT_EQ(first, (std::vector<uint32_t>{0, 1, 2, 3}));
+    EXPECT_EQ(second, first);
+    EXPECT_FALSE(sub2->hasData());
+    EXPECT_EQ(sub2->stats().messagesDelivered, 4u);
+    EXPECT_EQ(pub->stats().framesSent, 4u);
+
+    // One writer per stream
+    EXPECT_THROW(transport->create_publication("", 3), std::runtime_error);
+}
+
+TEST(ShmTransport, SlowestSubscriberBackpressuresAcrossWraparound) {
+    ShmLog log("wrap", 1, 4096);
+    auto transport = hsnet::make_shm_transport(log.cfg());
+    auto fast = transport->create_subscription("", 1);
+    auto slow = transport->create_subscription("", 1);
+    auto pub = transport->create_publication("", 1);
+
+    // Records of 16 + 40 bytes, padded to 64: the slow reader holds 64 of them
+    std::vector<uint8_t> msg(40);
+    uint32_t offered = 0;
+    for (;;) {
+        std::memcpy(msg.data(), &offered, sizeof(offered));
+        if (pub->offer(msg, 1) != hsnet::PublishResult::OK) break;
+        ++offered;
+    }
+    EXPECT_EQ(offered, 64u);
+    EXPECT_LT(pub->availableWindow(), msg.size());
+
+    // Drain both, many times around the ring, with varying lengths
+    uint32_t next_fast = 0;
+    uint32_t next_slow = 0;
+    auto check = [](uint32_t& next) {
+        return [&next](const hsnet::MessageView& mv) {
+            uint32_t v;
+            std::memcpy(&v, mv.data, sizeof(v));
+            EXPECT_EQ(v, next);
+            EXPECT_EQ(mv.sequenceNumber, next);
+            ++next;
+        };
+    };
+    const uint32_t total = 5000;
+    while (next_slow < total) {
+        while (offered < total) {
+            std::vector<uint8_t> m(4 + offered % 200);
+            std::memcpy(m.data(), &offered, sizeof(offered));
+            if (pub->offer(m, 1) != hsnet::PublishResult::OK) break;
+            ++offered;
+        }
+        fast->poll(check(next_fast), 1000);
+        slow->poll(check(next_slow), 7);
+    }
+    EXPECT_EQ(next_fast, total);
+    EXPECT_EQ(next_slow, total);
+
+    // Messages over a quarter of the ring are rejected
+    EXPECT_EQ(pub->offer(std::vector<uint8_t>(1024), 1), hsnet::PublishResult::ERROR);
+}
+
+TEST(ShmTransport, CrossesProcesses) {
+    ShmLog log("fork", 5);
+    auto transport = hsnet::make_shm_transport(log.cfg());
+    auto sub = transport->create_subscription("", 5);
+
+    constexpr uint32_t total = 10000;
+    const pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        auto pub = hsnet::make_shm_transport(log.cfg())->create_publication("", 5);
+        for (uint32_t i = 0; i < total;) {
+            if (pub->offer(bytes(i), 5) == hsnet::PublishResult::OK) ++i;
+        }
+        _exit(0);  // Like a crash: the publication never clears its pid
+    }
+
+    std::vector<uint32_t> received;
+    const auto start = std::chrono::steady_clock::now();
+    while (received.size() < total && std::chrono::steady_clock::now() - start < 10s) {
+        sub->poll([&](const hsnet::MessageView& mv) {
+            uint32_t v;
+            std::memcpy(&v, mv.data, sizeof(v));
+            received.push_back(v);
+        }, 256);
+    }
+    // Until it is reaped the child counts as alive
+    EXPECT_TRUE(sub->isConnected());
+    int status = 0;
+    waitpid(child, &status, 0);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    ASSERT_EQ(received.size(), total);
+    for (uint32_t i = 0; i < total; ++i) ASSERT_EQ(received[i], i);
+    EXPECT_FALSE(sub->isConnected());
+}
@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "TscClock.h"
+
+TEST(TscClock, TicksAreMonotonic) {
+    uint64_t prev = TscClock::now();
+    for (int i = 0; i < 100000; ++i) {
+        uint64_t t = TscClock::now();
+        ASSERT_GE(t, prev);
+        prev = t;
+    }
+}
+
+TEST(TscClock, ConvertsToMonotonicAndRealtime) {
+    const uint64_t ticks = TscClock::now();
+    const uint64_t mono = TscClock::monotonicNs();
+    const uint64_t wall = TscClock::wallNs();
+
+    // Both conversions should land within a millisecond of the kernel clocks
+    EXPECT_NEAR(static_cast<double>(TscClock::toNs(ticks)), static_cast<double>(mono), 1e6);
+    EXPECT_NEAR(static_cast<double>(TscClock::toRealtimeNs(ticks)), static_cast<double>(wall), 1e6);
+    EXPECT_GT(TscClock::frequencyHz(), 1e6);
+}
+
+TEST(TscClock, ElapsedMatchesSleep) {
+    const uint64_t start = TscClock::now();
+    const uint64_t mono_start = TscClock::monotonicNs();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const uint64_t elapsed = TscClock::elapsedNs(start);
+    const uint64_t mono_elapsed = TscClock::monotonicNs() - mono_start;
+
+    EXPECT_GE(elapsed, 20'000'000u);
+    EXPECT_NEAR(static_cast<double>(elapsed), static_cast<double>(mono_elapsed), 0.02 * mono_elapsed + 100'000);
+}
+
+TEST(TscClock, RecalibrationKeepsTimeContinuous) {
+    const uint64_t ticks = TscClock::now();
+    const uint64_t before = TscClock::toNs(ticks);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    TscClock::recalibrate();
+    const uint64_t after = TscClock::toNs(ticks);
+
+    // Same tick value before and after a rebase: only calibration error apart
+    EXPECT_NEAR(static_cast<double>(after), static_cast<double>(before), 50'000);
+}
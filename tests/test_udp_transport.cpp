@@ -2,10 +2,22 @@
 
 #include "net/UdpReliable.h"
 #include "net/Transport.h"
+#include "net/Protocol.h"
+#include "net/IoUring.h"
+#include "net/LatencyHistogram.h"
+#include "TscClock.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 #include <atomic>
 #include <chrono>
+#include <cstring>
+#include <string>
 #include <thread>
+#include <vector>
 
 using namespace std::chrono_literals;
 
@@ -50,4 +62,842 @@ TEST(UdpReliable, BasicMulticast) {
         }, 32);
     }
 
-}
\ No newline at end of file
+}
+
+TEST(UdpReliable, CrcRejectsCorruptFramesBeforeReordering) {
+    using namespace std::chrono;
+    hsnet::FeedPublisherConfig pubCfg;
+    pubCfg.multicast_group = "239.1.1.1";
+    pubCfg.port = 8170;
+    pubCfg.enable_crc32_c = true;
+    hsnet::FeedSubscriberConfig subCfg;
+    subCfg.multicast_group = "239.1.1.1";
+    subCfg.port = 8170;
+    subCfg.enable_crc32_c = true;
+
+    auto sub = hsnet::make_udp_reliable_subscriber(subCfg);
+    auto pub = hsnet::make_udp_reliable_publisher(pubCfg);
+
+    // A CRC-stamped frame for sequence 0 with one payload bit flipped in flight.
+    // If it got past verification it would take the slot of the real message.
+    const char bad[] = "SELL MSFT 9";
+    uint8_t frame[sizeof(hsnet::proto::Header) + sizeof(bad)];
+    hsnet::proto::Header h{};
+    h.payload_length = sizeof(bad);
+    h.stream_id = pubCfg.stream_id;
+    hsnet::proto::set_type_flags(h, hsnet::proto::FrameType::DATA, hsnet::proto::FLAG_CRC32C);
+    size_t len = hsnet::proto::write_frame(frame, h, reinterpret_cast<const uint8_t*>(bad), sizeof(bad));
+    frame[len - 2] ^= 0x40;
+
+    int raw = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(raw, 0);
+    sockaddr_in dest{};
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(subCfg.port);
+    inet_pton(AF_INET, subCfg.multicast_group.c_str(), &dest.sin_addr);
+    ASSERT_EQ(sendto(raw, frame, len, 0, reinterpret_cast<sockaddr*>(&dest), sizeof(dest)), static_cast<ssize_t>(len));
+    close(raw);
+
+    const char good[] = "BUY PLTR 8";
+    ASSERT_EQ(pub->offer(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(good), sizeof(good)), pubCfg.stream_id),
+              hsnet::PublishResult::OK);
+
+    std::string received;
+    auto start = steady_clock::now();
+    while ((received.empty() || sub->stats().crcFailures == 0) && steady_clock::now() - start < 5s) {
+        sub->poll([&](const hsnet::MessageView& mv) {
+            received.assign(reinterpret_cast<const char*>(mv.data), mv.length);
+        }, 8);
+    }
+
+    EXPECT_EQ(received, std::string(good, sizeof(good)));
+    const hsnet::SubscriptionStats stats = sub->stats();
+    EXPECT_EQ(stats.crcFailures, 1u);
+    EXPECT_EQ(stats.messagesDelivered, 1u);
+    EXPECT_GE(stats.framesReceived, 2u);
+}
+
+TEST(UdpReliable, ClaimCommitEncodesInPlace) {
+    using namespace std::chrono;
+    hsnet::FeedPublisherConfig pubCfg;
+    pubCfg.enable_crc32_c = true;
+    hsnet::FeedSubscriberConfig subCfg;
+    subCfg.enable_crc32_c = true;
+
+    auto sub = hsnet::make_udp_reliable_subscriber(subCfg);
+    auto pub = hsnet::make_udp_reliable_publisher(pubCfg);
+
+    // Claims are bounded by one MTU-sized frame and can't be nested
+    EXPECT_TRUE(pub->tryClaim(pubCfg.mtu).empty());
+
+    const char msg[] = "BUY NVDA 3";
+    std::span<uint8_t> buf = pub->tryClaim(64);
+    ASSERT_EQ(buf.size(), 64u);
+    EXPECT_TRUE(pub->tryClaim(8).empty());
+    std::memcpy(buf.data(), msg, sizeof(msg));
+    ASSERT_EQ(pub->commit(sizeof(msg), pubCfg.stream_id), hsnet::PublishResult::OK);
+    EXPECT_EQ(pub->commit(sizeof(msg), pubCfg.stream_id), hsnet::PublishResult::ERROR);
+
+    // An aborted claim sends nothing and doesn't consume a sequence number
+    ASSERT_FALSE(pub->tryClaim(16).empty());
+    pub->abort();
+
+    const char next[] = "SELL NVDA 1";
+    ASSERT_EQ(pub->offer(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(next), sizeof(next)), pubCfg.stream_id),
+              hsnet::PublishResult::OK);
+
+    std::vector<std::string> received;
+    auto start = steady_clock::now();
+    while (received.size() < 2 && steady_clock::now() - start < 5s) {
+        sub->poll([&](const hsnet::MessageView& mv) {
+            received.emplace_back(reinterpret_cast<const char*>(mv.data), mv.length);
+        }, 8);
+    }
+
+    ASSERT_EQ(received.size(), 2u);
+    EXPECT_EQ(received[0], std::string(msg, sizeof(msg)));
+    EXPECT_EQ(received[1], std::string(next, sizeof(next)));
+    EXPECT_EQ(sub->stats().crcFailures, 0u);
+}
+
+TEST(UdpReliable, BatchesSendsAndReceives) {
+    using namespace std::chrono;
+    hsnet::FeedPublisherConfig pubCfg;
+    pubCfg.sendBatchSize = 4;  // No latency bound: only a full batch or flush() sends
+    hsnet::FeedSubscriberConfig subCfg;
+
+    auto sub = hsnet::make_udp_reliable_subscriber(subCfg);
+    auto pub = hsnet::make_udp_reliable_publisher(pubCfg);
+
+    std::vector<std::string> received;
+    auto handler = [&](const hsnet::MessageView& mv) {
+        received.emplace_back(reinterpret_cast<const char*>(mv.data), mv.length);
+    };
+    auto offer = [&](const std::string& msg) {
+        return pub->offer(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(msg.data()), msg.size()),
+                          pubCfg.stream_id);
+    };
+
+    // Held back until the batch is full
+    for (int i = 0; i < 3; ++i) ASSERT_EQ(offer("MSG " + std::to_string(i)), hsnet::PublishResult::OK);
+    std::this_thread::sleep_for(20ms);
+    EXPECT_EQ(sub->poll(handler, 16), 0);
+
+    ASSERT_EQ(offer("MSG 3"), hsnet::PublishResult::OK);
+    ASSERT_EQ(offer("MSG 4"), hsnet::PublishResult::OK);
+    EXPECT_EQ(pub->flush(), 1);
+    EXPECT_EQ(pub->flush(), 0);
+
+    // A small maxMessages leaves the rest of a received batch buffered
+    auto start = steady_clock::now();
+    while (received.size() < 5 && steady_clock::now() - start < 5s) sub->poll(handler, 2);
+
+    ASSERT_EQ(received.size(), 5u);
+    for (size_t i = 0; i < received.size(); ++i) EXPECT_EQ(received[i], "MSG " + std::to_string(i));
+    const hsnet::SubscriptionStats stats = sub->stats();
+    EXPECT_EQ(stats.framesReceived, 5u);
+    EXPECT_LT(stats.receiveBatches, stats.framesReceived);
+}
+
+TEST(UdpReliable, GsoBurstSplitsBackIntoFrames) {
+    using namespace std::chrono;
+    hsnet::FeedPublisherConfig pubCfg;
+    pubCfg.enable_gso = true;
+    pubCfg.enable_crc32_c = true;
+    pubCfg.sendBatchSize = 16;
+    pubCfg.sendBatchLatencyNs = 10'000'000'000ull;
+    hsnet::FeedSubscriberConfig subCfg;
+    subCfg.enable_gro = true;
+    subCfg.enable_crc32_c = true;
+
+    auto sub = hsnet::make_udp_reliable_subscriber(subCfg);
+    auto pub = hsnet::make_udp_reliable_publisher(pubCfg);
+
+    // Equal-length runs (GSO segments) broken up by frames of other sizes
+    std::vector<std::string> sent;
+    for (int i = 0; i < 10; ++i) sent.push_back("QUOTE " + std::to_string(i));
+    sent.push_back("TRADE 1");
+    sent.push_back("QUOTE 10 LONGER");
+    for (int i = 11; i < 14; ++i) sent.push_back("QUOTE " + std::to_string(i));
+    for (const std::string& msg : sent) {
+        ASSERT_EQ(pub->offer(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(msg.data()), msg.size()),
+                             pubCfg.stream_id),
+                  hsnet::PublishResult::OK);
+    }
+    EXPECT_EQ(pub->flush(), static_cast<int>(sent.size()));
+
+    std::vector<std::string> received;
+    auto start = steady_clock::now();
+    while (received.size() < sent.size() && steady_clock::now() - start < 5s) {
+        sub->poll([&](const hsnet::MessageView& mv) {
+            received.emplace_back(reinterpret_cast<const char*>(mv.data), mv.length);
+        }, 64);
+    }
+
+    EXPECT_EQ(received, sent);
+    const hsnet::SubscriptionStats stats = sub->stats();
+    EXPECT_EQ(stats.framesReceived, sent.size());
+    EXPECT_EQ(stats.malformedFrames, 0u);
+    EXPECT_EQ(stats.crcFailures, 0u);
+}
+
+TEST(UdpReliable, PollBatchHandsOverBursts) {
+    using namespace std::chrono;
+    hsnet::FeedPublisherConfig pubCfg;
+    pubCfg.sendBatchSize = 8;
+    pubCfg.sendBatchLatencyNs = 10'000'000'000ull;
+    hsnet::FeedSubscriberConfig subCfg;
+
+    auto sub = hsnet::make_udp_reliable_subscriber(subCfg);
+    auto pub = hsnet::make_udp_reliable_publisher(pubCfg);
+
+    for (uint8_t i = 0; i < 8; ++i) {
+        const uint8_t msg[] = {i, i, i};
+        ASSERT_EQ(pub->offer(msg, pubCfg.stream_id), hsnet::PublishResult::OK);
+    }
+
+    // Concrete type: the handler is a template argument
+    std::vector<size_t> bursts;
+    std::vector<uint64_t> seqs;
+    auto start = steady_clock::now();
+    while (seqs.size() < 6 && steady_clock::now() - start < 5s) {
+        sub->pollBatch([&](std::span<const hsnet::MessageView> views) {
+            bursts.push_back(views.size());
+            for (const hsnet::MessageView& v : views) {
+                EXPECT_EQ(v.length, 3);
+                EXPECT_EQ(v.data[0], v.sequenceNumber);
+                seqs.push_back(v.sequenceNumber);
+            }
+        }, 6 - static_cast<int>(seqs.size()));
+    }
+    EXPECT_LT(bursts.size(), seqs.size());
+
+    // Interface: the same path through one FunctionRef call
+    hsnet::ISubscription& base = *sub;
+    start = steady_clock::now();
+    while (seqs.size() < 8 && steady_clock::now() - start < 5s) {
+        base.pollBatch([&](std::span<const hsnet::MessageView> views) {
+            for (const hsnet::MessageView& v : views) seqs.push_back(v.sequenceNumber);
+        }, 16);
+    }
+    EXPECT_EQ(seqs, (std::vector<uint64_t>{0, 1, 2, 3, 4, 5, 6, 7}));
+    EXPECT_EQ(sub->stats().messagesDelivered, 8u);
+}
+
+TEST(UdpReliable, FragmentsLargeMessagesAndReassembles) {
+    using namespace std::chrono;
+    hsnet::FeedPublisherConfig pubCfg;
+    pubCfg.enable_crc32_c = true;
+    hsnet::FeedSubscriberConfig subCfg;
+    subCfg.enable_crc32_c = true;
+
+    auto sub = hsnet::make_udp_reliable_subscriber(subCfg);
+    auto pub = hsnet::make_udp_reliable_publisher(pubCfg);
+
+    // A book snapshot several MTUs long, then a small message behind it
+    std::vector<uint8_t> snapshot(10000);
+    for (size_t i = 0; i < snapshot.size(); ++i) snapshot[i] = static_cast<uint8_t>(i * 7);
+    ASSERT_EQ(pub->offer(snapshot, pubCfg.stream_id), hsnet::PublishResult::OK);
+    const uint8_t tail[] = {42};
+    ASSERT_EQ(pub->offer(tail, pubCfg.stream_id), hsnet::PublishResult::OK);
+
+    // Up to maxMessageSize by default, over it is refused
+    std::vector<uint8_t> huge(pubCfg.maxMessageSize + 1);
+    EXPECT_EQ(pub->offer(huge, pubCfg.stream_id), hsnet::PublishResult::ERROR);
+
+    // A limit the ring can't hold is refused up front
+    hsnet::FeedPublisherConfig tight = pubCfg;
+    tight.txRingSize = 16;
+    tight.retransmitRingSize = 0;
+    EXPECT_THROW(hsnet::make_udp_reliable_publisher(tight), std::runtime_error);
+
+    std::vector<std::vector<uint8_t>> received;
+    std::vector<bool> ends;
+    auto start = steady_clock::now();
+    while (received.size() < 2 && steady_clock::now() - start < 5s) {
+        sub->poll([&](const hsnet::MessageView& mv) {
+            received.emplace_back(mv.data, mv.data + mv.length);
+            ends.push_back(mv.endOfMessage);
+        }, 8);
+    }
+
+    ASSERT_EQ(received.size(), 2u);
+    EXPECT_EQ(received[0], snapshot);
+    EXPECT_EQ(received[1], std::vector<uint8_t>(tail, tail + 1));
+    EXPECT_EQ(ends, (std::vector<bool>{true, true}));
+    EXPECT_GE(sub->stats().framesReceived, 8u);
+
+    // The largest message the defaults allow goes through whole
+    std::vector<uint8_t> largest(pubCfg.maxMessageSize);
+    for (size_t i = 0; i < largest.size(); ++i) largest[i] = static_cast<uint8_t>(i * 13);
+    ASSERT_EQ(pub->offer(largest, pubCfg.stream_id), hsnet::PublishResult::OK);
+    std::vector<uint8_t> got;
+    start = steady_clock::now();
+    while (got.empty() && steady_clock::now() - start < 5s) {
+        pub->flush();  // Serves NAKs for anything the socket buffer dropped
+        sub->poll([&](const hsnet::MessageView& mv) { got.assign(mv.data, mv.data + mv.length); }, 8);
+    }
+    EXPECT_EQ(got, largest);
+}
+
+TEST(UdpReliable, LateSubscribersRecoverLostFramesWithNaks) {
+    using namespace std::chrono;
+    hsnet::FeedPublisherConfig pubCfg;
+    pubCfg.enable_crc32_c = true;
+    pubCfg.nakSuppressNs = 10'000'000'000;  // Everything after the first resend is a duplicate
+    hsnet::FeedSubscriberConfig subCfg;
+    subCfg.enable_crc32_c = true;
+
+    // Sequences 0-2 go out before anyone has joined, so they are lost
+    auto pub = hsnet::make_udp_reliable_publisher(pubCfg);
+    auto send = [&](uint8_t value) {
+        const uint8_t msg[] = {value};
+        ASSERT_EQ(pub->offer(msg, pubCfg.stream_id), hsnet::PublishResult::OK);
+    };
+    for (uint8_t v = 0; v < 3; ++v) send(v);
+
+    auto sub1 = hsnet::make_udp_reliable_subscriber(subCfg);
+    auto sub2 = hsnet::make_udp_reliable_subscriber(subCfg);
+    for (uint8_t v = 3; v < 5; ++v) send(v);
+
+    std::vector<uint8_t> got1;
+    std::vector<uint8_t> got2;
+    auto poll_both = [&] {
+        sub1->poll([&](const hsnet::MessageView& mv) { got1.push_back(mv.data[0]); }, 8);
+        sub2->poll([&](const hsnet::MessageView& mv) { got2.push_back(mv.data[0]); }, 8);
+    };
+
+    // Both see the gap behind 3 and 4 and ask for it
+    auto start = steady_clock::now();
+    while ((sub1->stats().naksSent == 0 || sub2->stats().naksSent == 0) && steady_clock::now() - start < 5s) {
+        poll_both();
+    }
+    EXPECT_TRUE(got1.empty());
+    EXPECT_TRUE(got2.empty());
+
+    // The publisher answers from its ring; one resend reaches both
+    start = steady_clock::now();
+    while ((got1.size() < 5 || got2.size() < 5) && steady_clock::now() - start < 5s) {
+        pub->flush();
+        poll_both();
+    }
+
+    const std::vector<uint8_t> expected = {0, 1, 2, 3, 4};
+    EXPECT_EQ(got1, expected);
+    EXPECT_EQ(got2, expected);
+    const hsnet::PublicationStats stats = pub->stats();
+    EXPECT_EQ(stats.framesSent, 5u);
+    EXPECT_GE(stats.naksReceived, 2u);
+    EXPECT_EQ(stats.retransmits, 3u);
+    EXPECT_GE(stats.retransmitsSuppressed, 3u);
+    EXPECT_EQ(stats.retransmitsUnavailable, 0u);
+}
+
+TEST(UdpReliable, RetransmitRingHoldsItsConfiguredFrames) {
+    using namespace std::chrono;
+    hsnet::FeedPublisherConfig pubCfg;
+    hsnet::FeedSubscriberConfig subCfg;
+
+    // Hundreds of frames go out before the subscriber joins; with the
+    // default ring they are all still held for NAKs
+    auto pub = hsnet::make_udp_reliable_publisher(pubCfg);
+    constexpr uint32_t early = 300;
+    auto send = [&](uint32_t value) {
+        ASSERT_EQ(pub->offer(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(&value), sizeof(value)),
+                             pubCfg.stream_id),
+                  hsnet::PublishResult::OK);
+    };
+    for (uint32_t i = 0; i < early; ++i) send(i);
+    auto sub = hsnet::make_udp_reliable_subscriber(subCfg);
+    send(early);
+
+    std::vector<uint32_t> received;
+    auto start = steady_clock::now();
+    while (received.size() <= early && steady_clock::now() - start < 5s) {
+        pub->flush();
+        sub->poll([&](const hsnet::MessageView& mv) {
+            uint32_t v;
+            std::memcpy(&v, mv.data, sizeof(v));
+            received.push_back(v);
+        }, 64);
+    }
+    ASSERT_EQ(received.size(), early + 1);
+    for (uint32_t i = 0; i <= early; ++i) ASSERT_EQ(received[i], i);
+    const hsnet::PublicationStats stats = pub->stats();
+    EXPECT_GE(stats.retransmits, early);
+    EXPECT_EQ(stats.retransmitsUnavailable, 0u);
+    EXPECT_EQ(stats.resetsSent, 0u);
+}
+
+TEST(UdpReliable, SessionWindowBackpressuresUntilAcked) {
+    using namespace std::chrono;
+    hsnet::UdpConfig senderCfg;
+    senderCfg.local_endpoint = "127.0.0.1:8271";
+    senderCfg.remote_endpoint = "127.0.0.1:8272";
+    senderCfg.reorderWindow = 16;  // Initial window, before the receiver has said anything
+    hsnet::UdpConfig receiverCfg;
+    receiverCfg.local_endpoint = "127.0.0.1:8272";
+    receiverCfg.remote_endpoint = "127.0.0.1:8271";
+    receiverCfg.reorderWindow = 16;
+
+    auto sender = hsnet::make_udp_reliable_transport(senderCfg);
+    auto receiver = hsnet::make_udp_reliable_transport(receiverCfg);
+    auto pub = sender->create_publication("", senderCfg.stream_id);
+    auto sub = receiver->create_subscription("", receiverCfg.stream_id);
+
+    // Nothing goes out until the receiver has answered the HELLO
+    uint32_t sent = 0;
+    EXPECT_EQ(pub->offer(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(&sent), sizeof(sent)),
+                         senderCfg.stream_id),
+              hsnet::PublishResult::NOTCONNECTED);
+    auto start = steady_clock::now();
+    while (!pub->isConnected() && steady_clock::now() - start < 5s) {
+        pub->flush();
+        sub->poll([](const hsnet::MessageView&) {}, 8);
+    }
+    ASSERT_TRUE(pub->isConnected());
+    EXPECT_TRUE(sub->isConnected());
+
+    // Nobody is reading: the window fills and offer() pushes back
+    while (pub->offer(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(&sent), sizeof(sent)),
+                      senderCfg.stream_id) == hsnet::PublishResult::OK) {
+        ++sent;
+    }
+    EXPECT_EQ(sent, 16u);
+    EXPECT_EQ(pub->availableWindow(), 0u);
+
+    // The receiver's ACKs open the window as it drains
+    constexpr uint32_t total = 500;
+    std::vector<uint32_t> received;
+    int backpressured = 0;
+    start = steady_clock::now();
+    while (received.size() < total && steady_clock::now() - start < 10s) {
+        if (sent < total) {
+            const hsnet::PublishResult result = pub->offer(
+                std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(&sent), sizeof(sent)), senderCfg.stream_id);
+            if (result == hsnet::PublishResult::OK) {
+                ++sent;
+            } else {
+                EXPECT_EQ(result, hsnet::PublishResult::BACKPRESSURED);
+                ++backpressured;
+            }
+        }
+        pub->flush();
+        sub->poll([&](const hsnet::MessageView& mv) {
+            uint32_t v;
+            std::memcpy(&v, mv.data, sizeof(v));
+            received.push_back(v);
+        }, 8);
+    }
+
+    ASSERT_EQ(received.size(), total);
+    for (uint32_t i = 0; i < total; ++i) EXPECT_EQ(received[i], i);
+    EXPECT_GT(backpressured, 0);
+    EXPECT_GT(sub->stats().acksSent, 0u);
+    const hsnet::PublicationStats stats = pub->stats();
+    EXPECT_GT(stats.acksReceived, 0u);
+    EXPECT_GT(stats.rttNs, 0u);
+    EXPECT_GT(pub->availableWindow(), 0u);
+}
+
+TEST(UdpReliable, HelloIsRetriedWithoutHeartbeats) {
+    using namespace std::chrono;
+    hsnet::UdpConfig senderCfg;
+    senderCfg.local_endpoint = "127.0.0.1:8277";
+    senderCfg.remote_endpoint = "127.0.0.1:8278";
+    senderCfg.heartbeatIntervalNs = 0;
+    hsnet::UdpConfig receiverCfg;
+    receiverCfg.local_endpoint = "127.0.0.1:8278";
+    receiverCfg.remote_endpoint = "127.0.0.1:8277";
+    receiverCfg.heartbeatIntervalNs = 0;
+
+    // The first HELLO goes out before the receiver's socket exists
+    auto sender = hsnet::make_udp_reliable_transport(senderCfg);
+    auto pub = sender->create_publication("", senderCfg.stream_id);
+    const uint32_t value = 7;
+    const std::span<const uint8_t> msg(reinterpret_cast<const uint8_t*>(&value), sizeof(value));
+    EXPECT_EQ(pub->offer(msg, senderCfg.stream_id), hsnet::PublishResult::NOTCONNECTED);
+
+    auto receiver = hsnet::make_udp_reliable_transport(receiverCfg);
+    auto sub = receiver->create_subscription("", receiverCfg.stream_id);
+    auto start = steady_clock::now();
+    while (!pub->isConnected() && steady_clock::now() - start < 5s) {
+        pub->flush();
+        sub->poll([](const hsnet::MessageView&) {}, 8);
+    }
+    ASSERT_TRUE(pub->isConnected());
+    EXPECT_EQ(pub->offer(msg, senderCfg.stream_id), hsnet::PublishResult::OK);
+    EXPECT_EQ(pub->stats().heartbeatsSent, 0u);
+}
+
+TEST(UdpReliable, HeartbeatsExposeTailLossAndResetsSkipLostFrames) {
+    using namespace std::chrono;
+    hsnet::FeedPublisherConfig pubCfg;
+    pubCfg.txRingSize = 8;  // Eight slots, no retransmit reserve
+    pubCfg.retransmitRingSize = 0;
+    pubCfg.maxMessageSize = 1024;
+    pubCfg.heartbeatIntervalNs = 100'000;
+    hsnet::FeedSubscriberConfig subCfg;
+    subCfg.livenessTimeoutNs = 20'000'000;
+
+    // Twenty frames go out before anyone listens, then the feed goes quiet
+    auto pub = hsnet::make_udp_reliable_publisher(pubCfg);
+    for (uint8_t v = 0; v < 20; ++v) {
+        const uint8_t msg[] = {v};
+        ASSERT_EQ(pub->offer(msg, pubCfg.stream_id), hsnet::PublishResult::OK);
+    }
+    auto sub = hsnet::make_udp_reliable_subscriber(subCfg);
+    EXPECT_FALSE(sub->isConnected());
+
+    // Only heartbeats tell the subscriber what it missed. The first twelve
+    // frames are gone, so the publisher resets it to the oldest one it holds.
+    std::vector<uint8_t> received;
+    auto start = steady_clock::now();
+    while (received.size() < 8 && steady_clock::now() - start < 5s) {
+        pub->flush();
+        sub->poll([&](const hsnet::MessageView& mv) { received.push_back(mv.data[0]); }, 8);
+    }
+    EXPECT_EQ(received, (std::vector<uint8_t>{12, 13, 14, 15, 16, 17, 18, 19}));
+    EXPECT_TRUE(sub->isConnected());
+    EXPECT_GT(sub->stats().heartbeatsReceived, 0u);
+    EXPECT_GE(sub->stats().resets, 1u);
+    EXPECT_GE(pub->stats().resetsSent, 1u);
+    EXPECT_GE(pub->stats().retransmitsUnavailable, 12u);
+
+    // A publisher that stops sending heartbeats is eventually declared gone
+    pub.reset();
+    start = steady_clock::now();
+    while (sub->isConnected() && steady_clock::now() - start < 5s) {
+        sub->poll([](const hsnet::MessageView&) {}, 8);
+    }
+    EXPECT_FALSE(sub->isConnected());
+}
+
+TEST(UdpReliable, StreamsHaveIndependentSequencesAndGaps) {
+    using namespace std::chrono;
+    hsnet::FeedPublisherConfig pubCfg;
+    pubCfg.stream_id = 2;
+    hsnet::FeedSubscriberConfig subCfg;
+    subCfg.nakDelayNs = 0;
+
+    auto sub = hsnet::make_udp_reliable_subscriber(subCfg);
+    auto pub = hsnet::make_udp_reliable_publisher(pubCfg);
+
+    // Stream 1 gets a frame it can never deliver: sequences 0-4 don't exist
+    const char stuck[] = "STUCK";
+    uint8_t frame[sizeof(hsnet::proto::Header) + sizeof(stuck)];
+    hsnet::proto::Header h{};
+    h.sequence_number = 5;
+    h.payload_length = sizeof(stuck);
+    h.stream_id = 1;
+    hsnet::proto::set_type_flags(h, hsnet::proto::FrameType::DATA, 0);
+    const size_t len = hsnet::proto::write_frame(frame, h, reinterpret_cast<const uint8_t*>(stuck), sizeof(stuck));
+    int raw = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(raw, 0);
+    sockaddr_in dest{};
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(subCfg.port);
+    inet_pton(AF_INET, "239.1.1.1", &dest.sin_addr);
+    ASSERT_EQ(sendto(raw, frame, len, 0, reinterpret_cast<sockaddr*>(&dest), sizeof(dest)), static_cast<ssize_t>(len));
+    close(raw);
+
+    // Stream 2 numbers its own messages from zero and isn't held up by the gap
+    for (uint8_t v = 0; v < 3; ++v) {
+        const uint8_t msg[] = {v};
+        ASSERT_EQ(pub->offer(msg, pubCfg.stream_id), hsnet::PublishResult::OK);
+    }
+    const uint8_t other[] = {9};
+    EXPECT_EQ(pub->offer(other, 1), hsnet::PublishResult::ERROR);
+
+    std::vector<hsnet::MessageView> received;
+    std::vector<uint8_t> values;
+    auto start = steady_clock::now();
+    while (values.size() < 3 && steady_clock::now() - start < 5s) {
+        sub->pollStream(2, [&](const hsnet::MessageView& mv) {
+            received.push_back(mv);
+            values.push_back(mv.data[0]);
+        }, 8);
+    }
+
+    ASSERT_EQ(values, (std::vector<uint8_t>{0, 1, 2}));
+    for (uint64_t i = 0; i < received.size(); ++i) {
+        EXPECT_EQ(received[i].streamId, 2u);
+        EXPECT_EQ(received[i].sequenceNumber, i);
+    }
+    EXPECT_FALSE(sub->hasData(1));
+    EXPECT_EQ(sub->poll([](const hsnet::MessageView&) {}, 8), 0);
+    EXPECT_TRUE(sub->isConnected(2));
+    EXPECT_EQ(sub->stats().unknownStreams, 0u);
+}
+
+TEST(UdpReliable, TransportSubscriptionsDeliverTheirOwnStream) {
+    using namespace std::chrono;
+    hsnet::UdpConfig senderCfg;
+    senderCfg.local_endpoint = "127.0.0.1:8273";
+    senderCfg.remote_endpoint = "127.0.0.1:8274";
+    hsnet::UdpConfig receiverCfg;
+    receiverCfg.local_endpoint = "127.0.0.1:8274";
+    receiverCfg.remote_endpoint = "127.0.0.1:8273";
+
+    auto sender = hsnet::make_udp_reliable_transport(senderCfg);
+    auto receiver = hsnet::make_udp_reliable_transport(receiverCfg);
+    auto pubA = sender->create_publication("", 10);
+    auto pubB = sender->create_publication("", 20);
+    auto subA = receiver->create_subscription("", 10);
+    auto subB = receiver->create_subscription("", 20);
+
+    // Each stream is its own session
+    auto start = steady_clock::now();
+    while ((!pubA->isConnected() || !pubB->isConnected()) && steady_clock::now() - start < 5s) {
+        pubA->flush();
+        pubB->flush();
+        subA->poll([](const hsnet::MessageView&) {}, 8);
+    }
+    ASSERT_TRUE(pubA->isConnected());
+    ASSERT_TRUE(pubB->isConnected());
+    EXPECT_TRUE(subB->isConnected());
+
+    for (uint8_t v = 0; v < 3; ++v) {
+        const uint8_t msg[] = {v};
+        ASSERT_EQ(pubA->offer(msg, 10), hsnet::PublishResult::OK);
+    }
+    for (uint8_t v = 100; v < 105; ++v) {
+        const uint8_t msg[] = {v};
+        ASSERT_EQ(pubB->offer(msg, 20), hsnet::PublishResult::OK);
+    }
+
+    // Polling one stream leaves the other's messages buffered for it
+    std::vector<hsnet::MessageView> a;
+    std::vector<hsnet::MessageView> b;
+    start = steady_clock::now();
+    while ((a.size() < 3 || b.size() < 5) && steady_clock::now() - start < 5s) {
+        subA->poll([&](const hsnet::MessageView& mv) { a.push_back(mv); }, 8);
+        subB->poll([&](const hsnet::MessageView& mv) { b.push_back(mv); }, 8);
+    }
+    ASSERT_EQ(a.size(), 3u);
+    ASSERT_EQ(b.size(), 5u);
+    for (uint64_t i = 0; i < a.size(); ++i) {
+        EXPECT_EQ(a[i].streamId, 10u);
+        EXPECT_EQ(a[i].sequenceNumber, i);
+    }
+    for (uint64_t i = 0; i < b.size(); ++i) {
+        EXPECT_EQ(b[i].streamId, 20u);
+        EXPECT_EQ(b[i].sequenceNumber, i);
+    }
+}
+
+TEST(UdpReliable, CoalescesSmallMessagesIntoSharedFrames) {
+    using namespace std::chrono;
+    hsnet::FeedPublisherConfig pubCfg;
+    pubCfg.enable_crc32_c = true;
+    pubCfg.enable_coalescing = true;
+    pubCfg.coalesceDelayNs = 1'000'000'000;  // Only size and flush() send the frame
+    hsnet::FeedSubscriberConfig subCfg;
+    subCfg.enable_crc32_c = true;
+
+    auto sub = hsnet::make_udp_reliable_subscriber(subCfg);
+    auto pub = hsnet::make_udp_reliable_publisher(pubCfg);
+
+    // 100 messages of 32 bytes: 42 fit in a 1432-byte payload with their prefixes
+    constexpr uint32_t total = 100;
+    for (uint32_t i = 0; i < total; ++i) {
+        uint8_t msg[32] = {};
+        std::memcpy(msg, &i, sizeof(i));
+        ASSERT_EQ(pub->offer(msg, pubCfg.stream_id), hsnet::PublishResult::OK);
+    }
+    EXPECT_EQ(pub->stats().framesSent, 2u);
+    pub->flush();
+
+    std::vector<uint32_t> received;
+    auto start = steady_clock::now();
+    while (received.size() < total && steady_clock::now() - start < 5s) {
+        sub->poll([&](const hsnet::MessageView& mv) {
+            ASSERT_EQ(mv.length, 32u);
+            uint32_t v;
+            std::memcpy(&v, mv.data, sizeof(v));
+            received.push_back(v);
+        }, 16);
+    }
+
+    ASSERT_EQ(received.size(), total);
+    for (uint32_t i = 0; i < total; ++i) EXPECT_EQ(received[i], i);
+    EXPECT_EQ(pub->stats().framesSent, 3u);
+    EXPECT_EQ(pub->stats().messagesPacked, total);
+    EXPECT_EQ(sub->stats().framesReceived, 3u);
+    EXPECT_EQ(sub->stats().messagesDelivered, total);
+}
+
+TEST(UdpReliable, IoUringBackendSharesTheProtocol) {
+    using namespace std::chrono;
+    // Without io_uring both ends would quietly fall back to sockets
+    if (!hsnet::IoUring(64, true).ok() || !hsnet::IoUring(64, false).ok()) GTEST_SKIP() << "io_uring unavailable";
+
+    hsnet::UdpConfig senderCfg;
+    senderCfg.local_endpoint = "127.0.0.1:8275";
+    senderCfg.remote_endpoint = "127.0.0.1:8276";
+    senderCfg.ioBackend = hsnet::IoBackend::IO_URING;
+    senderCfg.ioUringSqPoll = true;
+    senderCfg.ioUringEntries = 64;
+    senderCfg.sendBatchSize = 16;
+    hsnet::UdpConfig receiverCfg;
+    receiverCfg.local_endpoint = "127.0.0.1:8276";
+    receiverCfg.remote_endpoint = "127.0.0.1:8275";
+    receiverCfg.ioBackend = hsnet::IoBackend::IO_URING;
+    receiverCfg.ioUringEntries = 64;
+    receiverCfg.enable_timestamps = true;
+
+    auto sender = hsnet::make_udp_reliable_transport(senderCfg);
+    auto receiver = hsnet::make_udp_reliable_transport(receiverCfg);
+    auto pub = sender->create_publication("", senderCfg.stream_id);
+    auto sub = receiver->create_subscription("", receiverCfg.stream_id);
+
+    auto start = steady_clock::now();
+    while (!pub->isConnected() && steady_clock::now() - start < 5s) {
+        pub->flush();
+        sub->poll([](const hsnet::MessageView&) {}, 8);
+    }
+    ASSERT_TRUE(pub->isConnected());
+    EXPECT_TRUE(pub->stats().ioUring);
+
+    // More frames than submission entries and receive buffers, with
+    // fragmented messages in between
+    constexpr uint32_t total = 2000;
+    std::vector<uint32_t> received;
+    uint32_t sent = 0;
+    start = steady_clock::now();
+    while (received.size() < total && steady_clock::now() - start < 10s) {
+        if (sent < total) {
+            std::vector<uint8_t> msg(sent % 100 == 0 ? 4000 : 8, static_cast<uint8_t>(sent));
+            std::memcpy(msg.data(), &sent, sizeof(sent));
+            if (pub->offer(msg, senderCfg.stream_id) == hsnet::PublishResult::OK) ++sent;
+        }
+        pub->flush();
+        sub->poll([&](const hsnet::MessageView& mv) {
+            ASSERT_EQ(mv.length, received.size() % 100 == 0 ? 4000u : 8u);
+            EXPECT_EQ(mv.data[mv.length - 1], static_cast<uint8_t>(received.size()));
+            uint32_t v;
+            std::memcpy(&v, mv.data, sizeof(v));
+            received.push_back(v);
+        }, 64);
+    }
+
+    ASSERT_EQ(received.size(), total);
+    for (uint32_t i = 0; i < total; ++i) EXPECT_EQ(received[i], i);
+    EXPECT_GT(sub->stats().acksSent, 0u);
+    EXPECT_GT(pub->stats().acksReceived, 0u);
+    // Neither end fell back to sockets along the way
+    EXPECT_TRUE(pub->stats().ioUring);
+    EXPECT_TRUE(sub->stats().ioUring);
+    // Timestamps come through the io_uring control data too
+    const hsnet::LatencyHistogram* latency = sub->latency(receiverCfg.stream_id);
+    ASSERT_NE(latency, nullptr);
+    EXPECT_GE(latency->count(), total);
+}
+
+TEST(UdpReliable, KernelTimestampsGiveOneWayLatency) {
+    using namespace std::chrono;
+    hsnet::FeedPublisherConfig pubCfg;
+    hsnet::FeedSubscriberConfig subCfg;
+    subCfg.enable_timestamps = true;
+
+    auto sub = hsnet::make_udp_reliable_subscriber(subCfg);
+    auto pub = hsnet::make_udp_reliable_publisher(pubCfg);
+    EXPECT_EQ(sub->latency(subCfg.stream_id + 1), nullptr);
+
+    constexpr uint32_t total = 100;
+    for (uint32_t i = 0; i < total; ++i) {
+        ASSERT_EQ(pub->offer(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(&i), sizeof(i)),
+                             pubCfg.stream_id),
+                  hsnet::PublishResult::OK);
+    }
+    const uint64_t sent_by = TscClock::realtimeNs();
+
+    uint32_t received = 0;
+    auto start = steady_clock::now();
+    while (received < total && steady_clock::now() - start < 5s) {
+        sub->poll([&](const hsnet::MessageView& mv) {
+            // Sent, then received by the kernel, then polled
+            EXPECT_GT(mv.sendTimeNs, 0u);
+            EXPECT_GE(mv.receiveTimeNs + 1'000'000, mv.sendTimeNs);  // Slack for the TSC calibration
+            EXPECT_LE(mv.sendTimeNs, sent_by);
+            EXPECT_LE(mv.receiveTimeNs, TscClock::realtimeNs() + 1'000'000);
+            ++received;
+        }, 16);
+    }
+    ASSERT_EQ(received, total);
+
+    const hsnet::LatencyHistogram* latency = sub->latency(subCfg.stream_id);
+    ASSERT_NE(latency, nullptr);
+    EXPECT_EQ(latency->count(), total);
+    EXPECT_LE(latency->percentile(0.5), latency->max());
+    EXPECT_LT(latency->percentile(0.5), 1'000'000'000u);
+}
+
+TEST(UdpReliable, SubscribersJoinOnlyTheirChannels) {
+    using namespace std::chrono;
+    const hsnet::FeedChannels channels{"239.1.2.0", 3};
+    EXPECT_EQ(channels.channel_of(7), 1u);
+    EXPECT_EQ(channels.group(2), "239.1.2.2");
+    EXPECT_EQ((hsnet::FeedChannels{"239.1.2.254", 4}.group(3)), "239.1.3.1");
+    EXPECT_THROW((hsnet::FeedChannels{"239.255.255.255", 2}.group(1)), std::runtime_error);
+
+    // One publication per channel, each its own stream
+    std::vector<std::unique_ptr<hsnet::IPublication>> pubs;
+    for (uint32_t channel = 0; channel < channels.count; ++channel) {
+        hsnet::FeedPublisherConfig pubCfg;
+        pubCfg.multicast_group = channels.group(channel);
+        pubCfg.port = 8180;
+        pubCfg.local_interface = "127.0.0.1";
+        pubCfg.stream_id = channel + 1;
+        pubs.push_back(hsnet::make_udp_reliable_publisher(pubCfg));
+    }
+
+    // Instruments 0 and 3 both live on channel 0; 4 and 8 on channels 1 and 2
+    hsnet::FeedSubscriberConfig narrowCfg;
+    narrowCfg.port = 8180;
+    narrowCfg.local_interface = "127.0.0.1";
+    const uint32_t narrowInstruments[] = {0, 3};
+    narrowCfg.multicast_groups = channels.groups_for(narrowInstruments);
+    ASSERT_EQ(narrowCfg.multicast_groups.size(), 1u);
+    hsnet::FeedSubscriberConfig wideCfg = narrowCfg;
+    const uint32_t wideInstruments[] = {4, 8};
+    wideCfg.multicast_groups = channels.groups_for(wideInstruments);
+    auto narrow = hsnet::make_udp_reliable_subscriber(narrowCfg);
+    auto wide = hsnet::make_udp_reliable_subscriber(wideCfg);
+
+    constexpr uint32_t perChannel = 50;
+    for (uint32_t i = 0; i < perChannel; ++i) {
+        for (uint32_t channel = 0; channel < channels.count; ++channel) {
+            ASSERT_EQ(pubs[channel]->offer(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(&i), sizeof(i)),
+                                           channel + 1),
+                      hsnet::PublishResult::OK);
+        }
+    }
+
+    std::vector<uint32_t> narrowCounts(channels.count + 1);
+    std::vector<uint32_t> wideCounts(channels.count + 1);
+    auto count = [](std::vector<uint32_t>& counts) {
+        return [&counts](const hsnet::MessageView& mv) {
+            ASSERT_LT(mv.streamId, counts.size());
+            uint32_t v;
+            std::memcpy(&v, mv.data, sizeof(v));
+            EXPECT_EQ(v, counts[mv.streamId]);
+            counts[mv.streamId]++;
+        };
+    };
+    auto start = steady_clock::now();
+    while ((narrowCounts[1] < perChannel || wideCounts[2] < perChannel || wideCounts[3] < perChannel) &&
+           steady_clock::now() - start < 5s) {
+        narrow->poll(count(narrowCounts), 64);
+        wide->poll(count(wideCounts), 64);
+    }
+    EXPECT_EQ(narrowCounts, (std::vector<uint32_t>{0, perChannel, 0, 0}));
+    EXPECT_EQ(wideCounts, (std::vector<uint32_t>{0, 0, perChannel, perChannel}));
+    // The other channels never reached the socket at all
+    EXPECT_EQ(narrow->stats().framesReceived, perChannel);
+    EXPECT_EQ(narrow->stats().unknownStreams, 0u);
+
+    hsnet::FeedSubscriberConfig notMulticast;
+    notMulticast.multicast_group = "10.1.2.3";
+    EXPECT_THROW(hsnet::make_udp_reliable_subscriber(notMulticast), std::runtime_error);
+}
@@ -0,0 +1,35 @@
+// Expands binary logs written by Logger in binary mode into text lines.
+//
+//   hft_logdecode <file.blog> [more.blog ...]
+//
+// Files are decoded in the order given (e.g. rotated segments oldest first)
+// and the text goes to stdout in the same format as the text sinks.
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "LogFormat.h"
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <binary log> [binary log ...]" << std::endl;
+        return 1;
+    }
+
+    int status = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::ifstream in(argv[i], std::ios::binary);
+        if (!in) {
+            std::cerr << argv[i] << ": cannot open" << std::endl;
+            status = 1;
+            continue;
+        }
+        std::string error;
+        if (!binlog::decode(in, std::cout, &error)) {
+            std::cerr << argv[i] << ": " << error << std::endl;
+            status = 1;
+        }
+    }
+    return status;
+}
@@ -0,0 +1,281 @@
+#include "LogFormat.h"
+
+#include <ctime>
+#include <format>
+
+const char* logLevelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO: return "INFO";
+        case LogLevel::WARNING: return "WARNING";
+        case LogLevel::ERROR: return "ERROR";
+        default: return "UNKNOWN";
+    }
+}
+
+namespace {
+
+struct ArgValue {
+    LogArgType type;
+    int64_t i = 0;
+    uint64_t u = 0;
+    double d = 0;
+    bool b = false;
+    char c = 0;
+    std::string_view s;
+};
+
+template <typename T>
+bool take(const uint8_t*& p, const uint8_t* end, T& v) {
+    if (static_cast<size_t>(end - p) < sizeof(T)) return false;
+    std::memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+bool decodeArgs(const std::vector<LogArgType>& types, const uint8_t* data, size_t len,
+                std::vector<ArgValue>& values) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + len;
+    values.clear();
+    for (LogArgType type : types) {
+        ArgValue v{type};
+        uint8_t byte = 0;
+        uint16_t slen = 0;
+        bool ok = true;
+        switch (type) {
+            case LogArgType::I64: ok = take(p, end, v.i); break;
+            case LogArgType::U64: ok = take(p, end, v.u); break;
+            case LogArgType::F64: ok = take(p, end, v.d); break;
+            case LogArgType::BOOL: ok = take(p, end, byte); v.b = byte != 0; break;
+            case LogArgType::CHAR: ok = take(p, end, byte); v.c = static_cast<char>(byte); break;
+            case LogArgType::STRING:
+                ok = take(p, end, slen) && static_cast<size_t>(end - p) >= slen;
+                if (ok) {
+                    v.s = std::string_view(reinterpret_cast<const char*>(p), slen);
+                    p += slen;
+                }
+                break;
+            default: ok = false;
+        }
+        if (!ok) return false;
+        values.push_back(v);
+    }
+    return true;
+}
+
+void formatValue(std::string& out, const ArgValue& v, std::string_view spec) {
+    std::string f = spec.empty() ? std::string("{}") : "{:" + std::string(spec) + "}";
+    try {
+        switch (v.type) {
+            case LogArgType::I64: out += std::vformat(f, std::make_format_args(v.i)); break;
+            case LogArgType::U64: out += std::vformat(f, std::make_format_args(v.u)); break;
+            case LogArgType::F64: out += std::vformat(f, std::make_format_args(v.d)); break;
+            case LogArgType::BOOL: out += std::vformat(f, std::make_format_args(v.b)); break;
+            case LogArgType::CHAR: out += std::vformat(f, std::make_format_args(v.c)); break;
+            case LogArgType::STRING: out += std::vformat(f, std::make_format_args(v.s)); break;
+        }
+    } catch (const std::format_error&) {
+        out += "{!}";
+    }
+}
+
+}  // namespace
+
+bool formatLogArgs(std::string& out, std::string_view fmt, const std::vector<LogArgType>& types,
+                   const uint8_t* data, size_t len) {
+    thread_local std::vector<ArgValue> values;
+    if (!decodeArgs(types, data, len, values)) return false;
+
+    size_t next_auto = 0;
+    size_t i = 0;
+    while (i < fmt.size()) {
+        const char c = fmt[i];
+        if (c == '{' || c == '}') {
+            if (i + 1 < fmt.size() && fmt[i + 1] == c) {  // Escaped brace
+                out += c;
+                i += 2;
+                continue;
+            }
+            if (c == '}') {
+                out += c;
+                ++i;
+                continue;
+            }
+            size_t close = fmt.find('}', i);
+            if (close == std::string_view::npos) {
+                out.append(fmt.substr(i));
+                break;
+            }
+            std::string_view field = fmt.substr(i + 1, close - i - 1);
+            size_t colon = field.find(':');
+            std::string_view index = field.substr(0, colon);
+            std::string_view spec = colon == std::string_view::npos ? std::string_view{} : field.substr(colon + 1);
+
+            size_t arg = next_auto;
+            if (index.empty()) {
+                ++next_auto;
+            } else {
+                arg = 0;
+                for (char d : index) arg = arg * 10 + static_cast<size_t>(d - '0');
+            }
+            if (arg < values.size()) {
+                formatValue(out, values[arg], spec);
+            } else {
+                out += "{?}";
+            }
+            i = close + 1;
+            continue;
+        }
+        size_t next = fmt.find_first_of("{}", i);
+        if (next == std::string_view::npos) next = fmt.size();
+        out.append(fmt.substr(i, next - i));
+        i = next;
+    }
+    return true;
+}
+
+void LogLinePrefix::append(std::string& out, LogLevel level, uint64_t timestamp_ns) {
+    const int64_t sec = static_cast<int64_t>(timestamp_ns / 1'000'000'000ull);
+    if (sec != time_sec_) {
+        std::time_t t = static_cast<std::time_t>(sec);
+        std::tm tm{};
+        localtime_r(&t, &tm);
+        char buf[32];
+        size_t n = std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+        time_.assign(buf, n);
+        time_sec_ = sec;
+    }
+    // Log format: [LEVEL][timestamp] message
+    out += '[';
+    out += logLevelName(level);
+    out += "][";
+    out += time_;
+    out += "] ";
+}
+
+namespace binlog {
+
+namespace {
+
+template <typename T>
+void put(std::string& out, T v) {
+    out.append(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+template <typename T>
+bool get(std::istream& in, T& v) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&v), sizeof(T)));
+}
+
+bool getString(std::istream& in, std::string& s) {
+    uint16_t len = 0;
+    if (!get(in, len)) return false;
+    s.resize(len);
+    return len == 0 || static_cast<bool>(in.read(s.data(), len));
+}
+
+}  // namespace
+
+void appendSite(std::string& out, uint32_t site_id, const LogSiteInfo& site) {
+    put(out, RecordTag::SITE);
+    put(out, site_id);
+    put(out, static_cast<uint8_t>(site.level));
+    put(out, static_cast<uint32_t>(site.line));
+    put(out, static_cast<uint8_t>(site.types.size()));
+    for (LogArgType t : site.types) put(out, t);
+    put(out, static_cast<uint16_t>(site.file.size()));
+    out += site.file;
+    put(out, static_cast<uint16_t>(site.fmt.size()));
+    out += site.fmt;
+}
+
+void appendEvent(std::string& out, uint32_t site_id, uint64_t timestamp_ns, const uint8_t* args, uint16_t len) {
+    put(out, RecordTag::EVENT);
+    put(out, site_id);
+    put(out, timestamp_ns);
+    put(out, len);
+    out.append(reinterpret_cast<const char*>(args), len);
+}
+
+void appendText(std::string& out, LogLevel level, uint64_t timestamp_ns, const char* msg, uint16_t len) {
+    put(out, RecordTag::TEXT);
+    put(out, static_cast<uint8_t>(level));
+    put(out, timestamp_ns);
+    put(out, len);
+    out.append(msg, len);
+}
+
+bool decode(std::istream& in, std::ostream& out, std::string* error) {
+    auto fail = [error](const std::string& why) {
+        if (error) *error = why;
+        return false;
+    };
+
+    char magic[sizeof(kMagic)];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) {
+        return fail("not a binary log (bad magic)");
+    }
+
+    std::vector<LogSiteInfo> sites;
+    std::vector<bool> known;
+    std::string line;
+    std::string payload;
+    LogLinePrefix prefix;
+    RecordTag tag;
+    while (get(in, tag)) {
+        line.clear();
+        switch (tag) {
+            case RecordTag::SITE: {
+                uint32_t id = 0, src_line = 0;
+                uint8_t level = 0, nargs = 0;
+                if (!get(in, id) || !get(in, level) || !get(in, src_line) || !get(in, nargs)) {
+                    return fail("truncated site record");
+                }
+                LogSiteInfo site{static_cast<LogLevel>(level), {}, static_cast<int>(src_line), {}, {}};
+                site.types.resize(nargs);
+                for (auto& t : site.types) {
+                    if (!get(in, t)) return fail("truncated site record");
+                }
+                if (!getString(in, site.file) || !getString(in, site.fmt)) return fail("truncated site record");
+                if (id >= sites.size()) {
+                    sites.resize(id + 1);
+                    known.resize(id + 1, false);
+                }
+                sites[id] = std::move(site);
+                known[id] = true;
+                continue;
+            }
+            case RecordTag::EVENT: {
+                uint32_t id = 0;
+                uint64_t ts = 0;
+                if (!get(in, id) || !get(in, ts) || !getString(in, payload)) return fail("truncated event record");
+                if (id >= known.size() || !known[id]) {
+                    return fail("event references unknown site " + std::to_string(id));
+                }
+                const LogSiteInfo& site = sites[id];
+                prefix.append(line, site.level, ts);
+                if (!formatLogArgs(line, site.fmt, site.types, reinterpret_cast<const uint8_t*>(payload.data()),
+                                   payload.size())) {
+                    return fail("arguments do not match site " + std::to_string(id));
+                }
+                break;
+            }
+            case RecordTag::TEXT: {
+                uint8_t level = 0;
+                uint64_t ts = 0;
+                if (!get(in, level) || !get(in, ts) || !getString(in, payload)) return fail("truncated text record");
+                prefix.append(line, static_cast<LogLevel>(level), ts);
+                line += payload;
+                break;
+            }
+            default:
+                return fail("unknown record tag " + std::to_string(static_cast<int>(tag)));
+        }
+        line += '\n';
+        out.write(line.data(), static_cast<std::streamsize>(line.size()));
+    }
+    return true;
+}
+
+}  // namespace binlog
@@ -0,0 +1,143 @@
+#ifndef LOGFORMAT_H
+#define LOGFORMAT_H
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Log levels
+enum class LogLevel {
+    DEBUG,
+    INFO,
+    WARNING,
+    ERROR
+};
+
+const char* logLevelName(LogLevel level);
+
+// Type of one deferred-format argument. Stored once per call site; the hot
+// path only copies the raw values.
+enum class LogArgType : uint8_t {
+    I64 = 1,
+    U64 = 2,
+    F64 = 3,
+    BOOL = 4,
+    CHAR = 5,
+    STRING = 6,  // uint16 length followed by the bytes
+};
+
+// Everything known about a call site at registration time
+struct LogSiteInfo {
+    LogLevel level;
+    std::string file;
+    int line;
+    std::string fmt;
+    std::vector<LogArgType> types;
+};
+
+template <typename T>
+inline constexpr bool kLogArgUnsupported = false;
+
+// Raw encoding of one argument type (native byte order)
+template <typename T>
+struct LogArg {
+    static constexpr LogArgType type = [] {
+        if constexpr (std::is_same_v<T, bool>) return LogArgType::BOOL;
+        else if constexpr (std::is_same_v<T, char>) return LogArgType::CHAR;
+        else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) return LogArgType::I64;
+        else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) return LogArgType::U64;
+        else if constexpr (std::is_floating_point_v<T>) return LogArgType::F64;
+        else if constexpr (std::is_same_v<T, const char*> || std::is_same_v<T, std::string> ||
+                           std::is_same_v<T, std::string_view>)
+            return LogArgType::STRING;
+        else static_assert(kLogArgUnsupported<T>, "Unsupported deferred log argument type");
+    }();
+
+    static size_t size(const T& v) {
+        if constexpr (type == LogArgType::STRING) return sizeof(uint16_t) + view(v).size();
+        else if constexpr (type == LogArgType::BOOL || type == LogArgType::CHAR) return 1;
+        else return 8;
+    }
+
+    static uint8_t* encode(uint8_t* dst, const T& v) {
+        if constexpr (type == LogArgType::STRING) {
+            std::string_view s = view(v);
+            uint16_t len = static_cast<uint16_t>(s.size());
+            std::memcpy(dst, &len, sizeof(len));
+            std::memcpy(dst + sizeof(len), s.data(), len);
+            return dst + sizeof(len) + len;
+        } else if constexpr (type == LogArgType::BOOL || type == LogArgType::CHAR) {
+            *dst = static_cast<uint8_t>(v);
+            return dst + 1;
+        } else {
+            using Wide = std::conditional_t<type == LogArgType::I64, int64_t,
+                         std::conditional_t<type == LogArgType::U64, uint64_t, double>>;
+            Wide w = static_cast<Wide>(v);
+            std::memcpy(dst, &w, sizeof(w));
+            return dst + sizeof(w);
+        }
+    }
+
+   private:
+    static std::string_view view(const T& v) {
+        std::string_view s;
+        if constexpr (std::is_pointer_v<T>) s = v ? std::string_view(v) : std::string_view("(null)");
+        else s = std::string_view(v);
+        return s.substr(0, UINT16_MAX);
+    }
+};
+
+// Encoder for an argument as passed to a log call (arrays and char* decay to const char*)
+template <typename T>
+using LogArgFor = LogArg<std::conditional_t<std::is_same_v<std::decay_t<T>, char*>, const char*, std::decay_t<T>>>;
+
+// Format `fmt` (std::format syntax) with arguments encoded by LogArg and
+// append the result to `out`. Returns false if the data doesn't match the types.
+bool formatLogArgs(std::string& out, std::string_view fmt, const std::vector<LogArgType>& types,
+                   const uint8_t* data, size_t len);
+
+// Appends "[LEVEL][YYYY-mm-dd HH:MM:SS] " and caches the formatted second,
+// since consecutive lines almost always share it
+class LogLinePrefix {
+   public:
+    void append(std::string& out, LogLevel level, uint64_t timestamp_ns);
+
+   private:
+    std::string time_;
+    int64_t time_sec_ = -1;
+};
+
+/*
+ * Binary log file layout (native byte order, no padding):
+ *   file header: "HFTBLOG1"
+ *   SITE  : tag u8 | site_id u32 | level u8 | line u32 | nargs u8 | types[nargs]
+ *           | file_len u16 | file | fmt_len u16 | fmt
+ *   EVENT : tag u8 | site_id u32 | timestamp_ns u64 | len u16 | raw args[len]
+ *   TEXT  : tag u8 | level u8 | timestamp_ns u64 | len u16 | message[len]
+ * A SITE record always precedes the first EVENT that references it within
+ * the same file, so every file decodes on its own.
+ */
+namespace binlog {
+inline constexpr char kMagic[8] = {'H', 'F', 'T', 'B', 'L', 'O', 'G', '1'};
+
+enum class RecordTag : uint8_t {
+    SITE = 1,
+    EVENT = 2,
+    TEXT = 3,
+};
+
+void appendSite(std::string& out, uint32_t site_id, const LogSiteInfo& site);
+void appendEvent(std::string& out, uint32_t site_id, uint64_t timestamp_ns, const uint8_t* args, uint16_t len);
+void appendText(std::string& out, LogLevel level, uint64_t timestamp_ns, const char* msg, uint16_t len);
+
+// Expand a binary log into text lines. Returns false on a malformed file,
+// with a description in `error` when provided.
+bool decode(std::istream& in, std::ostream& out, std::string* error = nullptr);
+}  // namespace binlog
+
+#endif  // LOGFORMAT_H
@@ -0,0 +1,119 @@
+#ifndef LOGRING_H
+#define LOGRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Kinds of records stored in a LogRing
+enum class LogRecordKind : uint8_t {
+    PAD = 0,     // Filler up to the end of the buffer, skipped by the consumer
+    TEXT = 1,    // Preformatted message bytes
+    FORMAT = 2,  // Call site id (uint32) followed by raw arguments, see LogFormat.h
+};
+
+struct LogRecordHeader {
+    uint32_t size;          // Total record bytes including this header (aligned)
+    LogRecordKind kind;
+    uint8_t level;          // LogLevel
+    uint16_t length;        // Payload bytes following the header (unaligned)
+    uint64_t timestamp;     // TscClock ticks at the log call
+};
+static_assert(sizeof(LogRecordHeader) == 16);
+
+// Single-producer/single-consumer byte ring used by Logger. Each logging
+// thread owns one: it claims contiguous space for a record, fills it in place
+// and publishes it with a single release store. The logger thread walks the
+// published records in place and releases them in bulk.
+//
+// Records are 16-byte aligned and never wrap. When a record doesn't fit
+// before the end of the buffer the producer fills the tail with a PAD record
+// and continues at offset 0.
+class LogRing {
+   public:
+    static constexpr size_t kAlign = sizeof(LogRecordHeader);
+
+    explicit LogRing(size_t capacity) {
+        size_t cap = 1024;
+        while (cap < capacity) cap <<= 1;
+        capacity_ = cap;
+        chunks_ = std::make_unique<Chunk[]>(cap / kAlign);
+        buf_ = reinterpret_cast<uint8_t*>(chunks_.get());
+    }
+
+    LogRing(const LogRing&) = delete;
+    LogRing& operator=(const LogRing&) = delete;
+
+    static constexpr size_t aligned(size_t bytes) noexcept { return (bytes + kAlign - 1) & ~(kAlign - 1); }
+
+    // Largest record a producer may claim
+    size_t max_record() const noexcept { return capacity_ / 4; }
+
+    // Producer: reserve `bytes` (rounded up to kAlign) of contiguous space.
+    // Returns nullptr when the consumer hasn't freed enough room yet.
+    uint8_t* claim(size_t bytes) noexcept {
+        bytes = aligned(bytes);
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t offset = tail & (capacity_ - 1);
+        const size_t pad = offset + bytes > capacity_ ? capacity_ - offset : 0;
+        if (tail + pad + bytes - cached_head_ > capacity_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail + pad + bytes - cached_head_ > capacity_) return nullptr;
+        }
+        if (pad != 0) {
+            auto* filler = reinterpret_cast<LogRecordHeader*>(buf_ + offset);
+            filler->size = static_cast<uint32_t>(pad);
+            filler->kind = LogRecordKind::PAD;
+        }
+        pending_tail_ = tail + pad + bytes;
+        return buf_ + ((tail + pad) & (capacity_ - 1));
+    }
+
+    // Producer: make the last claimed record visible to the consumer
+    void publish() noexcept { tail_.store(pending_tail_, std::memory_order_release); }
+
+    // Consumer: invoke f(header, payload) for every published record, then
+    // release them all. Returns the number of non-padding records seen.
+    template <typename F>
+    size_t consume(F&& f) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        size_t count = 0;
+        while (head != tail) {
+            const auto* hdr = reinterpret_cast<const LogRecordHeader*>(buf_ + (head & (capacity_ - 1)));
+            if (hdr->kind != LogRecordKind::PAD) {
+                f(*hdr, reinterpret_cast<const uint8_t*>(hdr + 1));
+                ++count;
+            }
+            head += hdr->size;
+        }
+        head_.store(head, std::memory_order_release);
+        return count;
+    }
+
+    bool empty() const noexcept {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+   private:
+    static constexpr size_t kCacheLine = 64;
+
+    struct alignas(kAlign) Chunk {
+        uint8_t bytes[kAlign];
+    };
+
+    std::unique_ptr<Chunk[]> chunks_;
+    uint8_t* buf_;
+    size_t capacity_;
+
+    // Consumer owned
+    alignas(kCacheLine) std::atomic<size_t> head_{0};
+
+    // Producer owned
+    alignas(kCacheLine) std::atomic<size_t> tail_{0};
+    size_t cached_head_{0};
+    size_t pending_tail_{0};
+};
+
+#endif  // LOGRING_H
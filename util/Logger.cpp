@@ -1,7 +1,14 @@
 #include "Logger.h"
+#include <algorithm>
 #include <chrono>
-#include <iomanip>
-#include <sstream>
+#include <cstring>
+#include <ctime>
+
+namespace {
+constexpr size_t kBatchFlushBytes = 64 * 1024;  // Write to the sinks once this much is buffered
+constexpr std::chrono::microseconds kMaxIdleSleep{500};
+constexpr uint64_t kFileSyncIntervalNs = 1'000'000'000;  // msync/rotation check period
+}  // namespace
 
 Logger& Logger::getInstance() {
     static Logger instance;
@@ -11,25 +18,54 @@ Logger& Logger::getInstance() {
 Logger::Logger() {
     num_logged = 0;
     file_enabled_ = false;
-    if (file_enabled_) {
-        file_stream_.open(log_file_, std::ios::app);
-    }
+    batch_.reserve(2 * kBatchFlushBytes);
+    binary_batch_.reserve(2 * kBatchFlushBytes);
+    running_.store(true);
+    worker_ = std::thread(&Logger::run, this);
 }
 
 Logger::~Logger() {
-    if (file_stream_.is_open()) {
-        file_stream_.close();
+    running_.store(false);
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    file_sink_.close();
+    if (binary_stream_.is_open()) {
+        binary_stream_.close();
+    }
+}
+
+void Logger::openFileSink() {
+    if (file_sink_.open(log_file_, file_segment_bytes_, file_max_age_ns_)) {
+        file_sink_failed_ = false;
+    } else {
+        reportFileSinkError();
     }
 }
 
+// Once per failure, so a broken sink doesn't drop lines unnoticed
+void Logger::reportFileSinkError() {
+    if (file_sink_failed_) return;
+    file_sink_failed_ = true;
+    std::cerr << "Logger: can't write " << log_file_ << ": " << std::strerror(file_sink_.error())
+              << "; file logging paused until it can be reopened" << std::endl;
+}
+
 void Logger::setLogFile(const std::string& filename) {
     std::lock_guard<std::mutex> lock(mutex_);
     log_file_ = filename;
-    if (file_stream_.is_open()) {
-        file_stream_.close();
-    }
+    file_sink_.close();
     if (file_enabled_) {
-        file_stream_.open(log_file_, std::ios::app);
+        openFileSink();
+    }
+}
+
+void Logger::setFileRotation(size_t segment_bytes, std::chrono::seconds max_age) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_segment_bytes_ = segment_bytes;
+    file_max_age_ns_ = static_cast<uint64_t>(std::chrono::nanoseconds(max_age).count());
+    if (file_sink_.is_open()) {
+        openFileSink();  // Continues the current segment with the new limits
     }
 }
 
@@ -41,20 +77,45 @@ void Logger::enableConsole(bool enable) {
 void Logger::enableFile(bool enable) {
     std::lock_guard<std::mutex> lock(mutex_);
     file_enabled_ = enable;
-    if (file_enabled_ && !file_stream_.is_open()) {
-        file_stream_.open(log_file_, std::ios::app);
-    } else if (!file_enabled_ && file_stream_.is_open()) {
-        file_stream_.close();
+    if (file_enabled_ && !file_sink_.is_open()) {
+        openFileSink();
+    } else if (!file_enabled_ && file_sink_.is_open()) {
+        file_sink_.close();
+    }
+}
+
+void Logger::setBinaryLogFile(const std::string& filename) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        binary_file_ = filename;
+    }
+    binary_config_version_.fetch_add(1, std::memory_order_release);
+    flush();  // Returns once the logger thread has switched files
+}
+
+void Logger::enableBinary(bool enable) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        binary_enabled_ = enable;
     }
+    binary_config_version_.fetch_add(1, std::memory_order_release);
+    flush();
 }
 
 void Logger::setLogLevel(LogLevel level) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    min_level_ = level;
+    min_level_.store(level, std::memory_order_relaxed);
+}
+
+void Logger::setOverflowPolicy(LogOverflowPolicy policy) {
+    overflow_policy_.store(policy, std::memory_order_relaxed);
+}
+
+void Logger::setThreadBufferSize(size_t bytes) {
+    thread_buffer_size_.store(bytes, std::memory_order_relaxed);
 }
 
 void Logger::log(LogLevel level, const std::string& msg) {
-    if (level < min_level_) return;
+    if (!isEnabled(level)) return;
     logImpl(level, msg);
 }
 
@@ -71,33 +132,257 @@ void Logger::error(const std::string& msg) {
     log(LogLevel::ERROR, msg);
 }
 
+uint64_t Logger::droppedCount() const {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    uint64_t total = dropped_retired_;
+    for (const auto& buf : buffers_) {
+        total += buf->dropped.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+Logger::ThreadBuffer& Logger::localBuffer() {
+    // Keeps the ring alive while this thread logs and retires it on thread exit
+    struct Handle {
+        std::shared_ptr<ThreadBuffer> buf;
+        ~Handle() {
+            if (buf) buf->retired.store(true, std::memory_order_release);
+        }
+    };
+    thread_local Handle handle;
+    if (!handle.buf) {
+        handle.buf = std::make_shared<ThreadBuffer>(thread_buffer_size_.load(std::memory_order_relaxed));
+        std::lock_guard<std::mutex> lock(registry_mutex_);
+        buffers_.push_back(handle.buf);
+    }
+    return *handle.buf;
+}
+
+uint8_t* Logger::claimRecord(ThreadBuffer& buf, size_t bytes) {
+    uint8_t* rec = buf.ring.claim(bytes);
+    if (rec != nullptr) return rec;
+    if (overflow_policy_.load(std::memory_order_relaxed) == LogOverflowPolicy::BLOCK) {
+        while (running_.load(std::memory_order_relaxed)) {
+            std::this_thread::yield();
+            if ((rec = buf.ring.claim(bytes)) != nullptr) return rec;
+        }
+    }
+    buf.dropped.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
 void Logger::logImpl(LogLevel level, const std::string& msg) {
+    ThreadBuffer& buf = localBuffer();
+    const size_t max_len = std::min<size_t>(buf.ring.max_record() - sizeof(LogRecordHeader), UINT16_MAX);
+    const size_t len = std::min(msg.size(), max_len);
+
+    uint8_t* rec = claimRecord(buf, sizeof(LogRecordHeader) + len);
+    if (rec == nullptr) return;
+
+    auto* hdr = reinterpret_cast<LogRecordHeader*>(rec);
+    hdr->size = static_cast<uint32_t>(LogRing::aligned(sizeof(LogRecordHeader) + len));
+    hdr->kind = LogRecordKind::TEXT;
+    hdr->level = static_cast<uint8_t>(level);
+    hdr->length = static_cast<uint16_t>(len);
+    hdr->timestamp = TscClock::now();
+    std::memcpy(rec + sizeof(LogRecordHeader), msg.data(), len);
+    buf.ring.publish();
+}
+
+uint32_t Logger::registerSite(LogSiteId& site, LogLevel level, const char* file, int line, const char* fmt,
+                              std::initializer_list<LogArgType> types) {
+    std::lock_guard<std::mutex> lock(sites_mutex_);
+    uint32_t id = site.id.load(std::memory_order_relaxed);
+    if (id != 0) return id;  // Another thread registered it first
+    sites_.push_back(LogSiteInfo{level, file, line, fmt, types});
+    id = static_cast<uint32_t>(sites_.size());
+    site.id.store(id, std::memory_order_release);
+    return id;
+}
+
+void Logger::flush() {
+    if (!running_.load(std::memory_order_acquire)) return;
+    const uint64_t ticket = flush_requested_.fetch_add(1, std::memory_order_acq_rel) + 1;
+    while (flush_completed_.load(std::memory_order_acquire) < ticket &&
+           running_.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+void Logger::run() {
+    auto idle_sleep = std::chrono::microseconds(1);
+    uint64_t next_file_sync_ns = 0;
+    while (true) {
+        const bool stopping = !running_.load(std::memory_order_acquire);
+        const uint64_t flush_ticket = flush_requested_.load(std::memory_order_acquire);
+
+        size_t drained = drain();
+        writeBatch();
+        if (binary_config_version_.load(std::memory_order_acquire) != binary_config_applied_) {
+            applyBinaryConfig();
+        }
+        if (flush_ticket != flush_completed_.load(std::memory_order_relaxed)) {
+            {
+                // Text written to the mapped file is already visible to readers
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (binary_stream_.is_open()) binary_stream_.flush();
+            }
+            flush_completed_.store(flush_ticket, std::memory_order_release);
+        }
+        const uint64_t now_ns = TscClock::monotonicNs();
+        if (now_ns >= next_file_sync_ns) {
+            // Disk write-back happens here, never on a logging thread
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (file_enabled_ && !file_sink_.is_open()) {
+                // A rotation failed and closed it
+                reportFileSinkError();
+                openFileSink();
+            }
+            file_sink_.maybeRotate();
+            file_sink_.sync();
+            next_file_sync_ns = now_ns + kFileSyncIntervalNs;
+        }
+        if (stopping) break;
+
+        if (drained == 0) {
+            TscClock::maybeRecalibrate();
+            std::this_thread::sleep_for(idle_sleep);
+            idle_sleep = std::min(idle_sleep * 2, kMaxIdleSleep);
+        } else {
+            idle_sleep = std::chrono::microseconds(1);
+        }
+    }
+    // Unblock any flush() that raced with shutdown
+    flush_completed_.store(UINT64_MAX, std::memory_order_release);
+}
+
+// Runs on the logger thread, after the records queued under the old
+// configuration have been written
+void Logger::applyBinaryConfig() {
     std::lock_guard<std::mutex> lock(mutex_);
-    // Timestamp
-    auto now = std::chrono::system_clock::now();
-    auto in_time_t = std::chrono::system_clock::to_time_t(now);
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&in_time_t), "%Y-%m-%d %H:%M:%S");
-    // Log format: [LEVEL][timestamp] message
-    std::string log_line = "[" + levelToString(level) + "][" + ss.str() + "] " + msg + "\n";
-    
-    // buffer[num_logged] = log_line;
-    // num_logged = (num_logged + 1) % buffer.size();
-    if (console_enabled_) {
-        std::cout << log_line;
-    }
-    if (file_enabled_ && file_stream_.is_open()) {
-        file_stream_ << log_line;
-        file_stream_.flush();
-    }
-}
-
-std::string Logger::levelToString(LogLevel level) {
-    switch (level) {
-        case LogLevel::DEBUG: return "DEBUG";
-        case LogLevel::INFO: return "INFO";
-        case LogLevel::WARNING: return "WARNING";
-        case LogLevel::ERROR: return "ERROR";
-        default: return "UNKNOWN";
-    }
-}
\ No newline at end of file
+    binary_config_applied_ = binary_config_version_.load(std::memory_order_acquire);
+    if (binary_stream_.is_open()) {
+        binary_stream_.close();
+    }
+    binary_active_ = binary_enabled_;
+    binary_sites_written_.clear();
+    if (!binary_active_) return;
+
+    binary_stream_.open(binary_file_, std::ios::binary | std::ios::app);
+    if (binary_stream_.is_open() && binary_stream_.tellp() == 0) {
+        binary_stream_.write(binlog::kMagic, sizeof(binlog::kMagic));
+    }
+}
+
+size_t Logger::drain() {
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex_);
+        drain_list_.assign(buffers_.begin(), buffers_.end());
+    }
+
+    size_t total = 0;
+    uint64_t dropped = 0;
+    for (const auto& buf : drain_list_) {
+        // Read the retired flag first so a final message published right
+        // before thread exit is still drained below
+        const bool retired = buf->retired.load(std::memory_order_acquire);
+        total += buf->ring.consume([this](const LogRecordHeader& hdr, const uint8_t* payload) {
+            formatRecord(hdr, payload);
+            if (batch_.size() >= kBatchFlushBytes || binary_batch_.size() >= kBatchFlushBytes) writeBatch();
+        });
+        dropped += buf->dropped.load(std::memory_order_relaxed);
+        if (retired) {
+            std::lock_guard<std::mutex> lock(registry_mutex_);
+            dropped_retired_ += buf->dropped.load(std::memory_order_relaxed);
+            dropped -= buf->dropped.load(std::memory_order_relaxed);
+            buffers_.erase(std::remove(buffers_.begin(), buffers_.end(), buf), buffers_.end());
+        }
+    }
+
+    // Surface drops in the log itself
+    const uint64_t total_dropped = dropped + dropped_retired_;
+    if (total_dropped != dropped_logged_) {
+        std::string msg = "Logger dropped " + std::to_string(total_dropped - dropped_logged_) + " message(s)";
+        LogRecordHeader hdr{};
+        hdr.kind = LogRecordKind::TEXT;
+        hdr.level = static_cast<uint8_t>(LogLevel::WARNING);
+        hdr.length = static_cast<uint16_t>(msg.size());
+        hdr.timestamp = TscClock::now();
+        formatRecord(hdr, reinterpret_cast<const uint8_t*>(msg.data()));
+        dropped_logged_ = total_dropped;
+    }
+    return total;
+}
+
+void Logger::formatRecord(const LogRecordHeader& hdr, const uint8_t* payload) {
+    const LogLevel level = static_cast<LogLevel>(hdr.level);
+    num_logged++;
+
+    uint32_t site_id = 0;
+    const LogSiteInfo* site = nullptr;
+    if (hdr.kind == LogRecordKind::FORMAT) {
+        std::memcpy(&site_id, payload, sizeof(site_id));
+        site = lookupSite(site_id);
+        payload += sizeof(site_id);
+    }
+    const uint16_t len = hdr.kind == LogRecordKind::FORMAT ? hdr.length - sizeof(site_id) : hdr.length;
+    const uint64_t timestamp_ns = TscClock::toRealtimeNs(hdr.timestamp);
+
+    if (binary_active_) {
+        if (site == nullptr) {
+            binlog::appendText(binary_batch_, level, timestamp_ns, reinterpret_cast<const char*>(payload), len);
+            return;
+        }
+        if (site_id >= binary_sites_written_.size()) binary_sites_written_.resize(site_id + 1, false);
+        if (!binary_sites_written_[site_id]) {
+            binlog::appendSite(binary_batch_, site_id, *site);
+            binary_sites_written_[site_id] = true;
+        }
+        binlog::appendEvent(binary_batch_, site_id, timestamp_ns, payload, len);
+        return;
+    }
+
+    prefix_.append(batch_, level, timestamp_ns);
+    if (hdr.kind == LogRecordKind::FORMAT) {
+        if (site == nullptr || !formatLogArgs(batch_, site->fmt, site->types, payload, len)) {
+            batch_ += "<malformed log record>";
+        }
+    } else {
+        batch_.append(reinterpret_cast<const char*>(payload), len);
+    }
+    batch_ += '\n';
+}
+
+const LogSiteInfo* Logger::lookupSite(uint32_t id) {
+    if (id == 0) return nullptr;
+    if (id > site_cache_.size()) {
+        // Registered after our last snapshot; deque elements never move
+        std::lock_guard<std::mutex> lock(sites_mutex_);
+        for (size_t i = site_cache_.size(); i < sites_.size(); ++i) {
+            site_cache_.push_back(&sites_[i]);
+        }
+        if (id > site_cache_.size()) return nullptr;
+    }
+    return site_cache_[id - 1];
+}
+
+void Logger::writeBatch() {
+    if (batch_.empty() && binary_batch_.empty()) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!batch_.empty()) {
+        if (console_enabled_) {
+            std::cout.write(batch_.data(), static_cast<std::streamsize>(batch_.size()));
+            std::cout.flush();
+        }
+        if (file_enabled_) {
+            file_sink_.write(batch_.data(), batch_.size());
+        }
+        batch_.clear();
+    }
+    if (!binary_batch_.empty()) {
+        if (binary_stream_.is_open()) {
+            binary_stream_.write(binary_batch_.data(), static_cast<std::streamsize>(binary_batch_.size()));
+        }
+        binary_batch_.clear();
+    }
+}
@@ -7,15 +7,51 @@
 #include <memory>
 #include <iostream>
 #include <atomic>
+#include <chrono>
+#include <deque>
+#include <initializer_list>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
-// Log levels
-enum class LogLevel {
-    DEBUG,
-    INFO,
-    WARNING,
-    ERROR
+#include "LogFormat.h"
+#include "LogRing.h"
+#include "MappedLogFile.h"
+#include "TscClock.h"
+
+// What a logging thread does when its ring is full
+enum class LogOverflowPolicy {
+    DROP,   // Discard the message and count it
+    BLOCK   // Spin until the logger thread frees space
+};
+
+// HFT_LOG calls below this level are removed at compile time
+// (0 = DEBUG, 1 = INFO, 2 = WARNING, 3 = ERROR, 4 = none)
+#ifndef HFT_LOG_MIN_LEVEL
+#define HFT_LOG_MIN_LEVEL 0
+#endif
+
+constexpr bool logLevelCompiledIn(LogLevel level) {
+    return static_cast<int>(level) >= HFT_LOG_MIN_LEVEL;
+}
+
+// Registration slot for one HFT_LOG call site (0 = not registered yet)
+struct LogSiteId {
+    std::atomic<uint32_t> id{0};
 };
 
+/*
+ * Asynchronous logger.
+ * The calling thread only copies the level, a raw TSC timestamp and the message bytes
+ * into its own lock-free ring. A dedicated logger thread drains every ring,
+ * formats the lines and writes them to the sinks in large blocks. The file
+ * sink is a memory-mapped segment that the logger thread syncs and rotates.
+ *
+ * Messages logged through HFT_LOG are not formatted at the call site at all:
+ * the ring record holds the call site id and the raw arguments. In binary
+ * mode the logger thread writes those records to the binary log unchanged and
+ * hft_logdecode expands them offline.
+ */
 class Logger {
 public:
     // Get the singleton instance
@@ -24,13 +60,35 @@ public:
     // Set log file path (default: hft_sim.log)
     void setLogFile(const std::string& filename);
 
+    // Size of a preallocated log file segment (default 64 MiB) and the age
+    // after which a non-empty segment is rotated (0 = size only). Rotated
+    // segments are renamed to "<log file>.<YYYYmmdd-HHMMSS>-<n>".
+    void setFileRotation(size_t segment_bytes, std::chrono::seconds max_age = std::chrono::seconds{0});
+
     // Enable/disable console/file sinks
     void enableConsole(bool enable);
     void enableFile(bool enable);
 
+    // Binary log sink (default: hft_sim.blog). While enabled, every record
+    // goes to the binary log instead of the console/file sinks.
+    void setBinaryLogFile(const std::string& filename);
+    void enableBinary(bool enable);
+
     // Set minimum log level
     void setLogLevel(LogLevel level);
 
+    // Runtime level check without going through the singleton. HFT_LOG tests
+    // this before evaluating any of its arguments.
+    static bool isEnabled(LogLevel level) noexcept {
+        return level >= min_level_.load(std::memory_order_relaxed);
+    }
+
+    // Full-ring behaviour for all threads (default: DROP)
+    void setOverflowPolicy(LogOverflowPolicy policy);
+
+    // Ring size in bytes for threads that log for the first time after this call
+    void setThreadBufferSize(size_t bytes);
+
     // Logging methods
     void log(LogLevel level, const std::string& msg);
     void debug(const std::string& msg);
@@ -38,6 +96,19 @@ public:
     void warning(const std::string& msg);
     void error(const std::string& msg);
 
+    // Deferred-format logging, normally used through HFT_LOG. `fmt` uses
+    // std::format syntax and must outlive the program (a string literal).
+    template <typename... Args>
+    void logFormat(LogSiteId& site, LogLevel level, const char* file, int line, const char* fmt,
+                   const Args&... args);
+
+    // Block until everything logged before the call has reached the sinks.
+    // Lock-free on the caller side so it can be used on shutdown/crash paths.
+    void flush();
+
+    // Messages discarded by the DROP policy since startup
+    uint64_t droppedCount() const;
+
     // Deleted copy/move
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
@@ -46,24 +117,125 @@ private:
     Logger();
     ~Logger();
 
+    // Per-thread ring, shared between the owning thread and the logger thread
+    struct ThreadBuffer {
+        explicit ThreadBuffer(size_t bytes) : ring(bytes) {}
+        LogRing ring;
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<bool> retired{false};  // Owning thread has exited
+    };
+
     void logImpl(LogLevel level, const std::string& msg);
-    std::string levelToString(LogLevel level);
+    void openFileSink();
+    void reportFileSinkError();
+
+    ThreadBuffer& localBuffer();
+    uint8_t* claimRecord(ThreadBuffer& buf, size_t bytes);
+    uint32_t registerSite(LogSiteId& site, LogLevel level, const char* file, int line, const char* fmt,
+                          std::initializer_list<LogArgType> types);
 
-    
-    std::ofstream file_stream_;
-    std::mutex mutex_;
+    // Logger thread
+    void run();
+    void applyBinaryConfig();
+    size_t drain();
+    void formatRecord(const LogRecordHeader& hdr, const uint8_t* payload);
+    const LogSiteInfo* lookupSite(uint32_t id);
+    void writeBatch();
+
+    MappedLogFile file_sink_;
+    std::mutex mutex_;                  // Guards sinks and their configuration
     size_t num_logged;
     std::string log_file_ = "hft_sim.log";
     bool console_enabled_ = true;
     bool file_enabled_;
-    LogLevel min_level_ = LogLevel::DEBUG;
+    bool file_sink_failed_ = false;     // Reported on stderr; cleared once the sink reopens
+    size_t file_segment_bytes_ = 64u << 20;
+    uint64_t file_max_age_ns_ = 0;
+    static inline std::atomic<LogLevel> min_level_{LogLevel::DEBUG};
+    std::atomic<LogOverflowPolicy> overflow_policy_{LogOverflowPolicy::DROP};
+    std::atomic<size_t> thread_buffer_size_{1u << 20};
+
+    mutable std::mutex registry_mutex_; // Guards buffers_ and dropped_retired_
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+    uint64_t dropped_retired_ = 0;      // Drops counted by threads that have exited
+
+    std::mutex sites_mutex_;            // Guards sites_ (registration only)
+    std::deque<LogSiteInfo> sites_;     // Site id N is sites_[N - 1]
+
+    // Binary sink configuration, applied by the logger thread
+    std::string binary_file_ = "hft_sim.blog";
+    bool binary_enabled_ = false;
+    std::atomic<uint64_t> binary_config_version_{0};
+
+    // Logger thread state
+    std::vector<std::shared_ptr<ThreadBuffer>> drain_list_;  // Snapshot of buffers_
+    std::vector<const LogSiteInfo*> site_cache_;              // Snapshot of sites_
+    std::string batch_;                 // Formatted text awaiting a sink write
+    std::string binary_batch_;          // Binary records awaiting a sink write
+    LogLinePrefix prefix_;
+    uint64_t dropped_logged_ = 0;       // Drops already reported in the log
+    std::ofstream binary_stream_;
+    bool binary_active_ = false;
+    uint64_t binary_config_applied_ = 0;
+    std::vector<bool> binary_sites_written_;  // SITE record already in the current binary file
+
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> flush_requested_{0};
+    std::atomic<uint64_t> flush_completed_{0};
+    std::thread worker_;
 };
 
-/*
- * NOTE: For high-performance (HFT) scenarios, I might upgrade to an asynchronous logger:
- * - Lock-free queue for log messages
- * - Have a dedicated logging thread to flush messages to sinks
- * - Support batching and configurable sinks
- */
+template <typename... Args>
+void Logger::logFormat(LogSiteId& site, LogLevel level, const char* file, int line, const char* fmt,
+                       const Args&... args) {
+    if (!isEnabled(level)) return;
+    uint32_t id = site.id.load(std::memory_order_acquire);
+    if (id == 0) {
+        id = registerSite(site, level, file, line, fmt, {LogArgFor<Args>::type...});
+    }
+
+    ThreadBuffer& buf = localBuffer();
+    const size_t len = sizeof(id) + (size_t{0} + ... + LogArgFor<Args>::size(args));
+    if (len > UINT16_MAX || sizeof(LogRecordHeader) + len > buf.ring.max_record()) {
+        buf.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    uint8_t* rec = claimRecord(buf, sizeof(LogRecordHeader) + len);
+    if (rec == nullptr) return;
+
+    auto* hdr = reinterpret_cast<LogRecordHeader*>(rec);
+    hdr->size = static_cast<uint32_t>(LogRing::aligned(sizeof(LogRecordHeader) + len));
+    hdr->kind = LogRecordKind::FORMAT;
+    hdr->level = static_cast<uint8_t>(level);
+    hdr->length = static_cast<uint16_t>(len);
+    hdr->timestamp = TscClock::now();
+    uint8_t* p = rec + sizeof(LogRecordHeader);
+    std::memcpy(p, &id, sizeof(id));
+    p += sizeof(id);
+    ((p = LogArgFor<Args>::encode(p, args)), ...);
+    buf.ring.publish();
+}
+
+// Deferred-format logging. The format string (std::format syntax) and the
+// argument types are registered once per call site; each call only copies the
+// raw argument values into the calling thread's ring.
+//
+// `level` must be a constant. Calls below HFT_LOG_MIN_LEVEL generate no code,
+// and calls below the runtime level don't evaluate their arguments.
+#define HFT_LOG(level, fmt, ...)                                                          \
+    do {                                                                                   \
+        if constexpr (logLevelCompiledIn(level)) {                                         \
+            if (Logger::isEnabled(level)) {                                                \
+                static LogSiteId hft_log_site_;                                            \
+                Logger::getInstance().logFormat(hft_log_site_, level, __FILE__, __LINE__,  \
+                                                fmt __VA_OPT__(, ) __VA_ARGS__);           \
+            }                                                                              \
+        }                                                                                  \
+    } while (0)
+
+#define HFT_LOG_DEBUG(fmt, ...) HFT_LOG(LogLevel::DEBUG, fmt __VA_OPT__(, ) __VA_ARGS__)
+#define HFT_LOG_INFO(fmt, ...) HFT_LOG(LogLevel::INFO, fmt __VA_OPT__(, ) __VA_ARGS__)
+#define HFT_LOG_WARNING(fmt, ...) HFT_LOG(LogLevel::WARNING, fmt __VA_OPT__(, ) __VA_ARGS__)
+#define HFT_LOG_ERROR(fmt, ...) HFT_LOG(LogLevel::ERROR, fmt __VA_OPT__(, ) __VA_ARGS__)
 
-#endif // LOGGER_H 
\ No newline at end of file
+#endif // LOGGER_H
\ No newline at end of file
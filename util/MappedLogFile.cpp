@@ -0,0 +1,153 @@
+#include "MappedLogFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include "TscClock.h"
+
+namespace {
+size_t pageSize() {
+    static const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return page;
+}
+
+size_t roundUpToPage(size_t bytes) {
+    const size_t page = pageSize();
+    return (bytes + page - 1) / page * page;
+}
+}  // namespace
+
+bool MappedLogFile::open(const std::string& path, size_t segment_bytes, uint64_t max_age_ns) {
+    close();
+    path_ = path;
+    segment_bytes_ = roundUpToPage(std::max(segment_bytes, pageSize()));
+    max_age_ns_ = max_age_ns;
+    error_ = 0;
+    return mapSegment();
+}
+
+bool MappedLogFile::mapSegment() {
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        error_ = errno;
+        return false;
+    }
+
+    struct stat st{};
+    if (fstat(fd_, &st) != 0) {
+        error_ = errno;
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    const size_t existing = static_cast<size_t>(st.st_size);
+    capacity_ = std::max(segment_bytes_, roundUpToPage(existing));
+
+    // Reserve the blocks up front so stores into the mapping never hit ENOSPC
+    // (SIGBUS) or allocate on the page fault path. Not every filesystem
+    // supports it; ftruncate still gives a correctly sized sparse file.
+    if (posix_fallocate(fd_, 0, static_cast<off_t>(capacity_)) != 0 &&
+        ftruncate(fd_, static_cast<off_t>(capacity_)) != 0) {
+        error_ = errno;
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    void* p = mmap(nullptr, capacity_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (p == MAP_FAILED) {
+        error_ = errno;
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    base_ = static_cast<char*>(p);
+    madvise(base_, capacity_, MADV_SEQUENTIAL);
+
+    // Continue after the existing text, skipping preallocated zeros
+    used_ = existing;
+    while (used_ > 0 && base_[used_ - 1] == '\0') --used_;
+    synced_ = used_;
+    opened_ns_ = TscClock::monotonicNs();
+    return true;
+}
+
+void MappedLogFile::write(const char* data, size_t len) {
+    if (base_ == nullptr) return;
+    // Keep a batch in one segment unless it is larger than a whole segment
+    if (used_ > 0 && used_ + len > capacity_ && !rotate()) return;
+    while (len > 0) {
+        if (used_ == capacity_ && !rotate()) return;
+        const size_t n = std::min(len, capacity_ - used_);
+        std::memcpy(base_ + used_, data, n);
+        used_ += n;
+        data += n;
+        len -= n;
+    }
+}
+
+void MappedLogFile::maybeRotate() {
+    if (base_ == nullptr || max_age_ns_ == 0 || used_ == 0) return;
+    if (TscClock::monotonicNs() - opened_ns_ >= max_age_ns_) rotate();
+}
+
+void MappedLogFile::sync() {
+    if (base_ == nullptr || used_ == synced_) return;
+    const size_t start = synced_ & ~(pageSize() - 1);
+    msync(base_ + start, used_ - start, MS_SYNC);
+    synced_ = used_;
+}
+
+void MappedLogFile::close() {
+    if (base_ != nullptr) finishSegment();
+}
+
+void MappedLogFile::finishSegment() {
+    sync();
+    munmap(base_, capacity_);
+    base_ = nullptr;
+    // Drop the unused preallocated tail so readers see only the text
+    if (ftruncate(fd_, static_cast<off_t>(used_)) != 0) {
+        // Nothing useful to do; the tail is just zeros
+    }
+    ::close(fd_);
+    fd_ = -1;
+    capacity_ = used_ = synced_ = 0;
+}
+
+bool MappedLogFile::rotate() {
+    finishSegment();
+
+    std::time_t t = std::time(nullptr);
+    std::tm tm{};
+    localtime_r(&t, &tm);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &tm);
+    // link() fails rather than replace a segment rotated earlier in the same
+    // second, by this process or by one before a restart
+    for (unsigned long long n = rotations_;; ++n) {
+        char suffix[24];
+        std::snprintf(suffix, sizeof(suffix), "-%06llu", n);
+        const std::string rotated = path_ + "." + stamp + suffix;
+        if (::link(path_.c_str(), rotated.c_str()) == 0) break;
+        if (errno != EEXIST) {
+            error_ = errno;
+            return false;
+        }
+    }
+    if (::unlink(path_.c_str()) != 0) {
+        error_ = errno;
+        return false;
+    }
+    ++rotations_;
+
+    return mapSegment();
+}
@@ -0,0 +1,73 @@
+#ifndef MAPPEDLOGFILE_H
+#define MAPPEDLOGFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+ * Text log sink backed by a preallocated, memory-mapped segment.
+ *
+ * write() is a memcpy into the mapping; the kernel sees no write() calls and
+ * no file growth until a segment fills up. A full (or expired) segment is
+ * synced, trimmed to its used length and moved to "<path>.<time>-<n>", n
+ * being the first number free for that second, so a restart never replaces
+ * an earlier segment; then a fresh segment is mapped at <path>. If that
+ * fails the file is closed (is_open() turns false, error() says why) and
+ * writes are dropped until it is opened again. Dirty pages are written back
+ * by sync(), which the owner calls on its own schedule.
+ *
+ * Not thread-safe: Logger only touches it from under its sink mutex.
+ */
+class MappedLogFile {
+   public:
+    MappedLogFile() = default;
+    ~MappedLogFile() { close(); }
+
+    MappedLogFile(const MappedLogFile&) = delete;
+    MappedLogFile& operator=(const MappedLogFile&) = delete;
+
+    // Open (or continue) the segment at `path`. Existing content is kept;
+    // trailing preallocated zeros left by an unclean shutdown are skipped.
+    // max_age_ns == 0 disables time based rotation.
+    bool open(const std::string& path, size_t segment_bytes, uint64_t max_age_ns = 0);
+    bool is_open() const noexcept { return base_ != nullptr; }
+
+    // Append bytes, rotating as many times as needed
+    void write(const char* data, size_t len);
+
+    // Rotate if the current segment is older than max_age_ns
+    void maybeRotate();
+
+    // Write back the pages dirtied since the last sync
+    void sync();
+
+    // Sync, unmap and trim the segment to its used length
+    void close();
+
+    const std::string& path() const noexcept { return path_; }
+    size_t size() const noexcept { return used_; }
+    uint64_t rotations() const noexcept { return rotations_; }
+    // errno of the last failure to open or rotate, 0 after a successful open()
+    int error() const noexcept { return error_; }
+
+   private:
+    bool mapSegment();
+    void finishSegment();
+    bool rotate();
+
+    std::string path_;
+    size_t segment_bytes_ = 0;
+    uint64_t max_age_ns_ = 0;
+
+    int fd_ = -1;
+    char* base_ = nullptr;
+    size_t capacity_ = 0;     // Mapped bytes
+    size_t used_ = 0;         // Bytes written
+    size_t synced_ = 0;       // Bytes known to be written back
+    uint64_t opened_ns_ = 0;  // CLOCK_MONOTONIC time the segment was mapped
+    uint64_t rotations_ = 0;
+    int error_ = 0;
+};
+
+#endif  // MAPPEDLOGFILE_H
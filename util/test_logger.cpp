@@ -1,6 +1,8 @@
 #include "Logger.h"
+#include <algorithm>
 #include <thread>
 #include <filesystem>
+#include <sstream>
 #include <vector>
 #include <gtest/gtest.h>
 
@@ -35,6 +37,7 @@ TEST_F(LoggingTest, SingleThreadedLogging) {
     logger.debug("This is a debug message");
     logger.warning("This is a warning message");
     logger.error("This is an error message");
+    logger.flush();
 
     // Check if the log file was created and contains expected messages
     std::ifstream log_file("test_logger.log");
@@ -49,3 +52,214 @@ TEST_F(LoggingTest, SingleThreadedLogging) {
     }
     ASSERT_TRUE(found_info);
 }
+
+
+TEST_F(LoggingTest, MultiThreadedLoggingIsComplete) {
+    Logger& logger = Logger::getInstance();
+    logger.enableConsole(false);
+    logger.setOverflowPolicy(LogOverflowPolicy::BLOCK);
+    const int num_threads = 4;
+    const int per_thread = 1000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&logger, t] {
+            for (int i = 0; i < per_thread; ++i) {
+                logger.info("mt-" + std::to_string(t) + "-" + std::to_string(i));
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    logger.flush();
+
+    std::ifstream log_file("test_logger.log");
+    ASSERT_TRUE(log_file.is_open());
+    std::string line;
+    int found = 0;
+    while (std::getline(log_file, line)) {
+        if (line.find("] mt-") != std::string::npos) found++;
+    }
+    EXPECT_EQ(found, num_threads * per_thread) << "BLOCK policy must not lose messages";
+    logger.setOverflowPolicy(LogOverflowPolicy::DROP);
+    logger.enableConsole(true);
+}
+
+TEST_F(LoggingTest, DropPolicyCountsDiscardedMessages) {
+    Logger& logger = Logger::getInstance();
+    logger.enableConsole(false);
+    logger.setOverflowPolicy(LogOverflowPolicy::DROP);
+    logger.setThreadBufferSize(1024);  // Only applies to threads created from now on
+
+    const uint64_t before = logger.droppedCount();
+    std::thread burst([&logger] {
+        std::string payload(200, 'x');
+        for (int i = 0; i < 10000; ++i) logger.info(payload);
+    });
+    burst.join();
+    logger.flush();
+
+    EXPECT_GT(logger.droppedCount(), before) << "A tiny ring under a burst should drop";
+    logger.setThreadBufferSize(1u << 20);
+    logger.enableConsole(true);
+}
+
+TEST_F(LoggingTest, DeferredFormatIsExpandedByLoggerThread) {
+    Logger& logger = Logger::getInstance();
+    HFT_LOG(LogLevel::INFO, "px={:.2f} qty={} sym={} ok={} side={}", 101.256, 42u, "AAPL", true, 'B');
+    logger.flush();
+
+    std::ifstream log_file("test_logger.log");
+    ASSERT_TRUE(log_file.is_open());
+    std::string line;
+    bool found = false;
+    while (std::getline(log_file, line)) {
+        if (line.find("[INFO]") == 0 && line.find("] px=101.26 qty=42 sym=AAPL ok=true side=B") != std::string::npos) {
+            found = true;
+        }
+    }
+    EXPECT_TRUE(found);
+}
+
+TEST_F(LoggingTest, DisabledLevelsSkipArgumentEvaluation) {
+    Logger& logger = Logger::getInstance();
+    int evaluated = 0;
+    auto expensive = [&evaluated] { return ++evaluated; };
+
+    logger.setLogLevel(LogLevel::WARNING);
+    EXPECT_FALSE(Logger::isEnabled(LogLevel::INFO));
+    HFT_LOG_DEBUG("debug {}", expensive());
+    HFT_LOG_INFO("info {}", expensive());
+    EXPECT_EQ(evaluated, 0) << "Arguments of filtered calls must not be evaluated";
+
+    HFT_LOG_WARNING("warning {}", expensive());
+    EXPECT_EQ(evaluated, logLevelCompiledIn(LogLevel::WARNING) ? 1 : 0);
+    logger.setLogLevel(LogLevel::DEBUG);
+}
+
+TEST_F(LoggingTest, BinaryModeRoundTripsThroughDecoder) {
+    Logger& logger = Logger::getInstance();
+    std::filesystem::remove("test_logger.blog");
+    logger.setBinaryLogFile("test_logger.blog");
+    logger.enableBinary(true);
+    for (int i = 0; i < 3; ++i) {
+        HFT_LOG(LogLevel::WARNING, "binary {} of {} ({})", i, 3, std::string("deferred"));
+    }
+    logger.error("plain text in binary mode");
+    logger.enableBinary(false);  // Flushes and closes the binary file
+
+    std::ifstream in("test_logger.blog", std::ios::binary);
+    ASSERT_TRUE(in.is_open());
+    std::stringstream decoded;
+    std::string error;
+    ASSERT_TRUE(binlog::decode(in, decoded, &error)) << error;
+
+    std::string text = decoded.str();
+    EXPECT_NE(text.find("[WARNING]"), std::string::npos);
+    EXPECT_NE(text.find("] binary 0 of 3 (deferred)"), std::string::npos);
+    EXPECT_NE(text.find("] binary 2 of 3 (deferred)"), std::string::npos);
+    EXPECT_NE(text.find("[ERROR]"), std::string::npos);
+    EXPECT_NE(text.find("] plain text in binary mode"), std::string::npos);
+
+    // Nothing logged in binary mode should have reached the text sink
+    std::ifstream log_file("test_logger.log");
+    std::string contents((std::istreambuf_iterator<char>(log_file)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(contents.find("binary 0 of 3"), std::string::npos);
+    std::filesystem::remove("test_logger.blog");
+}
+
+TEST(MappedLogFileTest, RotatesFullSegmentsAndTrimsOnClose) {
+    namespace fs = std::filesystem;
+    const fs::path dir = fs::temp_directory_path() / "hft_mapped_log_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const std::string path = (dir / "segments.log").string();
+
+    std::string expected;
+    {
+        MappedLogFile file;
+        ASSERT_TRUE(file.open(path, 4096));
+        EXPECT_EQ(fs::file_size(path), 4096u) << "Segment should be preallocated";
+        for (int i = 0; i < 200; ++i) {
+            std::string line = "line " + std::to_string(i) + " " + std::string(40, 'x') + "\n";
+            file.write(line.data(), line.size());
+            expected += line;
+        }
+        EXPECT_GT(file.rotations(), 0u);
+    }
+
+    // Rotated segments sort by name; the active segment holds the newest text
+    std::vector<fs::path> rotated;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        if (entry.path().filename() != "segments.log") rotated.push_back(entry.path());
+    }
+    std::sort(rotated.begin(), rotated.end());
+    rotated.push_back(path);
+
+    std::string contents;
+    for (const auto& segment : rotated) {
+        EXPECT_LE(fs::file_size(segment), 4096u);
+        std::ifstream in(segment);
+        contents.append(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    EXPECT_EQ(contents, expected) << "Closed segments must be trimmed and complete";
+
+    // Reopening continues after the existing text
+    {
+        MappedLogFile file;
+        ASSERT_TRUE(file.open(path, 1u << 20));
+        const size_t before = file.size();
+        file.write("tail\n", 5);
+        EXPECT_EQ(file.size(), before + 5);
+    }
+    std::ifstream in(path);
+    std::string active((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(active.substr(active.size() - 5), "tail\n");
+    fs::remove_all(dir);
+}
+
+TEST(MappedLogFileTest, RotationNeverReplacesAnEarlierSegment) {
+    namespace fs = std::filesystem;
+    const fs::path dir = fs::temp_directory_path() / "hft_mapped_log_restart_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const std::string path = (dir / "restart.log").string();
+
+    // Each run restarts the rotation count, as a restarted process does, and
+    // pushes the previous run's line out of the active segment within the
+    // same second or two
+    std::string expected;
+    for (int run = 0; run < 4; ++run) {
+        MappedLogFile file;
+        ASSERT_TRUE(file.open(path, 4096));
+        const std::string line = "run " + std::to_string(run) + " " + std::string(4000, 'x') + "\n";
+        file.write(line.data(), line.size());
+        EXPECT_EQ(file.rotations(), run == 0 ? 0u : 1u);
+        EXPECT_EQ(file.error(), 0);
+        expected += line;
+    }
+
+    std::vector<fs::path> segments;
+    for (const auto& entry : fs::directory_iterator(dir)) segments.push_back(entry.path());
+    EXPECT_EQ(segments.size(), 4u) << "Three rotated segments and the active one";
+    size_t bytes = 0;
+    for (const auto& segment : segments) bytes += fs::file_size(segment);
+    EXPECT_EQ(bytes, expected.size()) << "No rotated segment may be overwritten";
+    fs::remove_all(dir);
+}
+
+TEST(LogFormatTest, FormatsEncodedArguments) {
+    std::vector<uint8_t> data(64);
+    uint8_t* p = data.data();
+    p = LogArg<int>::encode(p, -7);
+    p = LogArg<double>::encode(p, 2.5);
+    p = LogArg<const char*>::encode(p, "x");
+    data.resize(p - data.data());
+
+    std::string out;
+    ASSERT_TRUE(formatLogArgs(out, "{{{}}} {1:.3f} {2} {0:>4}", {LogArgType::I64, LogArgType::F64, LogArgType::STRING},
+                              data.data(), data.size()));
+    EXPECT_EQ(out, "{-7} 2.500 x   -7");
+
+    out.clear();
+    EXPECT_FALSE(formatLogArgs(out, "{}", {LogArgType::U64}, data.data(), 3)) << "Short data must be rejected";
+}